@@ -1,11 +1,17 @@
 #include "FontDecompressor.h"
 
+#include <AllocTracker.h>
 #include <Logging.h>
+#include <MemoryBudget.h>
 
 #include <cstdlib>
 
 bool FontDecompressor::init() {
   clearCache();
+  if (budgetHandle < 0) {
+    // Groups are re-inflated on the next glyph lookup
+    budgetHandle = MemBudget.registerCache("font groups", MemoryBudget::Priority::Medium, [this] { freeAllEntries(); });
+  }
   return true;
 }
 
@@ -19,7 +25,11 @@ void FontDecompressor::freeAllEntries() {
   }
 }
 
-void FontDecompressor::deinit() { freeAllEntries(); }
+void FontDecompressor::deinit() {
+  MemBudget.unregisterCache(budgetHandle);
+  budgetHandle = -1;
+  freeAllEntries();
+}
 
 void FontDecompressor::clearCache() {
   freeAllEntries();
@@ -63,6 +73,7 @@ FontDecompressor::CacheEntry* FontDecompressor::findEvictionCandidate() {
 }
 
 bool FontDecompressor::decompressGroup(const EpdFontData* fontData, uint16_t groupIndex, CacheEntry* entry) {
+  ALLOC_TAG(Fonts);
   const EpdFontGroup& group = fontData->groups[groupIndex];
 
   // Free old buffer if reusing a slot
@@ -73,7 +84,8 @@ bool FontDecompressor::decompressGroup(const EpdFontData* fontData, uint16_t gro
   entry->valid = false;
 
   // Allocate output buffer
-  auto* outBuf = static_cast<uint8_t*>(malloc(group.uncompressedSize));
+  auto* outBuf =
+      static_cast<uint8_t*>(MemBudget.allocate("font group", group.uncompressedSize, MemoryBudget::Priority::Medium));
   if (!outBuf) {
     LOG_ERR("FDC", "Failed to allocate %u bytes for group %u", group.uncompressedSize, groupIndex);
     return false;
@@ -17,7 +17,9 @@ class FontDecompressor {
   void clearCache();
 
  private:
-  static constexpr uint8_t CACHE_SLOTS = 4;
+  // Enough for the groups of several styles on one page. Slots hold memory only once used, and the whole cache is
+  // given back when MemBudget needs room for a higher-priority buffer.
+  static constexpr uint8_t CACHE_SLOTS = 8;
 
   struct CacheEntry {
     const EpdFontData* font = nullptr;
@@ -31,6 +33,7 @@ class FontDecompressor {
   InflateReader inflateReader;
   CacheEntry cache[CACHE_SLOTS] = {};
   uint32_t accessCounter = 0;
+  int budgetHandle = -1;
 
   void freeAllEntries();
   uint16_t getGroupIndex(const EpdFontData* fontData, uint16_t glyphIndex);
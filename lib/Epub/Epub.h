@@ -56,12 +56,17 @@ class Epub {
   std::string getThumbBmpPath() const;
   std::string getThumbBmpPath(int height) const;
   bool generateThumbBmp(int height) const;
+  // Decodes the cover image once and writes whichever of cover.bmp, cover_crop.bmp and thumb_<thumbHeight>.bmp
+  // (thumbHeight > 0) are missing
+  bool generateCovers(int thumbHeight) const;
   uint8_t* readItemContentsToBytes(const std::string& itemHref, size_t* size = nullptr,
                                    bool trailingNullByte = false) const;
   bool readItemContentsToStream(const std::string& itemHref, Print& out, size_t chunkSize) const;
   bool getItemSize(const std::string& itemHref, size_t* size) const;
   BookMetadataCache::SpineEntry getSpineItem(int spineIndex) const;
   BookMetadataCache::TocEntry getTocItem(int tocIndex) const;
+  // Consecutive TOC items in one read, see TocWindowCache
+  bool getTocItems(int firstTocIndex, int count, std::vector<BookMetadataCache::TocEntry>& items) const;
   int getSpineItemsCount() const;
   int getTocItemsCount() const;
   int getSpineIndexForTocIndex(int tocIndex) const;
@@ -73,4 +78,6 @@ class Epub {
   float calculateProgress(int currentSpineIndex, float currentSpineRead) const;
   CssParser* getCssParser() const { return cssParser.get(); }
   int resolveHrefToSpineIndex(const std::string& href) const;
+  // Spine item containing the given offset into the book's inflated size (see getBookSize), -1 when not loaded
+  int getSpineIndexForBookOffset(size_t offset) const;
 };
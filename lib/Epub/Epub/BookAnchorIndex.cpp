@@ -0,0 +1,397 @@
+#include "BookAnchorIndex.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+#include <ZipFile.h>
+
+#include <algorithm>
+
+#include "SectionLayoutCache.h"
+
+namespace {
+constexpr uint8_t ANCHOR_INDEX_VERSION = 1;
+constexpr char anchorIndexFile[] = "/anchors.bin";
+// Sections built since the last merge, in build order
+constexpr char anchorRunFile[] = "/anchors.run";
+// Entries read and written per SD access while merging
+constexpr size_t ENTRY_BATCH = 32;
+// The run is merged into the index once it grows past this, a merge holds all of it in RAM
+constexpr size_t MAX_RUN_BYTES = 4096;
+
+// On-disk entry, written as is
+struct Entry {
+  uint32_t hash;
+  uint16_t spine;
+  uint16_t page;
+};
+static_assert(sizeof(Entry) == 8, "Anchor index entries are fixed size");
+
+bool entryLess(const Entry& a, const Entry& b) { return a.hash != b.hash ? a.hash < b.hash : a.spine < b.spine; }
+
+size_t bitmapSize(const uint16_t spineCount) { return (spineCount + 7) / 8; }
+
+// Header: version, spine count, a bit per section already indexed, entry count
+bool readHeader(FsFile& file, uint16_t& spineCount, std::vector<uint8_t>& indexed, uint32_t& count) {
+  uint8_t version;
+  serialization::readPod(file, version);
+  if (version != ANCHOR_INDEX_VERSION) {
+    return false;
+  }
+  serialization::readPod(file, spineCount);
+  indexed.assign(bitmapSize(spineCount), 0);
+  if (file.read(indexed.data(), indexed.size()) != static_cast<int>(indexed.size())) {
+    return false;
+  }
+  serialization::readPod(file, count);
+  return true;
+}
+
+// Run: version, then per section built, spine index, entry count and its entries unsorted. onSection(spine) is called
+// at the start of each section, then onEntries(entries, count) for each batch of its entries. Sections outside
+// spineCount are skipped. Returns false on a version mismatch or a truncated run.
+template <typename OnSection, typename OnEntries>
+bool readRun(FsFile& run, const uint16_t spineCount, OnSection onSection, OnEntries onEntries) {
+  uint8_t version;
+  serialization::readPod(run, version);
+  if (version != ANCHOR_INDEX_VERSION) {
+    return false;
+  }
+  Entry buffer[ENTRY_BATCH];
+  while (run.available() > 0) {
+    uint16_t spine;
+    uint16_t count;
+    if (run.read(&spine, sizeof(spine)) != static_cast<int>(sizeof(spine)) ||
+        run.read(&count, sizeof(count)) != static_cast<int>(sizeof(count))) {
+      return false;
+    }
+    if (spine >= spineCount) {
+      if (!run.seekCur(static_cast<int64_t>(sizeof(Entry)) * count)) {
+        return false;
+      }
+      continue;
+    }
+    onSection(spine);
+    for (uint16_t read = 0; read < count;) {
+      const size_t batch = std::min<size_t>(ENTRY_BATCH, count - read);
+      if (run.read(reinterpret_cast<uint8_t*>(buffer), sizeof(Entry) * batch) !=
+          static_cast<int>(sizeof(Entry) * batch)) {
+        return false;
+      }
+      onEntries(buffer, batch);
+      read += batch;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+uint32_t BookAnchorIndex::hashAnchor(const std::string& anchor) {
+  return ZipFile::fnvHash32(anchor.data(), anchor.size());
+}
+
+void BookAnchorIndex::addSection(const std::string& cachePath, const uint32_t layoutHash, const uint16_t spineCount,
+                                 const int spineIndex, const std::vector<std::pair<std::string, uint16_t>>& anchors) {
+  if (spineIndex < 0 || spineIndex >= spineCount) {
+    return;
+  }
+  const std::string path = SectionLayoutCache::getLayoutDir(cachePath, layoutHash) + anchorRunFile;
+
+  auto run = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+  if (!run) {
+    LOG_ERR("ANC", "Failed to open %s", path.c_str());
+    return;
+  }
+  uint8_t version = 0;
+  if (run.size() > 0) {
+    serialization::readPod(run, version);
+  }
+  if (version != ANCHOR_INDEX_VERSION) {
+    run.close();
+    Storage.remove(path.c_str());
+    run = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+    if (!run) {
+      return;
+    }
+    serialization::writePod(run, ANCHOR_INDEX_VERSION);
+  }
+
+  // Appended as built, sorted and merged into anchors.bin later, so building a book doesn't rewrite the whole index
+  // for every section
+  run.seek(run.size());
+  serialization::writePod(run, static_cast<uint16_t>(spineIndex));
+  serialization::writePod(run, static_cast<uint16_t>(anchors.size()));
+  Entry buffer[ENTRY_BATCH];
+  size_t length = 0;
+  for (const auto& [anchor, page] : anchors) {
+    buffer[length++] = {hashAnchor(anchor), static_cast<uint16_t>(spineIndex), page};
+    if (length == ENTRY_BATCH) {
+      run.write(reinterpret_cast<const uint8_t*>(buffer), sizeof(Entry) * length);
+      length = 0;
+    }
+  }
+  if (length > 0) {
+    run.write(reinterpret_cast<const uint8_t*>(buffer), sizeof(Entry) * length);
+  }
+  const size_t runSize = run.size();
+  run.close();
+  LOG_DBG("ANC", "Queued %u anchors of section %d", static_cast<unsigned>(anchors.size()), spineIndex);
+
+  if (runSize > MAX_RUN_BYTES) {
+    merge(cachePath, layoutHash, spineCount);
+  }
+}
+
+void BookAnchorIndex::merge(const std::string& cachePath, const uint32_t layoutHash, const uint16_t spineCount) {
+  const std::string layoutDir = SectionLayoutCache::getLayoutDir(cachePath, layoutHash);
+  const std::string path = layoutDir + anchorIndexFile;
+  const std::string runPath = layoutDir + anchorRunFile;
+  const std::string tmpPath = path + ".tmp";
+
+  // The run is bounded by MAX_RUN_BYTES (or one large section), the index itself never has to fit in RAM
+  std::vector<Entry> added;
+  std::vector<uint8_t> replaced(bitmapSize(spineCount), 0);
+  {
+    FsFile run;
+    if (!Storage.exists(runPath.c_str()) || !Storage.openFileForRead("ANC", runPath, run)) {
+      return;  // nothing queued
+    }
+    const auto onSection = [&added, &replaced](const uint16_t spine) {
+      if (replaced[spine / 8] & (1 << (spine % 8))) {
+        // Built again since: the newest entries win
+        added.erase(
+            std::remove_if(added.begin(), added.end(), [spine](const Entry& entry) { return entry.spine == spine; }),
+            added.end());
+      }
+      replaced[spine / 8] |= 1 << (spine % 8);
+    };
+    const auto onEntries = [&added](const Entry* entries, const size_t count) {
+      added.insert(added.end(), entries, entries + count);
+    };
+    if (!readRun(run, spineCount, onSection, onEntries)) {
+      LOG_ERR("ANC", "Anchor run unreadable, dropping it");
+      run.close();
+      Storage.remove(runPath.c_str());
+      return;
+    }
+    run.close();
+  }
+  std::sort(added.begin(), added.end(), entryLess);
+  const auto isReplaced = [&replaced](const uint16_t spine) { return replaced[spine / 8] & (1 << (spine % 8)); };
+
+  // Merged with the existing entries a batch at a time
+  FsFile in;
+  std::vector<uint8_t> indexed;
+  uint32_t oldCount = 0;
+  bool hasOld = Storage.openFileForRead("ANC", path, in);
+  if (hasOld) {
+    uint16_t fileSpineCount;
+    hasOld = readHeader(in, fileSpineCount, indexed, oldCount) && fileSpineCount == spineCount;
+    if (!hasOld) {
+      LOG_DBG("ANC", "Anchor index is for another book layout, starting over");
+      in.close();
+    }
+  }
+  if (!hasOld) {
+    indexed.assign(bitmapSize(spineCount), 0);
+    oldCount = 0;
+  }
+  for (size_t i = 0; i < indexed.size(); i++) {
+    indexed[i] |= replaced[i];
+  }
+
+  FsFile out;
+  if (!Storage.openFileForWrite("ANC", tmpPath, out)) {
+    if (hasOld) in.close();
+    return;
+  }
+  serialization::writePod(out, ANCHOR_INDEX_VERSION);
+  serialization::writePod(out, spineCount);
+  out.write(indexed.data(), indexed.size());
+  const uint32_t countOffset = out.position();
+  serialization::writePod(out, static_cast<uint32_t>(0));  // Placeholder for entry count (patched later)
+
+  Entry inBuffer[ENTRY_BATCH];
+  size_t inLength = 0;
+  size_t inPos = 0;
+  uint32_t oldRead = 0;
+  // Next old entry, skipping the ones of the sections being replaced
+  auto nextOld = [&](Entry& entry) {
+    while (true) {
+      if (inPos == inLength) {
+        if (!hasOld || oldRead == oldCount) {
+          return false;
+        }
+        const size_t batch = std::min<size_t>(ENTRY_BATCH, oldCount - oldRead);
+        if (in.read(reinterpret_cast<uint8_t*>(inBuffer), sizeof(Entry) * batch) !=
+            static_cast<int>(sizeof(Entry) * batch)) {
+          LOG_ERR("ANC", "Anchor index truncated");
+          return false;
+        }
+        oldRead += batch;
+        inLength = batch;
+        inPos = 0;
+      }
+      entry = inBuffer[inPos++];
+      if (entry.spine >= spineCount || !isReplaced(entry.spine)) {
+        return true;
+      }
+    }
+  };
+
+  Entry outBuffer[ENTRY_BATCH];
+  size_t outLength = 0;
+  uint32_t written = 0;
+  auto emit = [&](const Entry& entry) {
+    outBuffer[outLength++] = entry;
+    written++;
+    if (outLength == ENTRY_BATCH) {
+      out.write(reinterpret_cast<const uint8_t*>(outBuffer), sizeof(Entry) * outLength);
+      outLength = 0;
+    }
+  };
+
+  Entry old;
+  bool haveOld = nextOld(old);
+  size_t next = 0;
+  while (haveOld || next < added.size()) {
+    if (next < added.size() && (!haveOld || entryLess(added[next], old))) {
+      emit(added[next++]);
+    } else {
+      emit(old);
+      haveOld = nextOld(old);
+    }
+  }
+  if (outLength > 0) {
+    out.write(reinterpret_cast<const uint8_t*>(outBuffer), sizeof(Entry) * outLength);
+  }
+  out.seek(countOffset);
+  serialization::writePod(out, written);
+  out.close();
+  if (hasOld) {
+    in.close();
+  }
+
+  Storage.remove(path.c_str());
+  if (!Storage.rename(tmpPath.c_str(), path.c_str())) {
+    LOG_ERR("ANC", "Failed to replace anchor index");
+    Storage.remove(tmpPath.c_str());
+    return;
+  }
+  Storage.remove(runPath.c_str());
+  LOG_DBG("ANC", "Merged %u queued anchors, %u in book", static_cast<unsigned>(added.size()), written);
+}
+
+bool BookAnchorIndex::find(const std::string& cachePath, const uint32_t layoutHash, const std::string& anchor,
+                           const int preferredSpine, int& spineIndex, uint16_t& page) {
+  const std::string layoutDir = SectionLayoutCache::getLayoutDir(cachePath, layoutHash);
+  const uint32_t hash = hashAnchor(anchor);
+
+  // Sections built since the last merge: their entries in the run replace the ones in anchors.bin
+  std::vector<uint16_t> pendingSpines;
+  std::vector<Entry> pendingHits;
+  const std::string runPath = layoutDir + anchorRunFile;
+  FsFile run;
+  if (Storage.exists(runPath.c_str()) && Storage.openFileForRead("ANC", runPath, run)) {
+    const auto dropHits = [&pendingHits](const uint16_t spine) {
+      pendingHits.erase(std::remove_if(pendingHits.begin(), pendingHits.end(),
+                                       [spine](const Entry& entry) { return entry.spine == spine; }),
+                        pendingHits.end());
+    };
+    const auto onSection = [&pendingSpines, &dropHits](const uint16_t spine) {
+      if (std::find(pendingSpines.begin(), pendingSpines.end(), spine) != pendingSpines.end()) {
+        dropHits(spine);  // built again since, the newest entries win
+      } else {
+        pendingSpines.push_back(spine);
+      }
+    };
+    const auto onEntries = [&pendingHits, hash](const Entry* entries, const size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        if (entries[i].hash == hash) {
+          pendingHits.push_back(entries[i]);
+        }
+      }
+    };
+    if (!readRun(run, UINT16_MAX, onSection, onEntries) && !pendingSpines.empty()) {
+      // Only the section being appended can be cut short
+      dropHits(pendingSpines.back());
+      pendingSpines.pop_back();
+    }
+    run.close();
+  }
+  const auto isPending = [&pendingSpines](const uint16_t spine) {
+    return std::find(pendingSpines.begin(), pendingSpines.end(), spine) != pendingSpines.end();
+  };
+
+  // The same id may be used in several sections
+  bool hasOther = false;
+  Entry other{};
+  const auto consider = [&](const Entry& entry) {
+    if (entry.spine == preferredSpine) {
+      spineIndex = entry.spine;
+      page = entry.page;
+      return true;
+    }
+    if (!hasOther || entry.spine < other.spine) {
+      other = entry;
+      hasOther = true;
+    }
+    return false;
+  };
+  for (const auto& entry : pendingHits) {
+    if (consider(entry)) {
+      return true;
+    }
+  }
+  bool preferredIndexed = preferredSpine >= 0 && isPending(preferredSpine);
+
+  FsFile file;
+  uint16_t spineCount;
+  std::vector<uint8_t> indexed;
+  uint32_t count;
+  if (Storage.openFileForRead("ANC", layoutDir + anchorIndexFile, file) &&
+      readHeader(file, spineCount, indexed, count)) {
+    const uint32_t entriesOffset = file.position();
+
+    // First entry with the hash
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+      const uint32_t mid = low + (high - low) / 2;
+      uint32_t midHash;
+      file.seek(entriesOffset + sizeof(Entry) * mid);
+      serialization::readPod(file, midHash);
+      if (midHash < hash) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    file.seek(entriesOffset + sizeof(Entry) * low);
+    for (uint32_t i = low; i < count; i++) {
+      Entry entry;
+      if (file.read(reinterpret_cast<uint8_t*>(&entry), sizeof(Entry)) != static_cast<int>(sizeof(Entry)) ||
+          entry.hash != hash) {
+        break;
+      }
+      if (!isPending(entry.spine) && consider(entry)) {
+        file.close();
+        return true;
+      }
+    }
+    preferredIndexed = preferredIndexed || (preferredSpine >= 0 && preferredSpine < spineCount &&
+                                            (indexed[preferredSpine / 8] & (1 << (preferredSpine % 8))));
+  }
+  if (file) {
+    file.close();
+  }
+
+  // A section not indexed yet may still hold the anchor, let the reader look it up there
+  if (!hasOther || (preferredSpine >= 0 && !preferredIndexed)) {
+    return false;
+  }
+  spineIndex = other.spine;
+  page = other.page;
+  return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+Book-wide anchor index for one layout: (anchor hash, spine, page) entries sorted by hash in
+<cache>/sections/<layoutHash>/anchors.bin. A link is resolved with a binary search over the file, without opening
+the target section or the sections before it.
+
+Sections append their entries to anchors.run as they are built, which is merged into anchors.bin once it grows too
+large or the book indexer is done, so building a book doesn't rewrite the index for every section. find() also reads
+the run.
+
+Only hashes are stored. The reader still looks the anchor up in the target section's own table, which keeps the
+strings, so a hash collision at worst lands on the wrong page of the right section.
+*/
+class BookAnchorIndex {
+ public:
+  // FNV-1a of the anchor id, shared with the anchor tables of section files
+  static uint32_t hashAnchor(const std::string& anchor);
+
+  // Replaces the entries of a section with the anchors of its new section file
+  static void addSection(const std::string& cachePath, uint32_t layoutHash, uint16_t spineCount, int spineIndex,
+                         const std::vector<std::pair<std::string, uint16_t>>& anchors);
+  // Merges the sections queued in anchors.run into anchors.bin. No-op when nothing is queued.
+  static void merge(const std::string& cachePath, uint32_t layoutHash, uint16_t spineCount);
+
+  // Section and page of an anchor. An entry in preferredSpine wins; other sections are only used when preferredSpine
+  // is -1 or was already indexed without the anchor.
+  static bool find(const std::string& cachePath, uint32_t layoutHash, const std::string& anchor, int preferredSpine,
+                   int& spineIndex, uint16_t& page);
+};
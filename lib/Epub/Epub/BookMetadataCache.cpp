@@ -4,6 +4,8 @@
 #include <Serialization.h>
 #include <ZipFile.h>
 
+#include <cstring>
+#include <new>
 #include <vector>
 
 #include "FsHelpers.h"
@@ -13,6 +15,24 @@ constexpr uint8_t BOOK_CACHE_VERSION = 5;
 constexpr char bookBinFile[] = "/book.bin";
 constexpr char tmpSpineBinFile[] = "/spine.bin.tmp";
 constexpr char tmpTocBinFile[] = "/toc.bin.tmp";
+// Larger TOC windows are read entry by entry rather than buffered
+constexpr size_t MAX_TOC_BLOCK_SIZE = 16 * 1024;
+
+// Parses a length-prefixed string written by serialization::writeString from a memory block
+bool readBlockString(const uint8_t* block, const size_t blockSize, size_t& pos, std::string& s) {
+  uint32_t len;
+  if (blockSize - pos < sizeof(len)) {
+    return false;
+  }
+  memcpy(&len, block + pos, sizeof(len));
+  pos += sizeof(len);
+  if (blockSize - pos < len) {
+    return false;
+  }
+  s.assign(reinterpret_cast<const char*>(block + pos), len);
+  pos += len;
+  return true;
+}
 }  // namespace
 
 /* ============= WRITING / BUILDING FUNCTIONS ================ */
@@ -389,6 +409,52 @@ bool BookMetadataCache::load() {
 
   loaded = true;
   LOG_DBG("BMC", "Loaded cache data: %d spine, %d TOC entries", spineCount, tocCount);
+  loadSpineTable();
+  return true;
+}
+
+uint64_t BookMetadataCache::filenameHash(const std::string& href) {
+  const size_t slash = href.find_last_of('/');
+  const size_t start = slash == std::string::npos ? 0 : slash + 1;
+  return fnvHash64(href.data() + start, href.size() - start);
+}
+
+bool BookMetadataCache::loadSpineTable() {
+  spineCumulativeSizes.reset(new (std::nothrow) uint32_t[spineCount]);
+  spineTocIndexes.reset(new (std::nothrow) int16_t[spineCount]);
+  spineFilenameHashes.reset(new (std::nothrow) uint64_t[spineCount]);
+  spineFilenameOrder.reset(new (std::nothrow) int16_t[spineCount]);
+  if (!spineCumulativeSizes || !spineTocIndexes || !spineFilenameHashes || !spineFilenameOrder) {
+    LOG_ERR("BMC", "Not enough memory for the spine table (%d items), reading book.bin instead", spineCount);
+    spineCumulativeSizes.reset();
+    spineTocIndexes.reset();
+    spineFilenameHashes.reset();
+    spineFilenameOrder.reset();
+    return false;
+  }
+  if (spineCount == 0) {
+    return true;
+  }
+
+  // Spine entries are stored back to back, so one seek covers them all
+  bookFile.seek(lutOffset);
+  uint32_t firstSpineEntryPos;
+  serialization::readPod(bookFile, firstSpineEntryPos);
+  bookFile.seek(firstSpineEntryPos);
+  for (int i = 0; i < spineCount; i++) {
+    const auto entry = readSpineEntry(bookFile);
+    spineCumulativeSizes[i] = entry.cumulativeSize;
+    spineTocIndexes[i] = entry.tocIndex;
+    spineFilenameHashes[i] = filenameHash(entry.href);
+    spineFilenameOrder[i] = static_cast<int16_t>(i);
+  }
+
+  const uint64_t* hashes = spineFilenameHashes.get();
+  std::sort(spineFilenameOrder.get(), spineFilenameOrder.get() + spineCount,
+            [hashes](const int16_t a, const int16_t b) {
+              return hashes[a] < hashes[b] || (hashes[a] == hashes[b] && a < b);
+            });
+  LOG_DBG("BMC", "Spine table loaded: %d items", spineCount);
   return true;
 }
 
@@ -430,6 +496,144 @@ BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
   return readTocEntry(bookFile);
 }
 
+bool BookMetadataCache::getTocEntries(const int first, const int count, std::vector<TocEntry>& entries) {
+  entries.clear();
+  if (!loaded || first < 0 || count <= 0 || first >= static_cast<int>(tocCount)) {
+    return false;
+  }
+  const int last = std::min(first + count, static_cast<int>(tocCount));
+  entries.reserve(last - first);
+
+  // TOC entries are stored back to back at the end of book.bin, the LUT gives where the window starts and ends
+  const size_t tocLutOffset = lutOffset + sizeof(uint32_t) * spineCount;
+  uint32_t startPos;
+  uint32_t endPos = bookFile.size();
+  bookFile.seek(tocLutOffset + sizeof(uint32_t) * first);
+  serialization::readPod(bookFile, startPos);
+  if (last < static_cast<int>(tocCount)) {
+    bookFile.seek(tocLutOffset + sizeof(uint32_t) * last);
+    serialization::readPod(bookFile, endPos);
+  }
+
+  const size_t blockSize = endPos > startPos ? endPos - startPos : 0;
+  uint8_t* block = nullptr;
+  if (blockSize > 0 && blockSize <= MAX_TOC_BLOCK_SIZE) {
+    block = static_cast<uint8_t*>(malloc(blockSize));
+  }
+  if (block) {
+    bookFile.seek(startPos);
+    if (bookFile.read(block, blockSize) == static_cast<int>(blockSize)) {
+      size_t pos = 0;
+      for (int i = first; i < last; i++) {
+        TocEntry entry;
+        if (!readBlockString(block, blockSize, pos, entry.title) ||
+            !readBlockString(block, blockSize, pos, entry.href) ||
+            !readBlockString(block, blockSize, pos, entry.anchor) ||
+            blockSize - pos < sizeof(entry.level) + sizeof(entry.spineIndex)) {
+          LOG_ERR("BMC", "TOC block %d-%d is malformed", first, last);
+          entries.clear();
+          break;
+        }
+        memcpy(&entry.level, block + pos, sizeof(entry.level));
+        pos += sizeof(entry.level);
+        memcpy(&entry.spineIndex, block + pos, sizeof(entry.spineIndex));
+        pos += sizeof(entry.spineIndex);
+        entries.push_back(std::move(entry));
+      }
+    }
+    free(block);
+  }
+
+  if (entries.empty()) {
+    // Too large to buffer, out of memory or unreadable as a block
+    for (int i = first; i < last; i++) {
+      entries.push_back(getTocEntry(i));
+    }
+  }
+  return true;
+}
+
+uint32_t BookMetadataCache::getCumulativeSize(const int index) {
+  if (index < 0 || index >= static_cast<int>(spineCount)) {
+    LOG_ERR("BMC", "getCumulativeSize index %d out of range", index);
+    return 0;
+  }
+  if (spineCumulativeSizes) {
+    return spineCumulativeSizes[index];
+  }
+  return getSpineEntry(index).cumulativeSize;
+}
+
+int16_t BookMetadataCache::getSpineTocIndex(const int index) {
+  if (index < 0 || index >= static_cast<int>(spineCount)) {
+    LOG_ERR("BMC", "getSpineTocIndex index %d out of range", index);
+    return -1;
+  }
+  if (spineTocIndexes) {
+    return spineTocIndexes[index];
+  }
+  return getSpineEntry(index).tocIndex;
+}
+
+int BookMetadataCache::findSpineIndex(const std::string& href, const bool matchFilename) {
+  const size_t slash = href.find_last_of('/');
+  const size_t filenameStart = slash == std::string::npos ? 0 : slash + 1;
+  // Candidates are confirmed against the stored href, which also rules out hash collisions
+  const auto matches = [&](const int index) {
+    const std::string spineHref = getSpineEntry(index).href;
+    if (spineHref == href) {
+      return true;
+    }
+    if (!matchFilename) {
+      return false;
+    }
+    const size_t spineSlash = spineHref.find_last_of('/');
+    const size_t spineFilenameStart = spineSlash == std::string::npos ? 0 : spineSlash + 1;
+    return spineHref.compare(spineFilenameStart, std::string::npos, href, filenameStart, std::string::npos) == 0;
+  };
+
+  if (!spineFilenameOrder) {
+    for (int i = 0; i < spineCount; i++) {
+      if (matches(i)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Entries sharing a file name hash are ordered by spine index, so the first match is the first in the spine
+  const uint64_t hash = filenameHash(href);
+  const uint64_t* hashes = spineFilenameHashes.get();
+  const int16_t* begin = spineFilenameOrder.get();
+  const int16_t* end = begin + spineCount;
+  const int16_t* it =
+      std::lower_bound(begin, end, hash, [hashes](const int16_t index, const uint64_t h) { return hashes[index] < h; });
+  for (; it != end && hashes[*it] == hash; ++it) {
+    if (matches(*it)) {
+      return *it;
+    }
+  }
+  return -1;
+}
+
+int BookMetadataCache::findSpineIndexForOffset(const uint32_t offset) {
+  if (spineCount == 0) {
+    return -1;
+  }
+  if (spineCumulativeSizes) {
+    const uint32_t* begin = spineCumulativeSizes.get();
+    const uint32_t* end = begin + spineCount;
+    const uint32_t* it = std::lower_bound(begin, end, offset);
+    return it == end ? spineCount - 1 : static_cast<int>(it - begin);
+  }
+  for (int i = 0; i < spineCount; i++) {
+    if (getSpineEntry(i).cumulativeSize >= offset) {
+      return i;
+    }
+  }
+  return spineCount - 1;
+}
+
 BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(FsFile& file) const {
   SpineEntry entry;
   serialization::readString(file, entry.href);
@@ -3,6 +3,7 @@
 #include <HalStorage.h>
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -64,22 +65,34 @@ class BookMetadataCache {
   std::vector<SpineHrefIndexEntry> spineHrefIndex;
   bool useSpineHrefIndex = false;
 
+  // RAM copy of the per-spine data that progress and href lookups need, filled by load() so those don't seek into
+  // book.bin (16 bytes per spine item). Null when it didn't fit in memory; lookups then fall back to book.bin.
+  std::unique_ptr<uint32_t[]> spineCumulativeSizes;
+  std::unique_ptr<int16_t[]> spineTocIndexes;
+  // FNV-1a hash of each spine href's file name, and the spine indexes sorted by (hash, index) for binary search
+  std::unique_ptr<uint64_t[]> spineFilenameHashes;
+  std::unique_ptr<int16_t[]> spineFilenameOrder;
+
   static constexpr uint16_t LARGE_SPINE_THRESHOLD = 400;
 
   // FNV-1a 64-bit hash function
-  static uint64_t fnvHash64(const std::string& s) {
+  static uint64_t fnvHash64(const char* s, const size_t len) {
     uint64_t hash = 14695981039346656037ull;
-    for (char c : s) {
-      hash ^= static_cast<uint8_t>(c);
+    for (size_t i = 0; i < len; i++) {
+      hash ^= static_cast<uint8_t>(s[i]);
       hash *= 1099511628211ull;
     }
     return hash;
   }
+  static uint64_t fnvHash64(const std::string& s) { return fnvHash64(s.data(), s.size()); }
+  // Hash of the part after the last '/', so both full-path and file-name lookups land on the same entries
+  static uint64_t filenameHash(const std::string& href);
 
   uint32_t writeSpineEntry(FsFile& file, const SpineEntry& entry) const;
   uint32_t writeTocEntry(FsFile& file, const TocEntry& entry) const;
   SpineEntry readSpineEntry(FsFile& file) const;
   TocEntry readTocEntry(FsFile& file) const;
+  bool loadSpineTable();
 
  public:
   BookMetadata coreMetadata;
@@ -106,6 +119,15 @@ class BookMetadataCache {
   bool load();
   SpineEntry getSpineEntry(int index);
   TocEntry getTocEntry(int index);
+  // Entries [first, first + count) clipped to the TOC, read from book.bin in one block. False when none could be read.
+  bool getTocEntries(int first, int count, std::vector<TocEntry>& entries);
+  // O(1) from the RAM spine table
+  uint32_t getCumulativeSize(int index);
+  int16_t getSpineTocIndex(int index);
+  // First spine item whose href equals href or, with matchFilename, whose file name equals href's. -1 when none does.
+  int findSpineIndex(const std::string& href, bool matchFilename);
+  // First spine item whose cumulative size reaches offset (binary search); the last one when offset is past the end
+  int findSpineIndexForOffset(uint32_t offset);
   int getSpineCount() const { return spineCount; }
   int getTocCount() const { return tocCount; }
   bool isLoaded() const { return loaded; }
@@ -0,0 +1,378 @@
+#include "FootnoteStore.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+#include <ZipFile.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "../Epub.h"
+#include "parsers/FootnoteTextParser.h"
+
+namespace {
+constexpr uint8_t FOOTNOTE_STORE_VERSION = 1;
+constexpr char footnotesDataFile[] = "/footnotes.bin";
+constexpr char footnotesIndexFile[] = "/footnotes.idx";
+// Index entries of the notes stored since the last merge, unsorted
+constexpr char footnotesRunFile[] = "/footnotes.run";
+// The run is merged into the index once it grows past this, a merge holds all of it in RAM
+constexpr size_t MAX_RUN_BYTES = 4096;
+// Index entries read and written per SD access while merging
+constexpr size_t ENTRY_BATCH = 32;
+
+// On-disk index entry, written as is
+struct Entry {
+  uint32_t hash;
+  uint32_t offset;  // of the record in footnotes.bin
+};
+static_assert(sizeof(Entry) == 8, "Footnote index entries are fixed size");
+
+// Spine item and anchor a link points to
+bool resolveNote(const Epub& epub, const int fromSpineIndex, const std::string& href, int& spineIndex,
+                 std::string& anchor) {
+  const size_t hashPos = href.find('#');
+  if (hashPos == std::string::npos || hashPos + 1 >= href.size()) {
+    return false;
+  }
+  spineIndex = hashPos == 0 ? fromSpineIndex : epub.resolveHrefToSpineIndex(href);
+  if (spineIndex < 0 || spineIndex >= epub.getSpineItemsCount()) {
+    return false;
+  }
+  anchor = href.substr(hashPos + 1);
+  return true;
+}
+
+// Reads the entries queued in footnotes.run; false when there is no run of this version
+bool readRun(const std::string& cachePath, std::vector<Entry>& entries) {
+  const std::string runPath = cachePath + footnotesRunFile;
+  FsFile run;
+  if (!Storage.exists(runPath.c_str()) || !Storage.openFileForRead("FNS", runPath, run)) {
+    return false;
+  }
+  uint8_t version = 0;
+  serialization::readPod(run, version);
+  if (version != FOOTNOTE_STORE_VERSION) {
+    run.close();
+    return false;
+  }
+  // A record cut short by a power loss is dropped
+  const size_t count = (run.size() - sizeof(version)) / sizeof(Entry);
+  entries.resize(count);
+  const bool ok = count == 0 || run.read(reinterpret_cast<uint8_t*>(entries.data()), sizeof(Entry) * count) ==
+                                    static_cast<int>(sizeof(Entry) * count);
+  run.close();
+  return ok;
+}
+
+// Appends the notes to footnotes.bin and queues their entries in footnotes.run
+void storeNotes(const std::string& cachePath, const std::vector<std::pair<std::string, std::string>>& notes) {
+  const std::string dataPath = cachePath + footnotesDataFile;
+  const std::string indexPath = cachePath + footnotesIndexFile;
+  const std::string runPath = cachePath + footnotesRunFile;
+
+  auto data = Storage.open(dataPath.c_str(), O_RDWR | O_CREAT);
+  if (!data) {
+    LOG_ERR("FNS", "Failed to open %s", dataPath.c_str());
+    return;
+  }
+  uint8_t version = 0;
+  if (data.size() > 0) {
+    serialization::readPod(data, version);
+  }
+  if (version != FOOTNOTE_STORE_VERSION) {
+    // New store, or one of another version: start over
+    data.close();
+    Storage.remove(dataPath.c_str());
+    Storage.remove(indexPath.c_str());
+    Storage.remove(runPath.c_str());
+    data = Storage.open(dataPath.c_str(), O_RDWR | O_CREAT);
+    if (!data) {
+      return;
+    }
+    serialization::writePod(data, FOOTNOTE_STORE_VERSION);
+  }
+
+  std::vector<Entry> added;
+  added.reserve(notes.size());
+  data.seek(data.size());
+  for (const auto& [key, text] : notes) {
+    added.push_back({ZipFile::fnvHash32(key.data(), key.size()), static_cast<uint32_t>(data.position())});
+    serialization::writeString(data, key);
+    serialization::writeString(data, text);
+  }
+  data.close();
+
+  // Sorted into footnotes.idx later, so capturing a book's notes doesn't rewrite the whole index for every section
+  auto run = Storage.open(runPath.c_str(), O_RDWR | O_CREAT);
+  if (!run) {
+    LOG_ERR("FNS", "Failed to open %s", runPath.c_str());
+    return;
+  }
+  if (run.size() == 0) {
+    serialization::writePod(run, FOOTNOTE_STORE_VERSION);
+  }
+  // Over an entry cut short by a power loss, if any
+  const size_t queued = (run.size() - sizeof(FOOTNOTE_STORE_VERSION)) / sizeof(Entry);
+  run.seek(sizeof(FOOTNOTE_STORE_VERSION) + queued * sizeof(Entry));
+  run.write(reinterpret_cast<const uint8_t*>(added.data()), sizeof(Entry) * added.size());
+  const size_t runSize = run.size();
+  run.close();
+
+  if (runSize > MAX_RUN_BYTES) {
+    FootnoteStore::merge(cachePath);
+  }
+}
+}  // namespace
+
+bool FootnoteStore::makeKey(const Epub& epub, const int fromSpineIndex, const std::string& href, std::string& key) {
+  int spineIndex;
+  std::string anchor;
+  if (!resolveNote(epub, fromSpineIndex, href, spineIndex, anchor)) {
+    return false;
+  }
+  key = epub.getSpineItem(spineIndex).href + "#" + anchor;
+  return true;
+}
+
+void FootnoteStore::merge(const std::string& cachePath) {
+  const std::string indexPath = cachePath + footnotesIndexFile;
+  const std::string runPath = cachePath + footnotesRunFile;
+  const std::string tmpPath = indexPath + ".tmp";
+
+  // The run is bounded by MAX_RUN_BYTES (or one section's notes), the index itself never has to fit in RAM
+  std::vector<Entry> added;
+  if (!readRun(cachePath, added)) {
+    if (Storage.exists(runPath.c_str())) {
+      LOG_ERR("FNS", "Footnote run unreadable, dropping it");
+      Storage.remove(runPath.c_str());
+    }
+    return;
+  }
+  std::sort(added.begin(), added.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+  // Merged with the existing entries a batch at a time
+  FsFile in;
+  uint32_t oldCount = 0;
+  bool hasOld = Storage.exists(indexPath.c_str()) && Storage.openFileForRead("FNS", indexPath, in);
+  if (hasOld) {
+    uint8_t indexVersion;
+    serialization::readPod(in, indexVersion);
+    serialization::readPod(in, oldCount);
+    if (indexVersion != FOOTNOTE_STORE_VERSION) {
+      in.close();
+      hasOld = false;
+      oldCount = 0;
+    }
+  }
+
+  FsFile out;
+  if (!Storage.openFileForWrite("FNS", tmpPath, out)) {
+    if (hasOld) in.close();
+    return;
+  }
+  const uint32_t count = oldCount + static_cast<uint32_t>(added.size());
+  serialization::writePod(out, FOOTNOTE_STORE_VERSION);
+  serialization::writePod(out, count);
+
+  Entry inBuffer[ENTRY_BATCH];
+  size_t inLength = 0;
+  size_t inPos = 0;
+  uint32_t oldRead = 0;
+  auto nextOld = [&](Entry& entry) {
+    if (inPos == inLength) {
+      if (!hasOld || oldRead == oldCount) {
+        return false;
+      }
+      const size_t batch = std::min<size_t>(ENTRY_BATCH, oldCount - oldRead);
+      if (in.read(reinterpret_cast<uint8_t*>(inBuffer), sizeof(Entry) * batch) !=
+          static_cast<int>(sizeof(Entry) * batch)) {
+        return false;
+      }
+      oldRead += batch;
+      inLength = batch;
+      inPos = 0;
+    }
+    entry = inBuffer[inPos++];
+    return true;
+  };
+
+  Entry outBuffer[ENTRY_BATCH];
+  size_t outLength = 0;
+  uint32_t written = 0;
+  auto emit = [&](const Entry& entry) {
+    outBuffer[outLength++] = entry;
+    written++;
+    if (outLength == ENTRY_BATCH) {
+      out.write(reinterpret_cast<const uint8_t*>(outBuffer), sizeof(Entry) * outLength);
+      outLength = 0;
+    }
+  };
+
+  Entry old;
+  bool haveOld = nextOld(old);
+  size_t next = 0;
+  while (haveOld || next < added.size()) {
+    if (next < added.size() && (!haveOld || added[next].hash < old.hash)) {
+      emit(added[next++]);
+    } else {
+      emit(old);
+      haveOld = nextOld(old);
+    }
+  }
+  if (outLength > 0) {
+    out.write(reinterpret_cast<const uint8_t*>(outBuffer), sizeof(Entry) * outLength);
+  }
+  if (written != count) {
+    LOG_ERR("FNS", "Footnote index truncated, kept %u of %u entries", written, count);
+    out.seek(sizeof(FOOTNOTE_STORE_VERSION));
+    serialization::writePod(out, written);
+  }
+  out.close();
+  if (hasOld) {
+    in.close();
+  }
+
+  Storage.remove(indexPath.c_str());
+  if (!Storage.rename(tmpPath.c_str(), indexPath.c_str())) {
+    LOG_ERR("FNS", "Failed to replace footnote index");
+    Storage.remove(tmpPath.c_str());
+    return;
+  }
+  Storage.remove(runPath.c_str());
+  LOG_DBG("FNS", "Merged %u queued notes, %u in book", static_cast<unsigned>(added.size()), written);
+}
+
+bool FootnoteStore::find(const std::string& cachePath, const std::string& key, std::string& text) {
+  const uint32_t hash = ZipFile::fnvHash32(key.data(), key.size());
+  FsFile data;
+  // Hash collisions are told apart by the keys
+  const auto readIfMatches = [&](const Entry& entry) {
+    if (!data && !Storage.openFileForRead("FNS", cachePath + footnotesDataFile, data)) {
+      return false;
+    }
+    std::string entryKey;
+    data.seek(entry.offset);
+    serialization::readString(data, entryKey);
+    if (entryKey != key) {
+      return false;
+    }
+    serialization::readString(data, text);
+    return true;
+  };
+
+  bool found = false;
+  const std::string indexPath = cachePath + footnotesIndexFile;
+  FsFile index;
+  if (Storage.exists(indexPath.c_str()) && Storage.openFileForRead("FNS", indexPath, index)) {
+    uint8_t version;
+    uint32_t count;
+    serialization::readPod(index, version);
+    serialization::readPod(index, count);
+    if (version != FOOTNOTE_STORE_VERSION) {
+      count = 0;
+    }
+    const uint32_t entriesOffset = index.position();
+
+    // First entry with the hash
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+      const uint32_t mid = low + (high - low) / 2;
+      uint32_t midHash;
+      index.seek(entriesOffset + sizeof(Entry) * mid);
+      serialization::readPod(index, midHash);
+      if (midHash < hash) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    for (uint32_t i = low; i < count && !found; i++) {
+      Entry entry;
+      index.seek(entriesOffset + sizeof(Entry) * i);
+      if (index.read(reinterpret_cast<uint8_t*>(&entry), sizeof(Entry)) != static_cast<int>(sizeof(Entry)) ||
+          entry.hash != hash) {
+        break;
+      }
+      found = readIfMatches(entry);
+    }
+    index.close();
+  }
+
+  // Notes stored since the last merge
+  std::vector<Entry> queued;
+  if (!found && readRun(cachePath, queued)) {
+    for (const auto& entry : queued) {
+      if (entry.hash == hash && readIfMatches(entry)) {
+        found = true;
+        break;
+      }
+    }
+  }
+  if (data) {
+    data.close();
+  }
+  return found;
+}
+
+void FootnoteStore::capture(const Epub& epub, const int fromSpineIndex, const std::vector<std::string>& hrefs,
+                            const std::function<bool()>& abortFn) {
+  // Anchors not stored yet, grouped by the file holding them
+  std::vector<std::pair<int, std::vector<std::string>>> targets;
+  std::vector<std::string> keys;
+  std::string key;
+  std::string text;
+  for (const auto& href : hrefs) {
+    int spineIndex;
+    std::string anchor;
+    if (!resolveNote(epub, fromSpineIndex, href, spineIndex, anchor)) {
+      continue;
+    }
+    key = epub.getSpineItem(spineIndex).href + "#" + anchor;
+    if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
+      continue;
+    }
+    keys.push_back(key);
+    if (find(epub.getCachePath(), key, text)) {
+      continue;
+    }
+    auto target = std::find_if(targets.begin(), targets.end(),
+                               [spineIndex](const auto& entry) { return entry.first == spineIndex; });
+    if (target == targets.end()) {
+      targets.emplace_back(spineIndex, std::vector<std::string>());
+      target = targets.end() - 1;
+    }
+    target->second.push_back(std::move(anchor));
+  }
+
+  std::vector<std::pair<std::string, std::string>> notes;
+  for (auto& [spineIndex, anchors] : targets) {
+    if (abortFn && abortFn()) {
+      break;
+    }
+    const std::string itemHref = epub.getSpineItem(spineIndex).href;
+    size_t itemSize;
+    if (!epub.getItemSize(itemHref, &itemSize)) {
+      continue;
+    }
+    const size_t wanted = anchors.size();
+    FootnoteTextParser parser(itemSize, std::move(anchors), abortFn);
+    if (!parser.setup()) {
+      continue;
+    }
+    // Stops once every note was found. A parse error keeps the notes found before it, a cancel the complete ones.
+    epub.readItemContentsToStream(itemHref, parser, 1024);
+    LOG_DBG("FNS", "Found %u of %u notes in %s", static_cast<unsigned>(parser.notes.size()),
+            static_cast<unsigned>(wanted), itemHref.c_str());
+    for (auto& [id, noteText] : parser.notes) {
+      notes.emplace_back(itemHref + "#" + id, std::move(noteText));
+    }
+  }
+
+  if (!notes.empty()) {
+    storeNotes(epub.getCachePath(), notes);
+  }
+}
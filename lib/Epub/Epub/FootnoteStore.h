@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class Epub;
+
+/*
+Text of the footnotes and endnotes a book links to, so a note can be shown over the page it's referenced from instead
+of opening the section holding it.
+
+Notes are keyed by the path of their file in the book and their anchor ("OEBPS/notes.xhtml#n1"). footnotes.bin in the
+book cache holds the (key, text) records, appended as notes are captured; footnotes.idx holds (key hash, record
+offset) entries sorted by hash, so a lookup is a binary search plus one record read. Entries of new records are
+queued in footnotes.run and merged into footnotes.idx once it grows too large or the book indexer is done. The text
+doesn't depend on the layout, so the store is shared by all of them.
+
+The background indexer captures the notes linked from each section it builds, reading each target file up to the
+last note it still needs. Notes not captured yet are extracted when first shown.
+*/
+class FootnoteStore {
+ public:
+  // Key of the note a link points to; false for links without an anchor or to files outside the spine
+  static bool makeKey(const Epub& epub, int fromSpineIndex, const std::string& href, std::string& key);
+
+  static bool find(const std::string& cachePath, const std::string& key, std::string& text);
+
+  // Extracts and stores the notes of links from a section that aren't stored yet
+  static void capture(const Epub& epub, int fromSpineIndex, const std::vector<std::string>& hrefs,
+                      const std::function<bool()>& abortFn = nullptr);
+
+  // Merges the entries queued in footnotes.run into footnotes.idx. No-op when nothing is queued.
+  static void merge(const std::string& cachePath);
+};
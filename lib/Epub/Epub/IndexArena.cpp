@@ -0,0 +1,164 @@
+#include "IndexArena.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+IndexArena* activeArena = nullptr;
+
+// rawAlloc keeps the requested size in front of each arena allocation so rawRealloc knows how much to copy
+constexpr size_t RAW_HEADER_SIZE = 8;
+constexpr size_t ALIGNMENT = 8;
+
+size_t alignUp(const size_t value) { return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+}  // namespace
+
+IndexArena::IndexArena() {
+  if (activeArena) {
+    LOG_DBG("ARN", "Another index arena is active, indexing from the heap");
+    return;
+  }
+
+  for (size_t i = 0; i < MAX_BLOCKS; i++) {
+    if (ESP.getMaxAllocHeap() < BLOCK_SIZE + MIN_LARGEST_FREE_BLOCK) break;
+    blocks[i] = static_cast<uint8_t*>(malloc(BLOCK_SIZE));
+    if (!blocks[i]) break;
+    blockCount++;
+  }
+  if (blockCount == 0) {
+    LOG_DBG("ARN", "Not enough heap for an index arena (max alloc %u)", ESP.getMaxAllocHeap());
+    return;
+  }
+
+  ownerTask = xTaskGetCurrentTaskHandle();
+  taskENTER_CRITICAL(nullptr);
+  activeArena = this;
+  taskEXIT_CRITICAL(nullptr);
+  LOG_DBG("ARN", "Reserved %u bytes for indexing", static_cast<unsigned>(blockCount * BLOCK_SIZE));
+}
+
+IndexArena::~IndexArena() {
+  if (blockCount == 0) return;
+
+  taskENTER_CRITICAL(nullptr);
+  activeArena = nullptr;
+  taskEXIT_CRITICAL(nullptr);
+
+  const size_t used = currentBlock * BLOCK_SIZE + blockOffset;
+  for (size_t i = 0; i < blockCount; i++) {
+    free(blocks[i]);
+  }
+  LOG_DBG("ARN", "Released index arena (%u of %u bytes carved, %u heap fallbacks)", static_cast<unsigned>(used),
+          static_cast<unsigned>(blockCount * BLOCK_SIZE), static_cast<unsigned>(heapFallbacks));
+}
+
+bool IndexArena::owns(const void* ptr) const {
+  const auto* p = static_cast<const uint8_t*>(ptr);
+  for (size_t i = 0; i < blockCount; i++) {
+    if (p >= blocks[i] && p < blocks[i] + BLOCK_SIZE) return true;
+  }
+  return false;
+}
+
+bool IndexArena::usableFromCurrentTask() const { return ownerTask == xTaskGetCurrentTaskHandle(); }
+
+uint8_t* IndexArena::bump(size_t size) {
+  size = alignUp(size);
+  while (currentBlock < blockCount) {
+    // malloc only guarantees 4-byte alignment here, so align the address rather than the offset
+    const auto base = reinterpret_cast<uintptr_t>(blocks[currentBlock]);
+    const size_t start = alignUp(base + blockOffset) - base;
+    if (start + size <= BLOCK_SIZE) {
+      blockOffset = start + size;
+      return blocks[currentBlock] + start;
+    }
+    // The tail of a full block is abandoned
+    currentBlock++;
+    blockOffset = 0;
+  }
+  return nullptr;
+}
+
+size_t IndexArena::sizeClass(const size_t size) {
+  size_t classIndex = 0;
+  while ((MIN_CLASS_SIZE << classIndex) < size) classIndex++;
+  return classIndex;
+}
+
+void* IndexArena::allocateFromClass(const size_t size) {
+  const size_t classIndex = sizeClass(size);
+  if (classIndex >= NUM_CLASSES) return nullptr;
+
+  if (FreeSlot* slot = freeLists[classIndex]) {
+    freeLists[classIndex] = slot->next;
+    return slot;
+  }
+  return bump(MIN_CLASS_SIZE << classIndex);
+}
+
+void* IndexArena::allocate(const size_t size) {
+  if (activeArena && activeArena->usableFromCurrentTask()) {
+    taskENTER_CRITICAL(nullptr);
+    void* ptr = activeArena->allocateFromClass(size);
+    if (!ptr) activeArena->heapFallbacks++;
+    taskEXIT_CRITICAL(nullptr);
+    if (ptr) return ptr;
+  }
+  return ::operator new(size);
+}
+
+void IndexArena::deallocate(void* ptr, const size_t size) {
+  if (!ptr) return;
+  if (activeArena) {
+    bool returned = false;
+    taskENTER_CRITICAL(nullptr);
+    // Re-read under the lock: the arena may have been destroyed by its task in the meantime
+    if (activeArena && activeArena->owns(ptr)) {
+      const size_t classIndex = sizeClass(size);
+      auto* slot = static_cast<FreeSlot*>(ptr);
+      slot->next = activeArena->freeLists[classIndex];
+      activeArena->freeLists[classIndex] = slot;
+      returned = true;
+    }
+    taskEXIT_CRITICAL(nullptr);
+    if (returned) return;
+  }
+  ::operator delete(ptr);
+}
+
+void* IndexArena::rawAlloc(const size_t size) {
+  if (activeArena && activeArena->usableFromCurrentTask()) {
+    taskENTER_CRITICAL(nullptr);
+    uint8_t* block = activeArena->bump(RAW_HEADER_SIZE + size);
+    if (!block) activeArena->heapFallbacks++;
+    taskEXIT_CRITICAL(nullptr);
+    if (block) {
+      *reinterpret_cast<size_t*>(block) = size;
+      return block + RAW_HEADER_SIZE;
+    }
+  }
+  return malloc(size);
+}
+
+void* IndexArena::rawRealloc(void* ptr, const size_t size) {
+  if (!ptr) return rawAlloc(size);
+  if (!activeArena || !activeArena->owns(ptr)) return realloc(ptr, size);
+
+  const size_t oldSize = *reinterpret_cast<size_t*>(static_cast<uint8_t*>(ptr) - RAW_HEADER_SIZE);
+  if (size <= oldSize) return ptr;
+  void* grown = rawAlloc(size);
+  if (grown) memcpy(grown, ptr, oldSize);
+  return grown;
+}
+
+void IndexArena::rawFree(void* ptr) {
+  if (!ptr) return;
+  if (activeArena && activeArena->owns(ptr)) return;
+  free(ptr);
+}
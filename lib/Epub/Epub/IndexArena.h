@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Arena for the transient allocations of one section indexing job: the XML parser's state, ParsedText and its word
+vectors, TextBlock, Page and page elements.
+
+A few large blocks are reserved when the arena is created. Typed allocations are served from per-size-class free
+lists carved out of those blocks, so the interleaved alloc/free pattern of indexing recycles arena memory instead of
+punching holes into the heap. Destroying the arena hands the blocks back in one step, leaving the heap as it was
+before the job. Requests the arena can't serve (too large, arena full, no arena) fall back to the heap.
+
+Only allocations made by the task that created the arena come from it, and everything allocated from it must be
+freed before it is destroyed. Only one arena is active at a time; a second one reserves nothing.
+*/
+class IndexArena {
+ public:
+  IndexArena();
+  ~IndexArena();
+
+  IndexArena(const IndexArena&) = delete;
+  IndexArena& operator=(const IndexArena&) = delete;
+
+  // Typed allocation, for class operator new/delete and Allocator. The size passed to deallocate must match.
+  static void* allocate(size_t size);
+  static void deallocate(void* ptr, size_t size);
+
+  // malloc-style allocation for C libraries (the expat memory suite). Arena memory is bump-allocated and frees are
+  // ignored: parser state lives until the parse ends and comes back with the arena.
+  static void* rawAlloc(size_t size);
+  static void* rawRealloc(void* ptr, size_t size);
+  static void rawFree(void* ptr);
+
+  // Stateless allocator for standard containers built while indexing
+  template <typename T>
+  struct Allocator {
+    using value_type = T;
+
+    Allocator() = default;
+    template <typename U>
+    Allocator(const Allocator<U>&) {}  // rebinding, as standard containers require
+
+    T* allocate(const size_t n) { return static_cast<T*>(IndexArena::allocate(n * sizeof(T))); }
+    void deallocate(T* ptr, const size_t n) { IndexArena::deallocate(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const Allocator<U>&) const {
+      return true;
+    }
+    template <typename U>
+    bool operator!=(const Allocator<U>&) const {
+      return false;
+    }
+  };
+
+ private:
+  static constexpr size_t BLOCK_SIZE = 8 * 1024;
+  static constexpr size_t MAX_BLOCKS = 4;
+  // Only reserve while the heap keeps a block this large free: the 32KB inflate ring plus an image decoder must
+  // still fit while the chapter is indexed
+  static constexpr size_t MIN_LARGEST_FREE_BLOCK = 56 * 1024;
+  // Size classes 16, 32, ... 2048 bytes; larger typed requests go to the heap
+  static constexpr size_t MIN_CLASS_SIZE = 16;
+  static constexpr size_t NUM_CLASSES = 8;
+
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  uint8_t* blocks[MAX_BLOCKS] = {};
+  size_t blockCount = 0;
+  size_t currentBlock = 0;
+  size_t blockOffset = 0;
+  FreeSlot* freeLists[NUM_CLASSES] = {};
+  void* ownerTask = nullptr;
+  size_t heapFallbacks = 0;
+
+  static size_t sizeClass(size_t size);
+  bool owns(const void* ptr) const;
+  uint8_t* bump(size_t size);
+  void* allocateFromClass(size_t size);
+  bool usableFromCurrentTask() const;
+};
+
+template <typename T>
+using IndexVector = std::vector<T, IndexArena::Allocator<T>>;
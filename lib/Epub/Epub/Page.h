@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "FootnoteEntry.h"
+#include "IndexArena.h"
 #include "blocks/ImageBlock.h"
 #include "blocks/TextBlock.h"
 
@@ -21,6 +22,8 @@ class PageElement {
   int16_t yPos;
   explicit PageElement(const int16_t xPos, const int16_t yPos) : xPos(xPos), yPos(yPos) {}
   virtual ~PageElement() = default;
+  static void* operator new(const size_t size) { return IndexArena::allocate(size); }
+  static void operator delete(void* ptr, const size_t size) { IndexArena::deallocate(ptr, size); }
   virtual void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) = 0;
   virtual bool serialize(FsFile& file) = 0;
   virtual PageElementTag getTag() const = 0;  // Add type identification
@@ -61,6 +64,10 @@ class Page {
   std::vector<FootnoteEntry> footnotes;
   static constexpr uint16_t MAX_FOOTNOTES_PER_PAGE = 16;
 
+  // Pages built while indexing come from the section's IndexArena, like their elements
+  static void* operator new(const size_t size) { return IndexArena::allocate(size); }
+  static void operator delete(void* ptr, const size_t size) { IndexArena::deallocate(ptr, size); }
+
   void addFootnote(const char* number, const char* href) {
     if (footnotes.size() >= MAX_FOOTNOTES_PER_PAGE) return;  // Cap per-page footnotes
     FootnoteEntry entry;
@@ -72,6 +79,8 @@ class Page {
   }
 
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) const;
+  // Render only the image elements (plane copies once their panel cache is warm)
+  void renderImages(GfxRenderer& renderer, int xOffset, int yOffset) const;
   bool serialize(FsFile& file) const;
   static std::unique_ptr<Page> deserialize(FsFile& file);
 
@@ -81,6 +90,13 @@ class Page {
                        [](const std::shared_ptr<PageElement>& el) { return el->getTag() == TAG_PageImage; });
   }
 
+  // Check if any text line (of the given line height) overlaps the vertical band [top, top + height)
+  bool hasTextInBand(const int16_t top, const int16_t height, const int lineHeight) const {
+    return std::any_of(elements.begin(), elements.end(), [&](const std::shared_ptr<PageElement>& el) {
+      return el->getTag() == TAG_PageLine && el->yPos < top + height && el->yPos + lineHeight > top;
+    });
+  }
+
   // Get bounding box of all images on the page (union of image rects)
   // Returns false if no images. Coordinates are relative to page origin.
   bool getImageBoundingBox(int16_t& outX, int16_t& outY, int16_t& outW, int16_t& outH) const {
@@ -0,0 +1,105 @@
+#include "PageMap.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <algorithm>
+
+#include "SectionLayoutCache.h"
+
+namespace {
+constexpr uint8_t PAGE_MAP_VERSION = 1;
+constexpr char pageMapFile[] = "/pagemap.bin";
+}  // namespace
+
+void PageMap::load(const std::string& cachePath, const uint16_t spineCount, const uint32_t layoutHash) {
+  filePath = SectionLayoutCache::getLayoutDir(cachePath, layoutHash) + pageMapFile;
+  this->spineCount = spineCount;
+  this->layoutHash = layoutHash;
+  pageCounts.assign(spineCount, UNKNOWN_PAGES);
+  loaded = true;
+
+  FsFile file;
+  if (Storage.openFileForRead("PGM", filePath, file)) {
+    uint8_t version;
+    uint32_t fileLayoutHash;
+    uint16_t fileSpineCount;
+    serialization::readPod(file, version);
+    serialization::readPod(file, fileLayoutHash);
+    serialization::readPod(file, fileSpineCount);
+    if (version == PAGE_MAP_VERSION && fileLayoutHash == layoutHash && fileSpineCount == spineCount) {
+      const size_t bytes = sizeof(uint16_t) * spineCount;
+      if (file.read(reinterpret_cast<uint8_t*>(pageCounts.data()), bytes) != static_cast<int>(bytes)) {
+        LOG_ERR("PGM", "Page map truncated, starting over");
+        pageCounts.assign(spineCount, UNKNOWN_PAGES);
+      }
+    } else {
+      LOG_DBG("PGM", "Page map is for another layout, starting over");
+    }
+    file.close();
+  }
+
+  rebuildPrefix();
+  LOG_DBG("PGM", "Page map: %u of %u sections known, %u pages", knownSections, spineCount, getTotalPages());
+}
+
+void PageMap::setSectionPages(const int spineIndex, const uint16_t pageCount) {
+  if (!loaded || spineIndex < 0 || spineIndex >= spineCount || pageCounts[spineIndex] == pageCount) {
+    return;
+  }
+  pageCounts[spineIndex] = pageCount;
+  rebuildPrefix();
+  save();
+}
+
+uint16_t PageMap::getSectionPages(const int spineIndex) const {
+  if (spineIndex < 0 || spineIndex >= spineCount || pageCounts[spineIndex] == UNKNOWN_PAGES) {
+    return 0;
+  }
+  return pageCounts[spineIndex];
+}
+
+uint32_t PageMap::getBookPage(const int spineIndex, const int page) const {
+  if (spineIndex < 0 || spineIndex >= spineCount) {
+    return 0;
+  }
+  return pagePrefix[spineIndex] + page;
+}
+
+bool PageMap::locateBookPage(const uint32_t bookPage, int& spineIndex, int& page) const {
+  const uint32_t totalPages = getTotalPages();
+  if (totalPages == 0) {
+    return false;
+  }
+  const uint32_t target = std::min(bookPage, totalPages - 1);
+  // Last section starting at or before the target; empty sections share their start with the next one
+  const auto it = std::upper_bound(pagePrefix.begin(), pagePrefix.end() - 1, target);
+  spineIndex = static_cast<int>(it - pagePrefix.begin()) - 1;
+  page = static_cast<int>(target - pagePrefix[spineIndex]);
+  return true;
+}
+
+void PageMap::rebuildPrefix() {
+  pagePrefix.resize(spineCount + 1);
+  pagePrefix[0] = 0;
+  knownSections = 0;
+  for (uint16_t i = 0; i < spineCount; i++) {
+    const bool known = pageCounts[i] != UNKNOWN_PAGES;
+    if (known) knownSections++;
+    pagePrefix[i + 1] = pagePrefix[i] + (known ? pageCounts[i] : 0);
+  }
+}
+
+bool PageMap::save() const {
+  FsFile file;
+  if (!Storage.openFileForWrite("PGM", filePath, file)) {
+    return false;
+  }
+  serialization::writePod(file, PAGE_MAP_VERSION);
+  serialization::writePod(file, layoutHash);
+  serialization::writePod(file, spineCount);
+  file.write(reinterpret_cast<const uint8_t*>(pageCounts.data()), sizeof(uint16_t) * spineCount);
+  file.close();
+  return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Book-wide page map for one layout: the page count of every section, kept next to the layout's section files and
+filled in as sections are indexed. Prefix sums turn (spine, page) into a book page number in O(1) and back with a
+binary search, without loading any section.
+
+Sections that haven't been indexed yet count as zero pages, so book page numbers are only exact once isComplete().
+*/
+class PageMap {
+ public:
+  // Loads the map for the given layout, starting an empty one when the file is missing or for another layout
+  void load(const std::string& cachePath, uint16_t spineCount, uint32_t layoutHash);
+  bool isLoaded(const uint32_t hash) const { return loaded && layoutHash == hash; }
+  uint32_t getLayoutHash() const { return layoutHash; }
+
+  // Records a section's page count and writes the map back when it changed
+  void setSectionPages(int spineIndex, uint16_t pageCount);
+
+  bool isComplete() const { return loaded && knownSections == spineCount; }
+  uint16_t getKnownSectionCount() const { return knownSections; }
+  uint32_t getTotalPages() const { return pagePrefix.empty() ? 0 : pagePrefix.back(); }
+
+  // Page count of a section, 0 when not indexed yet
+  uint16_t getSectionPages(int spineIndex) const;
+  // Zero-based page number in the book
+  uint32_t getBookPage(int spineIndex, int page) const;
+  // Section and page holding a zero-based book page; false when the map has no pages
+  bool locateBookPage(uint32_t bookPage, int& spineIndex, int& page) const;
+
+ private:
+  static constexpr uint16_t UNKNOWN_PAGES = UINT16_MAX;
+
+  std::string filePath;
+  uint32_t layoutHash = 0;
+  uint16_t spineCount = 0;
+  uint16_t knownSections = 0;
+  bool loaded = false;
+  std::vector<uint16_t> pageCounts;  // UNKNOWN_PAGES for sections not indexed yet
+  std::vector<uint32_t> pagePrefix;  // spineCount + 1 entries, pagePrefix[i] = pages before section i
+
+  void rebuildPrefix();
+  bool save() const;
+};
@@ -1,27 +1,67 @@
 #include "Section.h"
 
+#include <AllocTracker.h>
 #include <HalStorage.h>
 #include <Logging.h>
 #include <Serialization.h>
+#include <Trace.h>
+#include <ZipFile.h>
 
+#include <algorithm>
+#include <numeric>
+
+#include "BookAnchorIndex.h"
 #include "Epub/css/CssParser.h"
+#include "IndexArena.h"
 #include "Page.h"
+#include "SectionLayoutCache.h"
 #include "hyphenation/Hyphenator.h"
 #include "parsers/ChapterHtmlSlimParser.h"
 
 namespace {
-constexpr uint8_t SECTION_FILE_VERSION = 18;
+constexpr uint8_t SECTION_FILE_VERSION = 19;
 constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int) + sizeof(float) + sizeof(bool) + sizeof(uint8_t) +
                                  sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(bool) + sizeof(bool) +
                                  sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+// Anchor table entry: hash, page, offset of the anchor string
+constexpr uint32_t ANCHOR_ENTRY_SIZE = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
 }  // namespace
 
+uint32_t Section::layoutHash(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
+                             const uint8_t paragraphAlignment, const uint16_t viewportWidth,
+                             const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
+                             const uint8_t imageRendering) {
+  // FNV-1a over the same fields, in the same order, as the section file header
+  uint32_t hash = ZipFile::fnvHash32(nullptr, 0);  // offset basis
+  const auto mix = [&hash](const auto& value) { hash = ZipFile::fnvHash32(&value, sizeof(value), hash); };
+  mix(SECTION_FILE_VERSION);
+  mix(fontId);
+  mix(lineCompression);
+  mix(extraParagraphSpacing);
+  mix(paragraphAlignment);
+  mix(viewportWidth);
+  mix(viewportHeight);
+  mix(hyphenationEnabled);
+  mix(embeddedStyle);
+  mix(imageRendering);
+  return hash;
+}
+
+void Section::setLayout(const uint32_t layoutHash) {
+  filePath = SectionLayoutCache::getLayoutDir(epub->getCachePath(), layoutHash) + "/" + std::to_string(spineIndex) +
+             ".bin";
+}
+
 uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
   if (!file) {
     LOG_ERR("SCT", "File not open for writing page %d", pageCount);
     return 0;
   }
 
+  for (const auto& footnote : page->footnotes) {
+    footnoteHrefs.emplace_back(footnote.href);
+  }
+
   const uint32_t position = file.position();
   if (!page->serialize(file)) {
     LOG_ERR("SCT", "Failed to serialize page %d", pageCount);
@@ -65,6 +105,8 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
                               const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                               const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
                               const uint8_t imageRendering) {
+  setLayout(layoutHash(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                       viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering));
   if (!Storage.openFileForRead("SCT", filePath, file)) {
     return false;
   }
@@ -135,15 +177,18 @@ bool Section::clearCache() const {
 bool Section::createSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
                                 const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                 const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
-                                const uint8_t imageRendering, const std::function<void()>& popupFn) {
+                                const uint8_t imageRendering, const std::function<void()>& popupFn,
+                                const std::function<bool()>& abortFn) {
+  TRACE_SPAN("section.index");
+  ALLOC_TAG(EpubIndex);
+  const uint32_t hash = layoutHash(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                                   viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering);
+  setLayout(hash);
   const auto localPath = epub->getSpineItem(spineIndex).href;
   const auto tmpHtmlPath = epub->getCachePath() + "/.tmp_" + std::to_string(spineIndex) + ".html";
 
-  // Create cache directory if it doesn't exist
-  {
-    const auto sectionsDir = epub->getCachePath() + "/sections";
-    Storage.mkdir(sectionsDir.c_str());
-  }
+  // Create the layout's cache directory if it doesn't exist
+  Storage.mkdir(SectionLayoutCache::getLayoutDir(epub->getCachePath(), hash).c_str());
 
   // Retry logic for SD card timing issues
   bool success = false;
@@ -187,6 +232,7 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
   writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
                          viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering);
   std::vector<uint32_t> lut = {};
+  footnoteHrefs.clear();
 
   // Derive the content base directory and image cache path prefix for the parser
   size_t lastSlash = localPath.find_last_of('/');
@@ -203,11 +249,13 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
     }
   }
 
+  // Transient allocations of the parse come from the arena; it must outlive the visitor, which frees into it
+  IndexArena arena;
   ChapterHtmlSlimParser visitor(
       epub, tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
       viewportHeight, hyphenationEnabled,
       [this, &lut](std::unique_ptr<Page> page) { lut.emplace_back(this->onPageComplete(std::move(page))); },
-      embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser);
+      embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser, abortFn);
   Hyphenator::setPreferredLanguage(epub->getLanguage());
   success = visitor.parseAndBuildPages();
 
@@ -240,13 +288,29 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
     return false;
   }
 
-  // Write anchor-to-page map for fragment navigation (e.g. footnote targets)
+  // Write anchor-to-page map for fragment navigation (e.g. footnote targets): fixed-size entries sorted by anchor
+  // hash for a binary search, then the anchor strings to verify a match
   const uint32_t anchorMapOffset = file.position();
   const auto& anchors = visitor.getAnchors();
-  serialization::writePod(file, static_cast<uint16_t>(anchors.size()));
-  for (const auto& [anchor, page] : anchors) {
-    serialization::writeString(file, anchor);
-    serialization::writePod(file, page);
+  const uint16_t anchorCount = static_cast<uint16_t>(std::min<size_t>(anchors.size(), UINT16_MAX));
+  std::vector<uint32_t> anchorHashes(anchorCount);
+  std::vector<uint16_t> anchorOrder(anchorCount);
+  for (uint16_t i = 0; i < anchorCount; i++) {
+    anchorHashes[i] = BookAnchorIndex::hashAnchor(anchors[i].first);
+  }
+  std::iota(anchorOrder.begin(), anchorOrder.end(), 0);
+  std::sort(anchorOrder.begin(), anchorOrder.end(),
+            [&anchorHashes](const uint16_t a, const uint16_t b) { return anchorHashes[a] < anchorHashes[b]; });
+  serialization::writePod(file, anchorCount);
+  uint32_t stringOffset = anchorMapOffset + sizeof(anchorCount) + ANCHOR_ENTRY_SIZE * anchorCount;
+  for (const uint16_t i : anchorOrder) {
+    serialization::writePod(file, anchorHashes[i]);
+    serialization::writePod(file, anchors[i].second);
+    serialization::writePod(file, stringOffset);
+    stringOffset += sizeof(uint32_t) + anchors[i].first.size();
+  }
+  for (const uint16_t i : anchorOrder) {
+    serialization::writeString(file, anchors[i].first);
   }
 
   // Patch header with final pageCount, lutOffset, and anchorMapOffset
@@ -258,10 +322,13 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
   if (cssParser) {
     cssParser->clear();
   }
+  BookAnchorIndex::addSection(epub->getCachePath(), hash, static_cast<uint16_t>(epub->getSpineItemsCount()),
+                              spineIndex, anchors);
   return true;
 }
 
-std::unique_ptr<Page> Section::loadPageFromSectionFile() {
+std::unique_ptr<Page> Section::loadPageFromSectionFile(const int pageIndex) {
+  TRACE_SPAN("page.load");
   if (!Storage.openFileForRead("SCT", filePath, file)) {
     return nullptr;
   }
@@ -269,7 +336,7 @@ std::unique_ptr<Page> Section::loadPageFromSectionFile() {
   file.seek(HEADER_SIZE - sizeof(uint32_t) * 2);
   uint32_t lutOffset;
   serialization::readPod(file, lutOffset);
-  file.seek(lutOffset + sizeof(uint32_t) * currentPage);
+  file.seek(lutOffset + sizeof(uint32_t) * pageIndex);
   uint32_t pagePos;
   serialization::readPod(file, pagePos);
   file.seek(pagePos);
@@ -297,11 +364,42 @@ std::optional<uint16_t> Section::getPageForAnchor(const std::string& anchor) con
   f.seek(anchorMapOffset);
   uint16_t count;
   serialization::readPod(f, count);
-  for (uint16_t i = 0; i < count; i++) {
-    std::string key;
+  const uint32_t tableOffset = anchorMapOffset + sizeof(count);
+  const uint32_t hash = BookAnchorIndex::hashAnchor(anchor);
+
+  // First entry with the hash
+  uint16_t low = 0;
+  uint16_t high = count;
+  while (low < high) {
+    const uint16_t mid = low + (high - low) / 2;
+    uint32_t midHash;
+    f.seek(tableOffset + ANCHOR_ENTRY_SIZE * mid);
+    serialization::readPod(f, midHash);
+    if (midHash < hash) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  // Hash collisions are told apart by the strings
+  for (uint16_t i = low; i < count; i++) {
+    uint32_t entryHash;
     uint16_t page;
-    serialization::readString(f, key);
+    uint32_t stringOffset;
+    f.seek(tableOffset + ANCHOR_ENTRY_SIZE * i);
+    serialization::readPod(f, entryHash);
+    if (entryHash != hash) {
+      break;
+    }
     serialization::readPod(f, page);
+    serialization::readPod(f, stringOffset);
+    if (stringOffset >= fileSize) {
+      break;
+    }
+    std::string key;
+    f.seek(stringOffset);
+    serialization::readString(f, key);
     if (key == anchor) {
       f.close();
       return page;
@@ -3,6 +3,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "Epub.h"
 
@@ -13,8 +14,11 @@ class Section {
   std::shared_ptr<Epub> epub;
   const int spineIndex;
   GfxRenderer& renderer;
-  std::string filePath;
+  std::string filePath;  // set by loadSectionFile() and createSectionFile() for their layout
   FsFile file;
+  std::vector<std::string> footnoteHrefs;  // links to notes, collected while building the section file
+
+  void setLayout(uint32_t layoutHash);
 
   void writeSectionFileHeader(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                               uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
@@ -26,10 +30,7 @@ class Section {
   int currentPage = 0;
 
   explicit Section(const std::shared_ptr<Epub>& epub, const int spineIndex, GfxRenderer& renderer)
-      : epub(epub),
-        spineIndex(spineIndex),
-        renderer(renderer),
-        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin") {}
+      : epub(epub), spineIndex(spineIndex), renderer(renderer) {}
   ~Section() = default;
   bool loadSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                        uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
@@ -37,9 +38,19 @@ class Section {
   bool clearCache() const;
   bool createSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                          uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
-                         uint8_t imageRendering, const std::function<void()>& popupFn = nullptr);
-  std::unique_ptr<Page> loadPageFromSectionFile();
+                         uint8_t imageRendering, const std::function<void()>& popupFn = nullptr,
+                         const std::function<bool()>& abortFn = nullptr);
+  std::unique_ptr<Page> loadPageFromSectionFile() { return loadPageFromSectionFile(currentPage); }
+  std::unique_ptr<Page> loadPageFromSectionFile(int pageIndex);
+
+  // Footnote links of the section, only known after createSectionFile()
+  const std::vector<std::string>& getFootnoteHrefs() const { return footnoteHrefs; }
 
   // Look up the page number for an anchor id from the section cache file.
   std::optional<uint16_t> getPageForAnchor(const std::string& anchor) const;
+
+  // Identifies the layout a section file is built for (and the section file version), for book-wide caches
+  static uint32_t layoutHash(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
+                             uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
+                             bool embeddedStyle, uint8_t imageRendering);
 };
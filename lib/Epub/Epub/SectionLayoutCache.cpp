@@ -0,0 +1,64 @@
+#include "SectionLayoutCache.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+constexpr uint8_t LAYOUTS_FILE_VERSION = 1;
+constexpr char layoutsFile[] = "/sections/layouts.bin";
+}  // namespace
+
+std::string SectionLayoutCache::getLayoutDir(const std::string& cachePath, const uint32_t layoutHash) {
+  char name[9];
+  snprintf(name, sizeof(name), "%08x", static_cast<unsigned>(layoutHash));
+  return cachePath + "/sections/" + name;
+}
+
+void SectionLayoutCache::touch(const std::string& cachePath, const uint32_t layoutHash) {
+  std::vector<uint32_t> layouts;
+  FsFile file;
+  if (Storage.openFileForRead("SLC", cachePath + layoutsFile, file)) {
+    uint8_t version;
+    uint8_t count;
+    serialization::readPod(file, version);
+    serialization::readPod(file, count);
+    if (version == LAYOUTS_FILE_VERSION) {
+      layouts.resize(count);
+      for (auto& hash : layouts) {
+        serialization::readPod(file, hash);
+      }
+    }
+    file.close();
+  } else {
+    // No layout list: sections/ is empty or holds section files from before per-layout directories
+    Storage.removeDir((cachePath + "/sections").c_str());
+  }
+
+  if (!layouts.empty() && layouts.front() == layoutHash) {
+    return;
+  }
+
+  layouts.erase(std::remove(layouts.begin(), layouts.end(), layoutHash), layouts.end());
+  layouts.insert(layouts.begin(), layoutHash);
+  while (layouts.size() > MAX_LAYOUTS) {
+    LOG_DBG("SLC", "Evicting layout %08x", static_cast<unsigned>(layouts.back()));
+    Storage.removeDir(getLayoutDir(cachePath, layouts.back()).c_str());
+    layouts.pop_back();
+  }
+
+  Storage.mkdir((cachePath + "/sections").c_str());
+  if (!Storage.openFileForWrite("SLC", cachePath + layoutsFile, file)) {
+    return;
+  }
+  serialization::writePod(file, LAYOUTS_FILE_VERSION);
+  serialization::writePod(file, static_cast<uint8_t>(layouts.size()));
+  for (const uint32_t hash : layouts) {
+    serialization::writePod(file, hash);
+  }
+  file.close();
+}
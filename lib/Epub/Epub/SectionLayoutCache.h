@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+Section files are kept per layout in <cache>/sections/<layoutHash>/, so switching between a few layouts (font, size,
+margins, ...) reuses the sections already built for each of them. sections/layouts.bin lists the layouts of the book
+most recently used first; using a new layout drops the least recently used one past MAX_LAYOUTS.
+*/
+class SectionLayoutCache {
+ public:
+  static constexpr uint8_t MAX_LAYOUTS = 3;
+
+  // Directory holding the section files and page map of one layout
+  static std::string getLayoutDir(const std::string& cachePath, uint32_t layoutHash);
+  // Marks the layout as the most recently used one, evicting the least recently used layouts over the quota
+  static void touch(const std::string& cachePath, uint32_t layoutHash);
+};
@@ -0,0 +1,53 @@
+#include "TocWindowCache.h"
+
+#include <Logging.h>
+
+#include <algorithm>
+
+#include "Epub.h"
+
+TocWindowCache::TocWindowCache(std::shared_ptr<Epub> epub, const int windowSize)
+    : epub(std::move(epub)), windowSize(std::max(1, windowSize)) {
+  tocCount = this->epub ? this->epub->getTocItemsCount() : 0;
+}
+
+const BookMetadataCache::TocEntry* TocWindowCache::get(const int tocIndex) {
+  if (tocIndex < 0 || tocIndex >= tocCount) {
+    return nullptr;
+  }
+  Window* window = getWindow(tocIndex / windowSize * windowSize);
+  const int offset = tocIndex - (window ? window->first : 0);
+  if (!window || offset >= static_cast<int>(window->entries.size())) {
+    return nullptr;
+  }
+  window->lastUse = ++useClock;
+  return &window->entries[offset];
+}
+
+void TocWindowCache::prefetch(const int tocIndex, const bool forward) {
+  const int first = (tocIndex / windowSize + (forward ? 1 : -1)) * windowSize;
+  if (first < 0 || first >= tocCount) {
+    return;
+  }
+  getWindow(first);
+}
+
+TocWindowCache::Window* TocWindowCache::getWindow(const int first) {
+  for (auto& window : windows) {
+    if (window.first == first) {
+      return &window;
+    }
+  }
+
+  // Replace the least recently used window
+  Window& window = *std::min_element(std::begin(windows), std::end(windows),
+                                     [](const Window& a, const Window& b) { return a.lastUse < b.lastUse; });
+  window.first = -1;
+  if (!epub->getTocItems(first, windowSize, window.entries)) {
+    LOG_ERR("TOC", "Failed to read TOC entries %d-%d", first, first + windowSize - 1);
+    return nullptr;
+  }
+  window.first = first;
+  window.lastUse = ++useClock;
+  return &window;
+}
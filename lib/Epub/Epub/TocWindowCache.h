@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BookMetadataCache.h"
+
+class Epub;
+
+/*
+Cursor over a book's TOC for lists that scroll through it, without loading the whole TOC.
+
+Entries are read in windows of windowSize consecutive entries, each one block read from book.bin. A few windows are
+kept, so moving around the visible page never touches the SD card, and the window next to it can be prefetched while
+the page is on screen so paging that way doesn't either.
+*/
+class TocWindowCache {
+ public:
+  TocWindowCache(std::shared_ptr<Epub> epub, int windowSize);
+
+  // Entry at tocIndex, reading its window when it isn't cached. Null when out of range.
+  const BookMetadataCache::TocEntry* get(int tocIndex);
+  // Reads the window after (forward) or before the one holding tocIndex
+  void prefetch(int tocIndex, bool forward);
+
+ private:
+  static constexpr int MAX_WINDOWS = 3;
+
+  struct Window {
+    int first = -1;
+    uint32_t lastUse = 0;
+    std::vector<BookMetadataCache::TocEntry> entries;
+  };
+
+  std::shared_ptr<Epub> epub;
+  int windowSize;
+  int tocCount;
+  uint32_t useClock = 0;
+  Window windows[MAX_WINDOWS];
+
+  // Cached window starting at first, read when missing
+  Window* getWindow(int first);
+};
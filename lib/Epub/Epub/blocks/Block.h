@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../IndexArena.h"
+
 class GfxRenderer;
 
 typedef enum { TEXT_BLOCK, IMAGE_BLOCK } BlockType;
@@ -9,6 +11,10 @@ class Block {
  public:
   virtual ~Block() = default;
 
+  // Blocks built while indexing come from the section's IndexArena
+  static void* operator new(const size_t size) { return IndexArena::allocate(size); }
+  static void operator delete(void* ptr, const size_t size) { IndexArena::deallocate(ptr, size); }
+
   virtual BlockType getType() = 0;
   virtual bool isEmpty() = 0;
   virtual void finish() {}
@@ -4,6 +4,9 @@
 #include <Logging.h>
 #include <Serialization.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "../converters/DitherUtils.h"
 #include "../converters/ImageDecoderFactory.h"
 
@@ -11,6 +14,15 @@
 // - uint16_t width
 // - uint16_t height
 // - uint8_t pixels[...] - 2 bits per pixel, packed (4 pixels per byte), row-major order
+//
+// Panel cache file format (.ppc, derived from the pixel cache for one orientation and position, deleted whenever the
+// pixel cache is rewritten):
+// - uint8_t version
+// - uint8_t orientation
+// - int16_t x, y     - logical render position
+// - uint16_t width, height
+// - uint8_t planes[3][rowBytes * physicalHeight] - BW, LSB, MSB ink masks (RenderMode order), already rotated
+//   into panel space and aligned to framebuffer byte columns, so rendering is a masked row copy
 
 ImageBlock::ImageBlock(const std::string& imagePath, int16_t width, int16_t height)
     : imagePath(imagePath), width(width), height(height) {}
@@ -19,13 +31,200 @@ bool ImageBlock::imageExists() const { return Storage.exists(imagePath.c_str());
 
 namespace {
 
-std::string getCachePath(const std::string& imagePath) {
-  // Replace extension with .pxc (pixel cache)
+constexpr uint8_t PANEL_CACHE_VERSION = 1;
+constexpr size_t PANEL_CACHE_HEADER_SIZE = 10;
+constexpr int PANEL_CACHE_PLANES = 3;
+constexpr size_t PANEL_CACHE_CHUNK_BYTES = 4096;
+
+std::string getCachePath(const std::string& imagePath, const char* extension) {
+  // Replace extension with .pxc (pixel cache) or .ppc (panel plane cache)
   size_t dotPos = imagePath.rfind('.');
   if (dotPos != std::string::npos) {
-    return imagePath.substr(0, dotPos) + ".pxc";
+    return imagePath.substr(0, dotPos) + extension;
+  }
+  return imagePath + extension;
+}
+
+// Physical panel rectangle covered by a logical image rect, in framebuffer byte columns
+struct PanelRect {
+  int byteX;
+  int phyX;  // first physical column (bit 0 of each mask row is byteX * 8)
+  int phyY;
+  int rowBytes;
+  int rows;
+};
+
+PanelRect getPanelRect(const GfxRenderer& renderer, int x, int y, int width, int height) {
+  int x0, y0, x1, y1;
+  renderer.toPhysical(x, y, &x0, &y0);
+  renderer.toPhysical(x + width - 1, y + height - 1, &x1, &y1);
+  const int minX = std::min(x0, x1);
+  const int maxX = std::max(x0, x1);
+  const int minY = std::min(y0, y1);
+  const int maxY = std::max(y0, y1);
+
+  PanelRect rect;
+  rect.byteX = minX / 8;
+  rect.phyX = rect.byteX * 8;
+  rect.phyY = minY;
+  rect.rowBytes = maxX / 8 - rect.byteX + 1;
+  rect.rows = maxY - minY + 1;
+  return rect;
+}
+
+// Which 2-bit cache values put ink into the plane for a render mode (mirrors drawPixelWithRenderMode)
+bool isInked(int plane, uint8_t pixelValue) {
+  switch (plane) {
+    case GfxRenderer::BW:
+      return pixelValue < 3;
+    case GfxRenderer::GRAYSCALE_LSB:
+      return pixelValue == 1;
+    case GfxRenderer::GRAYSCALE_MSB:
+      return pixelValue == 1 || pixelValue == 2;
+  }
+  return false;
+}
+
+bool renderFromPanelCache(GfxRenderer& renderer, const std::string& panelPath, int x, int y, int expectedWidth,
+                          int expectedHeight) {
+  FsFile panelFile;
+  if (!Storage.exists(panelPath.c_str()) || !Storage.openFileForRead("IMG", panelPath, panelFile)) {
+    return false;
+  }
+
+  uint8_t version, orientation;
+  int16_t cachedX, cachedY;
+  uint16_t cachedWidth, cachedHeight;
+  serialization::readPod(panelFile, version);
+  serialization::readPod(panelFile, orientation);
+  serialization::readPod(panelFile, cachedX);
+  serialization::readPod(panelFile, cachedY);
+  serialization::readPod(panelFile, cachedWidth);
+  serialization::readPod(panelFile, cachedHeight);
+
+  // Planes are only valid for the orientation and position they were rotated for
+  if (version != PANEL_CACHE_VERSION || orientation != renderer.getOrientation() || cachedX != x || cachedY != y ||
+      abs(cachedWidth - expectedWidth) > 1 || abs(cachedHeight - expectedHeight) > 1) {
+    LOG_DBG("IMG", "Panel cache stale: %s", panelPath.c_str());
+    panelFile.close();
+    return false;
+  }
+
+  const PanelRect rect = getPanelRect(renderer, x, y, cachedWidth, cachedHeight);
+  const size_t planeBytes = static_cast<size_t>(rect.rowBytes) * rect.rows;
+  if (panelFile.size() != PANEL_CACHE_HEADER_SIZE + planeBytes * PANEL_CACHE_PLANES) {
+    LOG_ERR("IMG", "Panel cache size mismatch: %s", panelPath.c_str());
+    panelFile.close();
+    return false;
+  }
+
+  const int chunkRows = std::max(1, std::min(rect.rows, static_cast<int>(PANEL_CACHE_CHUNK_BYTES / rect.rowBytes)));
+  uint8_t* chunk = static_cast<uint8_t*>(malloc(static_cast<size_t>(chunkRows) * rect.rowBytes));
+  if (!chunk) {
+    LOG_ERR("IMG", "Failed to allocate panel cache chunk");
+    panelFile.close();
+    return false;
+  }
+
+  panelFile.seek(PANEL_CACHE_HEADER_SIZE + planeBytes * renderer.getRenderMode());
+  for (int row = 0; row < rect.rows; row += chunkRows) {
+    const int rows = std::min(chunkRows, rect.rows - row);
+    const int bytes = rows * rect.rowBytes;
+    if (panelFile.read(chunk, bytes) != bytes) {
+      // Rows already copied are identical to what a cache replay would draw, so falling back is safe
+      LOG_ERR("IMG", "Panel cache read error at row %d", row);
+      free(chunk);
+      panelFile.close();
+      return false;
+    }
+    renderer.drawPhysicalMask(rect.byteX, rect.phyY + row, rect.rowBytes, rows, chunk);
+  }
+
+  free(chunk);
+  panelFile.close();
+  return true;
+}
+
+// Derive the panel plane cache from the 2-bit pixel cache. One plane is built at a time to keep the peak
+// allocation at most one framebuffer-sized mask.
+bool buildPanelCache(const GfxRenderer& renderer, const std::string& cachePath, const std::string& panelPath, int x,
+                     int y) {
+  FsFile cacheFile;
+  if (!Storage.openFileForRead("IMG", cachePath, cacheFile)) {
+    return false;
+  }
+
+  uint16_t width, height;
+  if (cacheFile.read(&width, 2) != 2 || cacheFile.read(&height, 2) != 2 || width == 0 || height == 0) {
+    cacheFile.close();
+    return false;
+  }
+
+  const PanelRect rect = getPanelRect(renderer, x, y, width, height);
+  const size_t planeBytes = static_cast<size_t>(rect.rowBytes) * rect.rows;
+  const int bytesPerRow = (width + 3) / 4;
+  uint8_t* plane = static_cast<uint8_t*>(malloc(planeBytes));
+  uint8_t* rowBuffer = static_cast<uint8_t*>(malloc(bytesPerRow));
+  if (!plane || !rowBuffer) {
+    LOG_ERR("IMG", "Not enough memory for panel cache (%d bytes)", planeBytes);
+    free(plane);
+    free(rowBuffer);
+    cacheFile.close();
+    return false;
+  }
+
+  FsFile panelFile;
+  if (!Storage.openFileForWrite("IMG", panelPath, panelFile)) {
+    free(plane);
+    free(rowBuffer);
+    cacheFile.close();
+    return false;
   }
-  return imagePath + ".pxc";
+
+  serialization::writePod(panelFile, PANEL_CACHE_VERSION);
+  serialization::writePod(panelFile, static_cast<uint8_t>(renderer.getOrientation()));
+  serialization::writePod(panelFile, static_cast<int16_t>(x));
+  serialization::writePod(panelFile, static_cast<int16_t>(y));
+  serialization::writePod(panelFile, width);
+  serialization::writePod(panelFile, height);
+
+  bool ok = true;
+  for (int p = 0; p < PANEL_CACHE_PLANES && ok; p++) {
+    memset(plane, 0, planeBytes);
+    cacheFile.seek(4);
+    for (int row = 0; row < height; row++) {
+      if (cacheFile.read(rowBuffer, bytesPerRow) != bytesPerRow) {
+        ok = false;
+        break;
+      }
+      for (int col = 0; col < width; col++) {
+        const uint8_t pixelValue = (rowBuffer[col / 4] >> (6 - (col % 4) * 2)) & 0x03;
+        if (!isInked(p, pixelValue)) continue;
+
+        int phyX, phyY;
+        renderer.toPhysical(x + col, y + row, &phyX, &phyY);
+        const int localX = phyX - rect.phyX;
+        plane[(phyY - rect.phyY) * rect.rowBytes + localX / 8] |= 0x80 >> (localX % 8);
+      }
+    }
+    if (ok && panelFile.write(plane, planeBytes) != planeBytes) {
+      ok = false;
+    }
+  }
+
+  free(plane);
+  free(rowBuffer);
+  cacheFile.close();
+  panelFile.close();
+
+  if (!ok) {
+    LOG_ERR("IMG", "Failed to build panel cache: %s", panelPath.c_str());
+    Storage.remove(panelPath.c_str());
+    return false;
+  }
+
+  LOG_DBG("IMG", "Panel cache written: %s (%d bytes/plane)", panelPath.c_str(), planeBytes);
+  return true;
 }
 
 bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x, int y, int expectedWidth,
@@ -105,9 +304,16 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
     return;
   }
 
-  // Try to render from cache first
-  std::string cachePath = getCachePath(imagePath);
+  // Fastest path: planes already rotated and split for this orientation, copied straight into the framebuffer
+  const std::string panelPath = getCachePath(imagePath, ".ppc");
+  if (renderFromPanelCache(renderer, panelPath, x, y, width, height)) {
+    return;
+  }
+
+  // Try to render from the pixel cache, then derive the panel cache for the following passes and page turns
+  std::string cachePath = getCachePath(imagePath, ".pxc");
   if (renderFromCache(renderer, cachePath, x, y, width, height)) {
+    buildPanelCache(renderer, cachePath, panelPath, x, y);
     return;  // Successfully rendered from cache
   }
 
@@ -126,6 +332,11 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
     return;
   }
 
+  // This decode rewrites the pixel cache, so panel planes derived from the previous one must not be served again
+  if (Storage.exists(panelPath.c_str())) {
+    Storage.remove(panelPath.c_str());
+  }
+
   LOG_DBG("IMG", "Decoding and caching: %s", imagePath.c_str());
 
   RenderConfig config;
@@ -73,9 +73,9 @@ bool TextBlock::serialize(FsFile& file) const {
 
 std::unique_ptr<TextBlock> TextBlock::deserialize(FsFile& file) {
   uint16_t wc;
-  std::vector<std::string> words;
-  std::vector<int16_t> wordXpos;
-  std::vector<EpdFontFamily::Style> wordStyles;
+  IndexVector<std::string> words;
+  IndexVector<int16_t> wordXpos;
+  IndexVector<EpdFontFamily::Style> wordStyles;
   BlockStyle blockStyle;
 
   // Word count
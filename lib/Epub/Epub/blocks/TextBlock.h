@@ -9,17 +9,21 @@
 #include "Block.h"
 #include "BlockStyle.h"
 
-// Represents a line of text on a page
+// Represents a line of text on a page.
+// The word containers use the IndexArena allocator: blocks built while a section is indexed keep their words in the
+// arena and must be destroyed before it (pages are written and freed inside Section::createSectionFile()). Blocks
+// read back with deserialize() outside an arena live on the heap. The containers aren't handed out, so no copy of
+// them can outlive the arena.
 class TextBlock final : public Block {
  private:
-  std::vector<std::string> words;
-  std::vector<int16_t> wordXpos;
-  std::vector<EpdFontFamily::Style> wordStyles;
+  IndexVector<std::string> words;
+  IndexVector<int16_t> wordXpos;
+  IndexVector<EpdFontFamily::Style> wordStyles;
   BlockStyle blockStyle;
 
  public:
-  explicit TextBlock(std::vector<std::string> words, std::vector<int16_t> word_xpos,
-                     std::vector<EpdFontFamily::Style> word_styles, const BlockStyle& blockStyle = BlockStyle())
+  explicit TextBlock(IndexVector<std::string> words, IndexVector<int16_t> word_xpos,
+                     IndexVector<EpdFontFamily::Style> word_styles, const BlockStyle& blockStyle = BlockStyle())
       : words(std::move(words)),
         wordXpos(std::move(word_xpos)),
         wordStyles(std::move(word_styles)),
@@ -27,7 +31,7 @@ class TextBlock final : public Block {
   ~TextBlock() override = default;
   void setBlockStyle(const BlockStyle& blockStyle) { this->blockStyle = blockStyle; }
   const BlockStyle& getBlockStyle() const { return blockStyle; }
-  const std::vector<std::string>& getWords() const { return words; }
+  const std::string& getWord(const size_t index) const { return words[index]; }
   bool isEmpty() override { return words.empty(); }
   size_t wordCount() const { return words.size(); }
   // given a renderer works out where to break the words into lines
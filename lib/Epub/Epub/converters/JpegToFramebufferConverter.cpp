@@ -1,10 +1,12 @@
 #include "JpegToFramebufferConverter.h"
 
+#include <AllocTracker.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <JPEGDEC.h>
 #include <Logging.h>
+#include <MemoryBudget.h>
 
 #include <cstdlib>
 #include <new>
@@ -135,7 +137,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
 
   if (stride <= 0 || blockH <= 0 || validW <= 0) return 1;
 
-  const bool useDithering = ctx->config->useDithering;
+  const OrderedDitherer ditherer(ctx->config->useDithering);
   const bool caching = ctx->caching;
   const int32_t fineScaleFP = ctx->fineScaleFP;
   const int32_t invScaleFP = ctx->invScaleFP;
@@ -175,13 +177,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
       for (int dstX = dstXStart; dstX < dstXEnd; dstX++) {
         const int outX = cfgX + dstX;
         uint8_t gray = row[dstX - blockX];
-        uint8_t dithered;
-        if (useDithering) {
-          dithered = applyBayerDither4Level(gray, outX, outY);
-        } else {
-          dithered = gray / 85;
-          if (dithered > 3) dithered = 3;
-        }
+        const uint8_t dithered = ditherer.processPixel(gray, outX, outY);
         drawPixelWithRenderMode(renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
@@ -232,13 +228,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
         int bot = ((int)row1[lx0] * fxInv + (int)row1[lx1] * fx) >> FP_SHIFT;
         uint8_t gray = (uint8_t)((top * fyInv + bot * fy) >> FP_SHIFT);
 
-        uint8_t dithered;
-        if (useDithering) {
-          dithered = applyBayerDither4Level(gray, outX, outY);
-        } else {
-          dithered = gray / 85;
-          if (dithered > 3) dithered = 3;
-        }
+        const uint8_t dithered = ditherer.processPixel(gray, outX, outY);
         drawPixelWithRenderMode(renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
@@ -255,13 +245,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
         int bot = ((int)row1[lx0] * fxInv + (int)row1[lx0 + 1] * fx) >> FP_SHIFT;
         uint8_t gray = (uint8_t)((top * fyInv + bot * fy) >> FP_SHIFT);
 
-        uint8_t dithered;
-        if (useDithering) {
-          dithered = applyBayerDither4Level(gray, outX, outY);
-        } else {
-          dithered = gray / 85;
-          if (dithered > 3) dithered = 3;
-        }
+        const uint8_t dithered = ditherer.processPixel(gray, outX, outY);
         drawPixelWithRenderMode(renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
@@ -281,13 +265,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
         int bot = ((int)row1[lx0] * fxInv + (int)row1[lx1] * fx) >> FP_SHIFT;
         uint8_t gray = (uint8_t)((top * fyInv + bot * fy) >> FP_SHIFT);
 
-        uint8_t dithered;
-        if (useDithering) {
-          dithered = applyBayerDither4Level(gray, outX, outY);
-        } else {
-          dithered = gray / 85;
-          if (dithered > 3) dithered = 3;
-        }
+        const uint8_t dithered = ditherer.processPixel(gray, outX, outY);
         drawPixelWithRenderMode(renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
@@ -312,13 +290,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
       if (lx >= validW) lx = validW - 1;
       uint8_t gray = row[lx];
 
-      uint8_t dithered;
-      if (useDithering) {
-        dithered = applyBayerDither4Level(gray, outX, outY);
-      } else {
-        dithered = gray / 85;
-        if (dithered > 3) dithered = 3;
-      }
+      const uint8_t dithered = ditherer.processPixel(gray, outX, outY);
       drawPixelWithRenderMode(renderer, outX, outY, dithered);
       if (caching) ctx->cache.setPixel(outX, outY, dithered);
     }
@@ -361,7 +333,9 @@ bool JpegToFramebufferConverter::getDimensionsStatic(const std::string& imagePat
 bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath, GfxRenderer& renderer,
                                                      const RenderConfig& config) {
   LOG_DBG("JPG", "Decoding JPEG: %s", imagePath.c_str());
+  ALLOC_TAG(Images);
 
+  MemBudget.makeRoom("JPG", MIN_FREE_HEAP_FOR_JPEG, JPEG_DECODER_APPROX_SIZE, MemoryBudget::Priority::High);
   size_t freeHeap = ESP.getFreeHeap();
   if (freeHeap < MIN_FREE_HEAP_FOR_JPEG) {
     LOG_ERR("JPG", "Not enough heap for JPEG decoder (%u free, need %u)", freeHeap, MIN_FREE_HEAP_FOR_JPEG);
@@ -2,6 +2,7 @@
 
 #include <HalStorage.h>
 #include <Logging.h>
+#include <MemoryBudget.h>
 #include <stdint.h>
 
 #include <cstring>
@@ -34,7 +35,7 @@ struct PixelCache {
       LOG_ERR("IMG", "Cache buffer too large: %d bytes for %dx%d (limit %d)", bufferSize, w, h, MAX_CACHE_BYTES);
       return false;
     }
-    buffer = (uint8_t*)malloc(bufferSize);
+    buffer = (uint8_t*)MemBudget.allocate("pixel cache", bufferSize, MemoryBudget::Priority::Medium);
     if (buffer) {
       memset(buffer, 0, bufferSize);
       LOG_DBG("IMG", "Allocated cache buffer: %d bytes for %dx%d", bufferSize, w, h);
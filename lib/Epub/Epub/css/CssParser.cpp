@@ -10,30 +10,6 @@
 
 namespace {
 
-// Stack-allocated string buffer to avoid heap reallocations during parsing
-// Provides string-like interface with fixed capacity
-struct StackBuffer {
-  static constexpr size_t CAPACITY = 1024;
-  char data[CAPACITY];
-  size_t len = 0;
-
-  void push_back(char c) {
-    if (len < CAPACITY - 1) {
-      data[len++] = c;
-    }
-  }
-
-  void clear() { len = 0; }
-  bool empty() const { return len == 0; }
-  size_t size() const { return len; }
-
-  // Get string view of current content (zero-copy)
-  std::string_view view() const { return std::string_view(data, len); }
-
-  // Convert to string for passing to functions (single allocation)
-  std::string str() const { return std::string(data, len); }
-};
-
 // Buffer size for reading CSS files
 constexpr size_t READ_BUFFER_SIZE = 512;
 
@@ -439,144 +415,135 @@ bool CssParser::loadFromStream(FsFile& source) {
     return false;
   }
 
-  size_t totalRead = 0;
-
-  // Use stack-allocated buffers for parsing to avoid heap reallocations
-  StackBuffer selector;
-  StackBuffer declBuffer;
-  // Keep these as std::string since they're passed by reference to parseDeclarationIntoStyle
-  std::string propNameBuf;
-  std::string propValueBuf;
+  StreamLoader loader(*this);
+  uint8_t buffer[READ_BUFFER_SIZE];
+  while (source.available()) {
+    const int bytesRead = source.read(buffer, sizeof(buffer));
+    if (bytesRead <= 0) break;
+    loader.write(buffer, static_cast<size_t>(bytesRead));
+  }
+  loader.finish();
+  return true;
+}
 
-  bool inComment = false;
-  bool maybeSlash = false;
-  bool prevStar = false;
-
-  bool inAtRule = false;
-  int atDepth = 0;
-
-  int bodyDepth = 0;
-  bool skippingRule = false;
-  CssStyle currentStyle;
-
-  auto handleChar = [&](const char c) {
-    if (inAtRule) {
-      if (c == '{') {
-        ++atDepth;
-      } else if (c == '}') {
-        if (atDepth > 0) --atDepth;
-        if (atDepth == 0) inAtRule = false;
-      } else if (c == ';' && atDepth == 0) {
-        inAtRule = false;
-      }
-      return;
+void CssParser::StreamLoader::handleChar(const char c) {
+  if (inAtRule) {
+    if (c == '{') {
+      ++atDepth;
+    } else if (c == '}') {
+      if (atDepth > 0) --atDepth;
+      if (atDepth == 0) inAtRule = false;
+    } else if (c == ';' && atDepth == 0) {
+      inAtRule = false;
     }
+    return;
+  }
 
-    if (bodyDepth == 0) {
-      if (selector.empty() && isCssWhitespace(c)) {
-        return;
-      }
-      if (c == '@' && selector.empty()) {
-        inAtRule = true;
-        atDepth = 0;
-        return;
-      }
-      if (c == '{') {
-        bodyDepth = 1;
-        currentStyle = CssStyle{};
-        declBuffer.clear();
-        if (selector.size() > MAX_SELECTOR_LENGTH * 4) {
-          skippingRule = true;
-        }
-        return;
-      }
-      selector.push_back(c);
+  if (bodyDepth == 0) {
+    if (selector.empty() && isCssWhitespace(c)) {
       return;
     }
-
-    // bodyDepth > 0
-    if (c == '{') {
-      ++bodyDepth;
+    if (c == '@' && selector.empty()) {
+      inAtRule = true;
+      atDepth = 0;
       return;
     }
-    if (c == '}') {
-      --bodyDepth;
-      if (bodyDepth == 0) {
-        if (!skippingRule && !declBuffer.empty()) {
-          parseDeclarationIntoStyle(declBuffer.str(), currentStyle, propNameBuf, propValueBuf);
-        }
-        if (!skippingRule) {
-          processRuleBlockWithStyle(selector.str(), currentStyle);
-        }
-        selector.clear();
-        declBuffer.clear();
-        skippingRule = false;
-        return;
+    if (c == '{') {
+      bodyDepth = 1;
+      currentStyle = CssStyle{};
+      declBuffer.clear();
+      if (selector.size() > MAX_SELECTOR_LENGTH * 4) {
+        skippingRule = true;
       }
       return;
     }
-    if (bodyDepth > 1) {
+    selector.push_back(c);
+    return;
+  }
+
+  // bodyDepth > 0
+  if (c == '{') {
+    ++bodyDepth;
+    return;
+  }
+  if (c == '}') {
+    --bodyDepth;
+    if (bodyDepth == 0) {
+      if (!skippingRule && !declBuffer.empty()) {
+        parseDeclarationIntoStyle(declBuffer.str(), currentStyle, propNameBuf, propValueBuf);
+      }
+      if (!skippingRule) {
+        parser.processRuleBlockWithStyle(selector.str(), currentStyle);
+      }
+      selector.clear();
+      declBuffer.clear();
+      skippingRule = false;
       return;
     }
-    if (!skippingRule) {
-      if (c == ';') {
-        if (!declBuffer.empty()) {
-          parseDeclarationIntoStyle(declBuffer.str(), currentStyle, propNameBuf, propValueBuf);
-          declBuffer.clear();
-        }
-      } else {
-        declBuffer.push_back(c);
+    return;
+  }
+  if (bodyDepth > 1) {
+    return;
+  }
+  if (!skippingRule) {
+    if (c == ';') {
+      if (!declBuffer.empty()) {
+        parseDeclarationIntoStyle(declBuffer.str(), currentStyle, propNameBuf, propValueBuf);
+        declBuffer.clear();
       }
+    } else {
+      declBuffer.push_back(c);
     }
-  };
+  }
+}
 
-  char buffer[READ_BUFFER_SIZE];
-  while (source.available()) {
-    int bytesRead = source.read(buffer, sizeof(buffer));
-    if (bytesRead <= 0) break;
+size_t CssParser::StreamLoader::write(const uint8_t c) { return write(&c, 1); }
 
-    totalRead += static_cast<size_t>(bytesRead);
+size_t CssParser::StreamLoader::write(const uint8_t* buffer, const size_t size) {
+  totalRead += size;
 
-    for (int i = 0; i < bytesRead; ++i) {
-      const char c = buffer[i];
+  for (size_t i = 0; i < size; ++i) {
+    const char c = static_cast<char>(buffer[i]);
 
-      if (inComment) {
-        if (prevStar && c == '/') {
-          inComment = false;
-          prevStar = false;
-          continue;
-        }
-        prevStar = c == '*';
+    if (inComment) {
+      if (prevStar && c == '/') {
+        inComment = false;
+        prevStar = false;
         continue;
       }
+      prevStar = c == '*';
+      continue;
+    }
 
-      if (maybeSlash) {
-        if (c == '*') {
-          inComment = true;
-          maybeSlash = false;
-          prevStar = false;
-          continue;
-        }
-        handleChar('/');
+    if (maybeSlash) {
+      if (c == '*') {
+        inComment = true;
         maybeSlash = false;
-        // fall through to process current char
-      }
-
-      if (c == '/') {
-        maybeSlash = true;
+        prevStar = false;
         continue;
       }
+      handleChar('/');
+      maybeSlash = false;
+      // fall through to process current char
+    }
 
-      handleChar(c);
+    if (c == '/') {
+      maybeSlash = true;
+      continue;
     }
+
+    handleChar(c);
   }
+  return size;
+}
 
+void CssParser::StreamLoader::finish() {
   if (maybeSlash) {
     handleChar('/');
+    maybeSlash = false;
   }
 
-  LOG_DBG("CSS", "Parsed %zu rules from %zu bytes", rulesBySelector_.size(), totalRead);
-  return true;
+  LOG_DBG("CSS", "Parsed %zu rules from %zu bytes", parser.rulesBySelector_.size(), totalRead);
 }
 
 // Style resolution
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <HalStorage.h>
+#include <Print.h>
 
 #include <string>
 #include <unordered_map>
@@ -48,6 +49,56 @@ class CssParser {
    */
   bool loadFromStream(FsFile& source);
 
+  /**
+   * Incremental loader: parses CSS as it is written, e.g. straight from an inflating ZIP entry.
+   * Rules are added to the parser as they complete; call finish() after the last byte.
+   */
+  class StreamLoader final : public Print {
+   public:
+    explicit StreamLoader(CssParser& parser) : parser(parser) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void finish();
+
+   private:
+    // Fixed-size buffer, lives wherever the loader does (usually the stack) to avoid heap reallocations
+    struct Buffer {
+      static constexpr size_t CAPACITY = 1024;
+      char data[CAPACITY];
+      size_t len = 0;
+
+      void push_back(char c) {
+        if (len < CAPACITY - 1) {
+          data[len++] = c;
+        }
+      }
+      void clear() { len = 0; }
+      bool empty() const { return len == 0; }
+      size_t size() const { return len; }
+      // Convert to string for passing to functions (single allocation)
+      std::string str() const { return std::string(data, len); }
+    };
+
+    CssParser& parser;
+    Buffer selector;
+    Buffer declBuffer;
+    // Kept as std::string since they're passed by reference to parseDeclarationIntoStyle
+    std::string propNameBuf;
+    std::string propValueBuf;
+    CssStyle currentStyle;
+    size_t totalRead = 0;
+    int atDepth = 0;
+    int bodyDepth = 0;
+    bool inComment = false;
+    bool maybeSlash = false;
+    bool prevStar = false;
+    bool inAtRule = false;
+    bool skippingRule = false;
+
+    void handleChar(char c);
+  };
+
   /**
    * Look up the style for an HTML element, considering tag name and class attributes.
    * Applies CSS cascade: element style < class style < element.class style
@@ -2,14 +2,21 @@
 
 #include <FsHelpers.h>
 #include <Logging.h>
-#include <Serialization.h>
+#include <ZipFile.h>
+
+#include <new>
 
 #include "../BookMetadataCache.h"
 
 namespace {
 constexpr char MEDIA_TYPE_NCX[] = "application/x-dtbncx+xml";
 constexpr char MEDIA_TYPE_CSS[] = "text/css";
-constexpr char itemCacheFile[] = "/.items.bin";
+
+bool isManifestTag(const char* name) { return strcmp(name, "manifest") == 0 || strcmp(name, "opf:manifest") == 0; }
+
+bool manifestEntryLess(const uint32_t aHigh, const uint32_t aLow, const uint32_t bHigh, const uint32_t bLow) {
+  return aHigh != bHigh ? aHigh < bHigh : aLow < bLow;
+}
 }  // namespace
 
 bool ContentOpfParser::setup() {
@@ -33,13 +40,51 @@ ContentOpfParser::~ContentOpfParser() {
     XML_ParserFree(parser);
     parser = nullptr;
   }
-  if (tempItemStore) {
-    tempItemStore.close();
+}
+
+bool ContentOpfParser::reserveManifest(const size_t itemCount, const size_t hrefBytes) {
+  manifest.reset(new (std::nothrow) ManifestEntry[itemCount]);
+  manifestHrefs.reset(new (std::nothrow) char[hrefBytes]);
+  if ((itemCount > 0 && !manifest) || (hrefBytes > 0 && !manifestHrefs)) {
+    LOG_ERR("COF", "Failed to allocate manifest index (%zu items, %zu bytes of hrefs)", itemCount, hrefBytes);
+    manifest.reset();
+    manifestHrefs.reset();
+    return false;
+  }
+  manifestCapacity = itemCount;
+  manifestHrefsCapacity = hrefBytes;
+  return true;
+}
+
+void ContentOpfParser::addManifestItem(const char* itemId, const char* href) {
+  const size_t hrefSize = strlen(href) + 1;
+  if (manifestCount == manifestCapacity || manifestHrefsSize + hrefSize > manifestHrefsCapacity) {
+    LOG_ERR("COF", "Manifest item %s not counted, skipping it", itemId);
+    return;
   }
-  const auto itemCachePath = cachePath + itemCacheFile;
-  if (Storage.exists(itemCachePath.c_str())) {
-    Storage.remove(itemCachePath.c_str());
+  const uint64_t hash = ZipFile::fnvHash64(itemId, strlen(itemId));
+  manifest[manifestCount++] = {static_cast<uint32_t>(hash), static_cast<uint32_t>(hash >> 32),
+                               static_cast<uint32_t>(manifestHrefsSize)};
+  memcpy(manifestHrefs.get() + manifestHrefsSize, href, hrefSize);
+  manifestHrefsSize += hrefSize;
+}
+
+bool ContentOpfParser::findManifestHref(const char* idref, std::string& href) const {
+  const uint64_t hash = ZipFile::fnvHash64(idref, strlen(idref));
+  const auto low = static_cast<uint32_t>(hash);
+  const auto high = static_cast<uint32_t>(hash >> 32);
+  const ManifestEntry* begin = manifest.get();
+  const ManifestEntry* end = begin + manifestCount;
+  const ManifestEntry* it = std::lower_bound(begin, end, ManifestEntry{low, high, 0},
+                                             [](const ManifestEntry& a, const ManifestEntry& b) {
+                                               return manifestEntryLess(a.idHashHigh, a.idHashLow, b.idHashHigh,
+                                                                        b.idHashLow);
+                                             });
+  if (it == end || it->idHashLow != low || it->idHashHigh != high) {
+    return false;
   }
+  href = FsHelpers::normalisePath(baseContentPath + (manifestHrefs.get() + it->hrefOffset));
+  return true;
 }
 
 size_t ContentOpfParser::write(const uint8_t data) { return write(&data, 1); }
@@ -119,36 +164,25 @@ void XMLCALL ContentOpfParser::startElement(void* userData, const XML_Char* name
 
   if (self->state == IN_PACKAGE && (strcmp(name, "manifest") == 0 || strcmp(name, "opf:manifest") == 0)) {
     self->state = IN_MANIFEST;
-    if (!Storage.openFileForWrite("COF", self->cachePath + itemCacheFile, self->tempItemStore)) {
-      LOG_ERR("COF", "Couldn't open temp items file for writing. This is probably going to be a fatal error.");
-    }
     return;
   }
 
   if (self->state == IN_PACKAGE && (strcmp(name, "spine") == 0 || strcmp(name, "opf:spine") == 0)) {
     self->state = IN_SPINE;
-    if (!Storage.openFileForRead("COF", self->cachePath + itemCacheFile, self->tempItemStore)) {
-      LOG_ERR("COF", "Couldn't open temp items file for reading. This is probably going to be a fatal error.");
-    }
-
-    // Sort item index for binary search if we have enough items
-    if (self->itemIndex.size() >= LARGE_SPINE_THRESHOLD) {
-      std::sort(self->itemIndex.begin(), self->itemIndex.end(), [](const ItemIndexEntry& a, const ItemIndexEntry& b) {
-        return a.idHash < b.idHash || (a.idHash == b.idHash && a.idLen < b.idLen);
-      });
-      self->useItemIndex = true;
-      LOG_DBG("COF", "Using fast index for %zu manifest items", self->itemIndex.size());
+    if (!self->manifestSorted) {
+      std::sort(self->manifest.get(), self->manifest.get() + self->manifestCount,
+                [](const ManifestEntry& a, const ManifestEntry& b) {
+                  return manifestEntryLess(a.idHashHigh, a.idHashLow, b.idHashHigh, b.idHashLow);
+                });
+      self->manifestSorted = true;
+      LOG_DBG("COF", "Indexed %zu manifest items, %zu bytes of hrefs", self->manifestCount, self->manifestHrefsSize);
     }
     return;
   }
 
   if (self->state == IN_PACKAGE && (strcmp(name, "guide") == 0 || strcmp(name, "opf:guide") == 0)) {
     self->state = IN_GUIDE;
-    // TODO Remove print
     LOG_DBG("COF", "Entering guide state.");
-    if (!Storage.openFileForRead("COF", self->cachePath + itemCacheFile, self->tempItemStore)) {
-      LOG_ERR("COF", "Couldn't open temp items file for reading. This is probably going to be a fatal error.");
-    }
     return;
   }
 
@@ -175,12 +209,14 @@ void XMLCALL ContentOpfParser::startElement(void* userData, const XML_Char* name
     std::string href;
     std::string mediaType;
     std::string properties;
+    const char* rawHref = "";
 
     for (int i = 0; atts[i]; i += 2) {
       if (strcmp(atts[i], "id") == 0) {
         itemId = atts[i + 1];
       } else if (strcmp(atts[i], "href") == 0) {
-        href = FsHelpers::normalisePath(self->baseContentPath + atts[i + 1]);
+        rawHref = atts[i + 1];
+        href = FsHelpers::normalisePath(self->baseContentPath + rawHref);
       } else if (strcmp(atts[i], "media-type") == 0) {
         mediaType = atts[i + 1];
       } else if (strcmp(atts[i], "properties") == 0) {
@@ -188,18 +224,9 @@ void XMLCALL ContentOpfParser::startElement(void* userData, const XML_Char* name
       }
     }
 
-    // Record index entry for fast lookup later
-    if (self->tempItemStore) {
-      ItemIndexEntry entry;
-      entry.idHash = fnvHash(itemId);
-      entry.idLen = static_cast<uint16_t>(itemId.size());
-      entry.fileOffset = static_cast<uint32_t>(self->tempItemStore.position());
-      self->itemIndex.push_back(entry);
-    }
-
-    // Write items down to SD card
-    serialization::writeString(self->tempItemStore, itemId);
-    serialization::writeString(self->tempItemStore, href);
+    // Kept in RAM for the spine. Every item is, whatever its media type: older books reference OEB documents, DTBook
+    // or mislabelled XML from their spine.
+    self->addManifestItem(itemId.c_str(), rawHref);
 
     if (itemId == self->coverItemId) {
       self->coverItemHref = href;
@@ -243,49 +270,8 @@ void XMLCALL ContentOpfParser::startElement(void* userData, const XML_Char* name
     if (self->state == IN_SPINE && (strcmp(name, "itemref") == 0 || strcmp(name, "opf:itemref") == 0)) {
       for (int i = 0; atts[i]; i += 2) {
         if (strcmp(atts[i], "idref") == 0) {
-          const std::string idref = atts[i + 1];
           std::string href;
-          bool found = false;
-
-          if (self->useItemIndex) {
-            // Fast path: binary search
-            uint32_t targetHash = fnvHash(idref);
-            uint16_t targetLen = static_cast<uint16_t>(idref.size());
-
-            auto it = std::lower_bound(self->itemIndex.begin(), self->itemIndex.end(),
-                                       ItemIndexEntry{targetHash, targetLen, 0},
-                                       [](const ItemIndexEntry& a, const ItemIndexEntry& b) {
-                                         return a.idHash < b.idHash || (a.idHash == b.idHash && a.idLen < b.idLen);
-                                       });
-
-            // Check for match (may need to check a few due to hash collisions)
-            while (it != self->itemIndex.end() && it->idHash == targetHash) {
-              self->tempItemStore.seek(it->fileOffset);
-              std::string itemId;
-              serialization::readString(self->tempItemStore, itemId);
-              if (itemId == idref) {
-                serialization::readString(self->tempItemStore, href);
-                found = true;
-                break;
-              }
-              ++it;
-            }
-          } else {
-            // Slow path: linear scan (for small manifests, keeps original behavior)
-            // TODO: This lookup is slow as need to scan through all items each time.
-            //       It can take up to 200ms per item when getting to 1500 items.
-            self->tempItemStore.seek(0);
-            std::string itemId;
-            while (self->tempItemStore.available()) {
-              serialization::readString(self->tempItemStore, itemId);
-              serialization::readString(self->tempItemStore, href);
-              if (itemId == idref) {
-                found = true;
-                break;
-              }
-            }
-          }
-
+          const bool found = self->findManifestHref(atts[i + 1], href);
           if (found && self->cache) {
             self->cache->createSpineEntry(href);
           }
@@ -346,19 +332,21 @@ void XMLCALL ContentOpfParser::endElement(void* userData, const XML_Char* name)
 
   if (self->state == IN_SPINE && (strcmp(name, "spine") == 0 || strcmp(name, "opf:spine") == 0)) {
     self->state = IN_PACKAGE;
-    self->tempItemStore.close();
+    // Nothing after the spine looks items up
+    self->manifest.reset();
+    self->manifestHrefs.reset();
+    self->manifestCount = self->manifestCapacity = 0;
+    self->manifestHrefsSize = self->manifestHrefsCapacity = 0;
     return;
   }
 
   if (self->state == IN_GUIDE && (strcmp(name, "guide") == 0 || strcmp(name, "opf:guide") == 0)) {
     self->state = IN_PACKAGE;
-    self->tempItemStore.close();
     return;
   }
 
   if (self->state == IN_MANIFEST && (strcmp(name, "manifest") == 0 || strcmp(name, "opf:manifest") == 0)) {
     self->state = IN_PACKAGE;
-    self->tempItemStore.close();
     return;
   }
 
@@ -387,3 +375,84 @@ void XMLCALL ContentOpfParser::endElement(void* userData, const XML_Char* name)
     return;
   }
 }
+
+bool ContentOpfParser::ManifestCounter::setup() {
+  parser = XML_ParserCreate(nullptr);
+  if (!parser) {
+    LOG_DBG("COF", "Couldn't allocate memory for parser");
+    return false;
+  }
+
+  XML_SetUserData(parser, this);
+  XML_SetElementHandler(parser, startElement, endElement);
+  return true;
+}
+
+ContentOpfParser::ManifestCounter::~ManifestCounter() {
+  if (parser) {
+    XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
+    XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
+    XML_ParserFree(parser);
+    parser = nullptr;
+  }
+}
+
+size_t ContentOpfParser::ManifestCounter::write(const uint8_t data) { return write(&data, 1); }
+
+size_t ContentOpfParser::ManifestCounter::write(const uint8_t* buffer, const size_t size) {
+  if (!parser) return 0;
+
+  const uint8_t* currentBufferPos = buffer;
+  auto remainingInBuffer = size;
+
+  while (remainingInBuffer > 0) {
+    void* const buf = XML_GetBuffer(parser, 1024);
+    if (!buf) {
+      LOG_ERR("COF", "Couldn't allocate memory for buffer");
+      return 0;
+    }
+
+    const auto toRead = remainingInBuffer < 1024 ? remainingInBuffer : 1024;
+    memcpy(buf, currentBufferPos, toRead);
+
+    if (XML_ParseBuffer(parser, static_cast<int>(toRead), remainingSize == toRead) == XML_STATUS_ERROR) {
+      LOG_DBG("COF", "Parse error at line %lu: %s", XML_GetCurrentLineNumber(parser),
+              XML_ErrorString(XML_GetErrorCode(parser)));
+      return 0;
+    }
+
+    currentBufferPos += toRead;
+    remainingInBuffer -= toRead;
+    remainingSize -= toRead;
+  }
+
+  return size;
+}
+
+void XMLCALL ContentOpfParser::ManifestCounter::startElement(void* userData, const XML_Char* name,
+                                                             const XML_Char** atts) {
+  auto* self = static_cast<ManifestCounter*>(userData);
+  if (isManifestTag(name)) {
+    self->inManifest = true;
+    return;
+  }
+  if (!self->inManifest || (strcmp(name, "item") != 0 && strcmp(name, "opf:item") != 0)) {
+    return;
+  }
+
+  const char* href = "";
+  for (int i = 0; atts[i]; i += 2) {
+    if (strcmp(atts[i], "href") == 0) {
+      href = atts[i + 1];
+    }
+  }
+  self->itemCount++;
+  self->hrefBytes += strlen(href) + 1;
+}
+
+void XMLCALL ContentOpfParser::ManifestCounter::endElement(void* userData, const XML_Char* name) {
+  auto* self = static_cast<ManifestCounter*>(userData);
+  if (isManifestTag(name)) {
+    self->inManifest = false;
+  }
+}
@@ -2,6 +2,7 @@
 #include <Print.h>
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 #include "Epub.h"
@@ -22,35 +23,31 @@ class ContentOpfParser final : public Print {
     IN_GUIDE,
   };
 
-  const std::string& cachePath;
   const std::string& baseContentPath;
   size_t remainingSize;
   XML_Parser parser = nullptr;
   ParserState state = START;
   BookMetadataCache* cache;
-  FsFile tempItemStore;
   std::string coverItemId;
 
-  // Index for fast idref→href lookup (used only for large EPUBs)
-  struct ItemIndexEntry {
-    uint32_t idHash;      // FNV-1a hash of itemId
-    uint16_t idLen;       // length for collision reduction
-    uint32_t fileOffset;  // offset in .items.bin
+  // Every manifest item, for the spine's idref -> href lookups: (id hash, href) entries sorted by hash
+  // once the spine starts. Ids aren't kept, a 64-bit hash tells them apart; hrefs are kept as written, NUL-terminated
+  // in one buffer. Both are allocated once by reserveManifest(), sized by a ManifestCounter pass.
+  struct ManifestEntry {
+    uint32_t idHashLow;
+    uint32_t idHashHigh;
+    uint32_t hrefOffset;  // in manifestHrefs
   };
-  std::vector<ItemIndexEntry> itemIndex;
-  bool useItemIndex = false;
+  std::unique_ptr<ManifestEntry[]> manifest;
+  size_t manifestCapacity = 0;
+  size_t manifestCount = 0;
+  std::unique_ptr<char[]> manifestHrefs;
+  size_t manifestHrefsCapacity = 0;
+  size_t manifestHrefsSize = 0;
+  bool manifestSorted = false;
 
-  static constexpr uint16_t LARGE_SPINE_THRESHOLD = 400;
-
-  // FNV-1a hash function
-  static uint32_t fnvHash(const std::string& s) {
-    uint32_t hash = 2166136261u;
-    for (char c : s) {
-      hash ^= static_cast<uint8_t>(c);
-      hash *= 16777619u;
-    }
-    return hash;
-  }
+  void addManifestItem(const char* itemId, const char* href);
+  bool findManifestHref(const char* idref, std::string& href) const;
 
   static void startElement(void* userData, const XML_Char* name, const XML_Char** atts);
   static void characterData(void* userData, const XML_Char* s, int len);
@@ -67,13 +64,37 @@ class ContentOpfParser final : public Print {
   std::string textReferenceHref;
   std::vector<std::string> cssFiles;  // CSS stylesheet paths
 
-  explicit ContentOpfParser(const std::string& cachePath, const std::string& baseContentPath, const size_t xmlSize,
-                            BookMetadataCache* cache)
-      : cachePath(cachePath), baseContentPath(baseContentPath), remainingSize(xmlSize), cache(cache) {}
+  // First pass over the OPF: counts the manifest items and the bytes of their hrefs
+  class ManifestCounter final : public Print {
+    size_t remainingSize;
+    XML_Parser parser = nullptr;
+    bool inManifest = false;
+
+    static void startElement(void* userData, const XML_Char* name, const XML_Char** atts);
+    static void endElement(void* userData, const XML_Char* name);
+
+   public:
+    size_t itemCount = 0;
+    size_t hrefBytes = 0;
+
+    explicit ManifestCounter(const size_t xmlSize) : remainingSize(xmlSize) {}
+    ~ManifestCounter() override;
+
+    bool setup();
+
+    size_t write(uint8_t) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+  };
+
+  explicit ContentOpfParser(const std::string& baseContentPath, const size_t xmlSize, BookMetadataCache* cache)
+      : baseContentPath(baseContentPath), remainingSize(xmlSize), cache(cache) {}
   ~ContentOpfParser() override;
 
   bool setup();
 
+  // Allocates the manifest index for a ManifestCounter's totals; false when the heap can't hold it
+  bool reserveManifest(size_t itemCount, size_t hrefBytes);
+
   size_t write(uint8_t) override;
   size_t write(const uint8_t* buffer, size_t size) override;
 };
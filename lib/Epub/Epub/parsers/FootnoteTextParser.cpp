@@ -0,0 +1,199 @@
+#include "FootnoteTextParser.h"
+
+#include <Logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "../htmlEntities.h"
+
+namespace {
+constexpr size_t PARSE_CHUNK_SIZE = 1024;
+
+// Elements whose text is never part of a note
+const char* SKIP_TAGS[] = {"head", "script", "style"};
+// Elements that start a new line of text; their text is joined with a space
+const char* BREAK_TAGS[] = {"p", "div", "li", "br", "blockquote", "dd", "dt", "h1", "h2", "h3", "h4", "h5", "h6"};
+// An id on one of these marks a spot in its paragraph rather than the note itself
+const char* INLINE_TAGS[] = {"a", "span", "sup", "sub", "b", "i", "em", "strong", "small", "cite"};
+
+template <size_t N>
+bool isOneOf(const char* name, const char* (&tags)[N]) {
+  return std::any_of(std::begin(tags), std::end(tags), [name](const char* tag) { return strcmp(name, tag) == 0; });
+}
+}  // namespace
+
+bool FootnoteTextParser::setup() {
+  parser = XML_ParserCreate(nullptr);
+  if (!parser) {
+    LOG_ERR("FNP", "Couldn't allocate memory for parser");
+    return false;
+  }
+
+  XML_SetUserData(parser, this);
+  XML_SetElementHandler(parser, startElement, endElement);
+  XML_SetCharacterDataHandler(parser, characterData);
+  // HTML entities (like &nbsp;) aren't declared in XHTML files
+  XML_SetDefaultHandlerExpand(parser, defaultHandlerExpand);
+  return true;
+}
+
+FootnoteTextParser::~FootnoteTextParser() {
+  if (parser) {
+    XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
+    XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
+    XML_SetCharacterDataHandler(parser, nullptr);
+    XML_ParserFree(parser);
+    parser = nullptr;
+  }
+}
+
+size_t FootnoteTextParser::write(const uint8_t data) { return write(&data, 1); }
+
+size_t FootnoteTextParser::write(const uint8_t* buffer, const size_t size) {
+  if (!parser) return 0;
+
+  // Every note found: the rest of the file isn't needed
+  if (wantedIds.empty() && captureDepth < 0) {
+    return 0;
+  }
+  if (abortFn && abortFn()) {
+    captureDepth = -1;  // a note cut short isn't kept
+    return 0;
+  }
+
+  const uint8_t* currentBufferPos = buffer;
+  auto remainingInBuffer = size;
+
+  while (remainingInBuffer > 0) {
+    void* const buf = XML_GetBuffer(parser, PARSE_CHUNK_SIZE);
+    if (!buf) {
+      LOG_DBG("FNP", "Couldn't allocate buffer");
+      return 0;
+    }
+
+    const auto toRead = remainingInBuffer < PARSE_CHUNK_SIZE ? remainingInBuffer : PARSE_CHUNK_SIZE;
+    memcpy(buf, currentBufferPos, toRead);
+
+    if (XML_ParseBuffer(parser, static_cast<int>(toRead), remainingSize == toRead) == XML_STATUS_ERROR) {
+      LOG_ERR("FNP", "Parse error: %s", XML_ErrorString(XML_GetErrorCode(parser)));
+      finishNote();
+      return 0;
+    }
+
+    currentBufferPos += toRead;
+    remainingInBuffer -= toRead;
+    remainingSize -= toRead;
+  }
+
+  if (remainingSize == 0) {
+    finishNote();
+  }
+  return size;
+}
+
+void FootnoteTextParser::startNote(const char* id, const bool isInline) {
+  finishNote();
+  captureId = id;
+  captureText.clear();
+  pendingSpace = false;
+  truncated = false;
+  captureDepth = isInline ? depth - 1 : depth;
+}
+
+void FootnoteTextParser::finishNote() {
+  if (captureDepth < 0) {
+    return;
+  }
+  captureDepth = -1;
+  if (!captureText.empty()) {
+    notes.emplace_back(std::move(captureId), std::move(captureText));
+  }
+  captureId.clear();
+  captureText.clear();
+}
+
+void FootnoteTextParser::appendText(const char* s, const int len) {
+  for (int i = 0; i < len && !truncated; i++) {
+    const char c = s[i];
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      pendingSpace = !captureText.empty();
+      continue;
+    }
+    if (captureText.size() + 1 + (pendingSpace ? 1 : 0) > MAX_NOTE_TEXT) {
+      // Cut on a character boundary and mark the cut
+      while (!captureText.empty() && (static_cast<uint8_t>(captureText.back()) & 0xC0) == 0x80) {
+        captureText.pop_back();
+      }
+      if (!captureText.empty()) {
+        captureText.pop_back();
+      }
+      captureText += "\xE2\x80\xA6";
+      truncated = true;
+      break;
+    }
+    if (pendingSpace) {
+      captureText += ' ';
+      pendingSpace = false;
+    }
+    captureText += c;
+  }
+}
+
+void XMLCALL FootnoteTextParser::startElement(void* userData, const XML_Char* name, const XML_Char** atts) {
+  auto* self = static_cast<FootnoteTextParser*>(userData);
+  self->depth++;
+  if (self->skipUntilDepth >= 0) {
+    return;
+  }
+  if (isOneOf(name, SKIP_TAGS)) {
+    self->skipUntilDepth = self->depth;
+    return;
+  }
+
+  for (int i = 0; atts[i]; i += 2) {
+    if (strcmp(atts[i], "id") != 0) {
+      continue;
+    }
+    const auto it = std::find(self->wantedIds.begin(), self->wantedIds.end(), atts[i + 1]);
+    if (it != self->wantedIds.end()) {
+      self->wantedIds.erase(it);
+      self->startNote(atts[i + 1], isOneOf(name, INLINE_TAGS));
+      return;
+    }
+    break;
+  }
+
+  if (self->captureDepth >= 0 && isOneOf(name, BREAK_TAGS)) {
+    self->pendingSpace = !self->captureText.empty();
+  }
+}
+
+void XMLCALL FootnoteTextParser::endElement(void* userData, const XML_Char* name) {
+  auto* self = static_cast<FootnoteTextParser*>(userData);
+  if (self->skipUntilDepth == self->depth) {
+    self->skipUntilDepth = -1;
+  } else if (self->captureDepth == self->depth) {
+    self->finishNote();
+  }
+  self->depth--;
+}
+
+void XMLCALL FootnoteTextParser::characterData(void* userData, const XML_Char* s, const int len) {
+  auto* self = static_cast<FootnoteTextParser*>(userData);
+  if (self->captureDepth >= 0 && self->skipUntilDepth < 0) {
+    self->appendText(s, len);
+  }
+}
+
+void XMLCALL FootnoteTextParser::defaultHandlerExpand(void* userData, const XML_Char* s, const int len) {
+  // Entity references (&...;) not known to expat
+  if (len >= 3 && s[0] == '&' && s[len - 1] == ';') {
+    const char* utf8Value = lookupHtmlEntity(s, static_cast<size_t>(len));
+    if (utf8Value != nullptr) {
+      characterData(userData, utf8Value, static_cast<int>(strlen(utf8Value)));
+    } else {
+      characterData(userData, s, len);
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <Print.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "expat.h"
+
+// Collects the plain text of the elements with the given ids from an XHTML file, for footnote popups. An id on an
+// inline element (a back link or an empty anchor) stands for the rest of its enclosing paragraph. write() refuses
+// data once every note was found or abortFn returns true, which ends the read of the file.
+class FootnoteTextParser final : public Print {
+  size_t remainingSize;
+  XML_Parser parser = nullptr;
+  std::vector<std::string> wantedIds;  // not found yet
+  int depth = 0;
+  int skipUntilDepth = -1;  // inside <head>, <script> or <style>
+  int captureDepth = -1;    // depth of the element whose end finishes the note being captured
+  std::string captureId;
+  std::string captureText;
+  bool pendingSpace = false;
+  bool truncated = false;
+  std::function<bool()> abortFn;
+
+  void startNote(const char* id, bool isInline);
+  void finishNote();
+  void appendText(const char* s, int len);
+
+  static void startElement(void* userData, const XML_Char* name, const XML_Char** atts);
+  static void endElement(void* userData, const XML_Char* name);
+  static void characterData(void* userData, const XML_Char* s, int len);
+  static void defaultHandlerExpand(void* userData, const XML_Char* s, int len);
+
+ public:
+  static constexpr size_t MAX_NOTE_TEXT = 1024;
+
+  // (id, text) of the notes found, in document order
+  std::vector<std::pair<std::string, std::string>> notes;
+
+  explicit FootnoteTextParser(const size_t xmlSize, std::vector<std::string> ids,
+                              std::function<bool()> abortFn = nullptr)
+      : remainingSize(xmlSize), wantedIds(std::move(ids)), abortFn(std::move(abortFn)) {}
+  ~FootnoteTextParser() override;
+
+  bool setup();
+
+  size_t write(uint8_t) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+};
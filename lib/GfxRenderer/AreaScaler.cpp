@@ -0,0 +1,92 @@
+#include "AreaScaler.h"
+
+#include <Logging.h>
+
+#include <cstdlib>
+#include <cstring>
+
+AreaScaler::~AreaScaler() {
+  free(rowAccum);
+  free(rowCount);
+  free(outRow);
+}
+
+bool AreaScaler::begin(const int srcWidth, const int srcHeight, const int outWidth, const int outHeight) {
+  this->srcWidth = srcWidth;
+  this->outWidth = outWidth;
+  this->outHeight = outHeight;
+  // Source pixels per output pixel
+  scaleX_fp = (static_cast<uint64_t>(srcWidth) << 16) / outWidth;
+  scaleY_fp = (static_cast<uint64_t>(srcHeight) << 16) / outHeight;
+  nextOutY_srcStart = scaleY_fp;  // First boundary is at scaleY_fp (source Y for outY=1)
+  srcY = 0;
+  outY = 0;
+  segmentOutX = 0;
+
+  rowAccum = static_cast<uint32_t*>(calloc(outWidth, sizeof(uint32_t)));
+  rowCount = static_cast<uint32_t*>(calloc(outWidth, sizeof(uint32_t)));
+  outRow = static_cast<uint8_t*>(malloc(outWidth));
+  if (!rowAccum || !rowCount || !outRow) {
+    LOG_ERR("SCL", "Failed to allocate scaler rows (%d px)", outWidth);
+    return false;
+  }
+  return true;
+}
+
+void AreaScaler::addSegment(const uint8_t* gray, const int startX, const int count) {
+  const int segmentEnd = startX + count;
+
+  // srcX range for outX: [outX * scaleX_fp >> 16, (outX+1) * scaleX_fp >> 16)
+  while (segmentOutX < outWidth) {
+    const int srcXStart = static_cast<int>((segmentOutX * scaleX_fp) >> 16);
+    int srcXEnd = static_cast<int>(((segmentOutX + 1) * scaleX_fp) >> 16);
+    if (srcXEnd > srcWidth) srcXEnd = srcWidth;
+    if (srcXStart >= segmentEnd || srcXStart >= srcWidth) break;  // starts in a later segment
+
+    if (srcXEnd <= srcXStart) {
+      // Upscaling: no source pixel starts inside this output pixel, use nearest
+      if (srcXStart >= startX) {
+        rowAccum[segmentOutX] += gray[srcXStart - startX];
+        rowCount[segmentOutX]++;
+      }
+      segmentOutX++;
+      continue;
+    }
+
+    const int from = srcXStart > startX ? srcXStart : startX;
+    const int to = srcXEnd < segmentEnd ? srcXEnd : segmentEnd;
+    uint32_t sum = 0;
+    for (int srcX = from; srcX < to; srcX++) {
+      sum += gray[srcX - startX];
+    }
+    rowAccum[segmentOutX] += sum;
+    rowCount[segmentOutX] += to - from;
+
+    if (srcXEnd > segmentEnd) break;  // continues in the next segment
+    segmentOutX++;
+  }
+}
+
+int AreaScaler::endRow() {
+  segmentOutX = 0;
+  const uint64_t srcY_fp = static_cast<uint64_t>(++srcY) << 16;
+  if (srcY_fp < nextOutY_srcStart || outY >= outHeight) {
+    return 0;
+  }
+
+  for (int x = 0; x < outWidth; x++) {
+    outRow[x] = rowCount[x] > 0 ? rowAccum[x] / rowCount[x] : 0;
+  }
+
+  // Emit every output row whose boundary we've crossed; when upscaling they share the same source data
+  int completed = 0;
+  while (srcY_fp >= nextOutY_srcStart && outY < outHeight) {
+    completed++;
+    outY++;
+    nextOutY_srcStart = (outY + 1) * scaleY_fp;
+  }
+
+  memset(rowAccum, 0, outWidth * sizeof(uint32_t));
+  memset(rowCount, 0, outWidth * sizeof(uint32_t));
+  return completed;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-point (16.16) area-averaging scaler for 8-bit gray rows. Source rows may arrive in segments, so a decoder
+// never needs a gray buffer at source width: memory is proportional to the output width only.
+class AreaScaler {
+ public:
+  AreaScaler() = default;
+  ~AreaScaler();
+
+  AreaScaler(const AreaScaler&) = delete;
+  AreaScaler& operator=(const AreaScaler&) = delete;
+
+  bool begin(int srcWidth, int srcHeight, int outWidth, int outHeight);
+
+  // Adds count pixels of the current source row, starting at source column startX. Segments must be in order.
+  void addSegment(const uint8_t* gray, int startX, int count);
+  // Closes the current source row. Returns how many output rows it completed (0 or 1 when downscaling, more when
+  // upscaling); all of them equal averagedRow() until the next addSegment().
+  int endRow();
+
+  const uint8_t* averagedRow() const { return outRow; }
+  int getOutputWidth() const { return outWidth; }
+  int getOutputHeight() const { return outHeight; }
+  // Number of output rows completed so far
+  int getOutputY() const { return outY; }
+
+ private:
+  int srcWidth = 0;
+  int outWidth = 0;
+  int outHeight = 0;
+  // 64-bit so products with source coordinates cannot overflow for very wide or tall images
+  uint64_t scaleX_fp = 65536;
+  uint64_t scaleY_fp = 65536;
+  int srcY = 0;
+  int outY = 0;
+  int segmentOutX = 0;  // first output column still collecting pixels from the current source row
+  uint64_t nextOutY_srcStart = 0;
+
+  uint32_t* rowAccum = nullptr;
+  uint32_t* rowCount = nullptr;
+  uint8_t* outRow = nullptr;
+};
@@ -9,7 +9,7 @@
 // Dithering is applied when converting high-color BMPs to the display's native
 // 2-bit (4-level) grayscale. Images whose palette entries all map to native
 // gray levels (0, 85, 170, 255 ±21) are mapped directly without dithering.
-// For cover images, dithering is done in JpegToBmpConverter.cpp instead.
+// For cover images, dithering is done in ScaledBmpWriter.cpp instead; both use the kernels in Dithering.h.
 constexpr bool USE_ATKINSON = true;  // Use Atkinson dithering instead of Floyd-Steinberg
 // ============================================================================
 
@@ -177,13 +177,10 @@ BmpReaderError Bitmap::parseHeaders() {
   return BmpReaderError::Ok;
 }
 
-// packed 2bpp output, 0 = black, 1 = dark gray, 2 = light gray, 3 = white
-BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
-  // Note: rowBuffer should be pre-allocated by the caller to size 'rowBytes'
-  if (file.read(rowBuffer, rowBytes) != rowBytes) return BmpReaderError::ShortReadRow;
-
-  prevRowY += 1;
-
+// Unpacks one BMP row to luminance and packs quantizePixel(lum, x) as 2bpp. Instantiated once per quantization
+// strategy so the per-pixel loop never re-checks which ditherer is active.
+template <typename QuantizePixel>
+BmpReaderError Bitmap::packRow(const uint8_t* rowBuffer, uint8_t* data, QuantizePixel quantizePixel) const {
   uint8_t* outPtr = data;
   uint8_t currentOutByte = 0;
   int bitShift = 6;
@@ -191,21 +188,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
 
   // Helper lambda to pack 2bpp color into the output stream
   auto packPixel = [&](const uint8_t lum) {
-    uint8_t color;
-    if (atkinsonDitherer) {
-      color = atkinsonDitherer->processPixel(adjustPixel(lum), currentX);
-    } else if (fsDitherer) {
-      color = fsDitherer->processPixel(adjustPixel(lum), currentX);
-    } else {
-      if (nativePalette) {
-        // Palette matches native gray levels: direct mapping (still apply brightness/contrast/gamma)
-        color = static_cast<uint8_t>(adjustPixel(lum) >> 6);
-      } else {
-        // Non-native palette with dithering disabled: simple quantization
-        color = quantize(adjustPixel(lum), currentX, prevRowY);
-      }
-    }
-    currentOutByte |= (color << bitShift);
+    currentOutByte |= (quantizePixel(lum, currentX) << bitShift);
     if (bitShift == 0) {
       *outPtr++ = currentOutByte;
       currentOutByte = 0;
@@ -216,14 +199,11 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
     currentX++;
   };
 
-  uint8_t lum;
-
   switch (bpp) {
     case 32: {
       const uint8_t* p = rowBuffer;
       for (int x = 0; x < width; x++) {
-        lum = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
-        packPixel(lum);
+        packPixel((77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8);
         p += 4;
       }
       break;
@@ -231,8 +211,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
     case 24: {
       const uint8_t* p = rowBuffer;
       for (int x = 0; x < width; x++) {
-        lum = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
-        packPixel(lum);
+        packPixel((77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8);
         p += 3;
       }
       break;
@@ -252,8 +231,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
     }
     case 2: {
       for (int x = 0; x < width; x++) {
-        lum = paletteLum[(rowBuffer[x >> 2] >> (6 - ((x & 3) * 2))) & 0x03];
-        packPixel(lum);
+        packPixel(paletteLum[(rowBuffer[x >> 2] >> (6 - ((x & 3) * 2))) & 0x03]);
       }
       break;
     }
@@ -262,8 +240,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
         // Get palette index (0 or 1) from bit at position x
         const uint8_t palIndex = (rowBuffer[x >> 3] & (0x80 >> (x & 7))) ? 1 : 0;
         // Use palette lookup for proper black/white mapping
-        lum = paletteLum[palIndex];
-        packPixel(lum);
+        packPixel(paletteLum[palIndex]);
       }
       break;
     }
@@ -271,17 +248,41 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
       return BmpReaderError::UnsupportedBpp;
   }
 
-  if (atkinsonDitherer)
-    atkinsonDitherer->nextRow();
-  else if (fsDitherer)
-    fsDitherer->nextRow();
-
   // Flush remaining bits if width is not a multiple of 4
   if (bitShift != 6) *outPtr = currentOutByte;
 
   return BmpReaderError::Ok;
 }
 
+// packed 2bpp output, 0 = black, 1 = dark gray, 2 = light gray, 3 = white
+BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
+  // Note: rowBuffer should be pre-allocated by the caller to size 'rowBytes'
+  if (file.read(rowBuffer, rowBytes) != rowBytes) return BmpReaderError::ShortReadRow;
+
+  prevRowY += 1;
+
+  BmpReaderError result;
+  if (atkinsonDitherer) {
+    result = packRow(rowBuffer, data, [this](const uint8_t lum, const int x) {
+      return atkinsonDitherer->processPixel(TONE_CURVE[lum], x);
+    });
+    atkinsonDitherer->nextRow();
+  } else if (fsDitherer) {
+    result = packRow(rowBuffer, data,
+                     [this](const uint8_t lum, const int x) { return fsDitherer->processPixel(TONE_CURVE[lum], x); });
+    fsDitherer->nextRow();
+  } else if (nativePalette) {
+    // Palette matches native gray levels: direct mapping (still apply the tone curve)
+    result = packRow(rowBuffer, data,
+                     [](const uint8_t lum, int) { return static_cast<uint8_t>(TONE_CURVE[lum] >> 6); });
+  } else {
+    // Non-native palette with dithering disabled: simple quantization
+    result = packRow(rowBuffer, data,
+                     [this](const uint8_t lum, const int x) { return quantize(TONE_CURVE[lum], x, prevRowY); });
+  }
+  return result;
+}
+
 BmpReaderError Bitmap::rewindToData() const {
   if (!file.seek(bfOffBits)) {
     return BmpReaderError::SeekPixelDataFailed;
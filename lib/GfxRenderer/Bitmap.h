@@ -80,6 +80,8 @@ class Bitmap {
  private:
   static uint16_t readLE16(FsFile& f);
   static uint32_t readLE32(FsFile& f);
+  template <typename QuantizePixel>
+  BmpReaderError packRow(const uint8_t* rowBuffer, uint8_t* data, QuantizePixel quantizePixel) const;
 
   FsFile& file;
   bool dithering = false;
@@ -5,66 +5,15 @@
 
 #include "Bitmap.h"
 
-// Brightness/Contrast adjustments:
-constexpr bool USE_BRIGHTNESS = false;       // true: apply brightness/gamma adjustments
-constexpr int BRIGHTNESS_BOOST = 10;         // Brightness offset (0-50)
-constexpr bool GAMMA_CORRECTION = false;     // Gamma curve (brightens midtones)
-constexpr float CONTRAST_FACTOR = 1.15f;     // Contrast multiplier (1.0 = no change, >1 = more contrast)
 constexpr bool USE_NOISE_DITHERING = false;  // Hash-based noise dithering
 
-// Integer approximation of gamma correction (brightens midtones)
-// Uses a simple curve: out = 255 * sqrt(in/255) ≈ sqrt(in * 255)
-static inline int applyGamma(int gray) {
-  if (!GAMMA_CORRECTION) return gray;
-  // Fast integer square root approximation for gamma ~0.5 (brightening)
-  // This brightens dark/mid tones while preserving highlights
-  const int product = gray * 255;
-  // Newton-Raphson integer sqrt (2 iterations for good accuracy)
-  int x = gray;
-  if (x > 0) {
-    x = (x + product / x) >> 1;
-    x = (x + product / x) >> 1;
-  }
-  return x > 255 ? 255 : x;
-}
+// Brightness/contrast/gamma are precomputed into TONE_CURVE (Dithering.h)
+int adjustPixel(int gray) { return TONE_CURVE[dithering::clamp255(gray)]; }
 
-// Apply contrast adjustment around midpoint (128)
-// factor > 1.0 increases contrast, < 1.0 decreases
-static inline int applyContrast(int gray) {
-  // Integer-based contrast: (gray - 128) * factor + 128
-  // Using fixed-point: factor 1.15 ≈ 115/100
-  constexpr int factorNum = static_cast<int>(CONTRAST_FACTOR * 100);
-  int adjusted = ((gray - 128) * factorNum) / 100 + 128;
-  if (adjusted < 0) adjusted = 0;
-  if (adjusted > 255) adjusted = 255;
-  return adjusted;
-}
-// Combined brightness/contrast/gamma adjustment
-int adjustPixel(int gray) {
-  if (!USE_BRIGHTNESS) return gray;
-
-  // Order: contrast first, then brightness, then gamma
-  gray = applyContrast(gray);
-  gray += BRIGHTNESS_BOOST;
-  if (gray > 255) gray = 255;
-  if (gray < 0) gray = 0;
-  gray = applyGamma(gray);
-
-  return gray;
-}
 // Simple quantization without dithering - divide into 4 levels
 // The thresholds are fine-tuned to the X4 display
-uint8_t quantizeSimple(int gray) {
-  if (gray < 45) {
-    return 0;
-  } else if (gray < 70) {
-    return 1;
-  } else if (gray < 140) {
-    return 2;
-  } else {
-    return 3;
-  }
-}
+constexpr auto SIMPLE_LEVELS = dithering::buildLevelTable<3>({45, 70, 140});
+uint8_t quantizeSimple(int gray) { return SIMPLE_LEVELS[dithering::clamp255(gray)]; }
 
 // Hash-based noise dithering - survives downsampling without moiré artifacts
 // Uses integer hash to generate pseudo-random threshold per pixel
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// Shared tone curve and dithering kernels for every image path (cover/thumbnail BMPs, Bitmap::readNextRow, inline
+// images). All tables are built at compile time; the kernels are templated on their output levels so the per-pixel
+// loop is table lookups and integer error diffusion only.
+
+// ============================================================================
+// TONE CURVE - brightness/contrast/gamma, baked into TONE_CURVE
+// ============================================================================
+constexpr bool USE_BRIGHTNESS = false;    // true: apply brightness/gamma adjustments
+constexpr int BRIGHTNESS_BOOST = 10;      // Brightness offset (0-50)
+constexpr bool GAMMA_CORRECTION = false;  // Gamma curve (brightens midtones)
+constexpr float CONTRAST_FACTOR = 1.15f;  // Contrast multiplier (1.0 = no change, >1 = more contrast)
+// ============================================================================
+
+namespace dithering {
+
+// Integer approximation of gamma correction (brightens midtones)
+// Uses a simple curve: out = 255 * sqrt(in/255) ≈ sqrt(in * 255)
+constexpr int applyGamma(const int gray) {
+  if (!GAMMA_CORRECTION) return gray;
+  // Newton-Raphson integer sqrt (2 iterations for good accuracy)
+  const int product = gray * 255;
+  int x = gray;
+  if (x > 0) {
+    x = (x + product / x) >> 1;
+    x = (x + product / x) >> 1;
+  }
+  return x > 255 ? 255 : x;
+}
+
+// Contrast around the midpoint (128) in fixed point: factor 1.15 ≈ 115/100
+constexpr int applyContrast(const int gray) {
+  constexpr int factorNum = static_cast<int>(CONTRAST_FACTOR * 100);
+  int adjusted = ((gray - 128) * factorNum) / 100 + 128;
+  if (adjusted < 0) adjusted = 0;
+  if (adjusted > 255) adjusted = 255;
+  return adjusted;
+}
+
+// Order: contrast first, then brightness, then gamma
+constexpr uint8_t toneMap(int gray) {
+  if (!USE_BRIGHTNESS) return static_cast<uint8_t>(gray);
+  gray = applyContrast(gray);
+  gray += BRIGHTNESS_BOOST;
+  if (gray > 255) gray = 255;
+  if (gray < 0) gray = 0;
+  return static_cast<uint8_t>(applyGamma(gray));
+}
+
+constexpr std::array<uint8_t, 256> buildToneCurve() {
+  std::array<uint8_t, 256> table{};
+  for (int i = 0; i < 256; i++) table[i] = toneMap(i);
+  return table;
+}
+
+// Maps every gray value to the index of the first threshold it does not reach
+template <size_t N>
+constexpr std::array<uint8_t, 256> buildLevelTable(const std::array<uint8_t, N>& thresholds) {
+  std::array<uint8_t, 256> table{};
+  for (int v = 0; v < 256; v++) {
+    uint8_t level = 0;
+    while (level < N && v >= thresholds[level]) level++;
+    table[v] = level;
+  }
+  return table;
+}
+
+inline int clamp255(const int value) { return value < 0 ? 0 : (value > 255 ? 255 : value); }
+
+}  // namespace dithering
+
+inline constexpr std::array<uint8_t, 256> TONE_CURVE = dithering::buildToneCurve();
+
+// Output levels of an error-diffusion kernel: LEVEL maps an (error-adjusted) gray value to the output level, SHOWN is
+// the gray the panel actually displays for that level, which is what the remaining error is measured against.
+
+// 2-bit (4 levels), fine-tuned to the X4 eink display
+struct TwoBitLevels {
+  static constexpr std::array<uint8_t, 256> LEVEL = dithering::buildLevelTable<3>({30, 50, 140});
+  static constexpr int16_t SHOWN[4] = {15, 30, 80, 210};
+};
+
+// 1-bit: 0 = black, 1 = white
+struct OneBitLevels {
+  static constexpr std::array<uint8_t, 256> LEVEL = dithering::buildLevelTable<1>({128});
+  static constexpr int16_t SHOWN[2] = {0, 255};
+};
+
+// Atkinson dithering - distributes only 6/8 (75%) of error for cleaner results
+// Error distribution pattern:
+//     X  1/8 1/8
+// 1/8 1/8 1/8
+//     1/8
+// Less error buildup = fewer artifacts than Floyd-Steinberg
+template <typename Levels>
+class AtkinsonDither {
+ public:
+  explicit AtkinsonDither(int width) : width(width) {
+    errorRow0 = new int16_t[width + 4]();  // Current row
+    errorRow1 = new int16_t[width + 4]();  // Next row
+    errorRow2 = new int16_t[width + 4]();  // Row after next
+  }
+
+  ~AtkinsonDither() {
+    delete[] errorRow0;
+    delete[] errorRow1;
+    delete[] errorRow2;
+  }
+
+  AtkinsonDither(const AtkinsonDither& other) = delete;
+  AtkinsonDither& operator=(const AtkinsonDither& other) = delete;
+
+  // gray is expected to be tone-mapped already (see TONE_CURVE)
+  uint8_t processPixel(const int gray, const int x) {
+    const int adjusted = dithering::clamp255(gray + errorRow0[x + 2]);
+    const uint8_t quantized = Levels::LEVEL[adjusted];
+
+    // Calculate error (only distribute 6/8 = 75%)
+    const int16_t error = static_cast<int16_t>((adjusted - Levels::SHOWN[quantized]) >> 3);  // error/8
+
+    // Distribute 1/8 to each of 6 neighbors
+    errorRow0[x + 3] += error;  // Right
+    errorRow0[x + 4] += error;  // Right+1
+    errorRow1[x + 1] += error;  // Bottom-left
+    errorRow1[x + 2] += error;  // Bottom
+    errorRow1[x + 3] += error;  // Bottom-right
+    errorRow2[x + 2] += error;  // Two rows down
+
+    return quantized;
+  }
+
+  void nextRow() {
+    int16_t* temp = errorRow0;
+    errorRow0 = errorRow1;
+    errorRow1 = errorRow2;
+    errorRow2 = temp;
+    memset(errorRow2, 0, (width + 4) * sizeof(int16_t));
+  }
+
+  void reset() {
+    memset(errorRow0, 0, (width + 4) * sizeof(int16_t));
+    memset(errorRow1, 0, (width + 4) * sizeof(int16_t));
+    memset(errorRow2, 0, (width + 4) * sizeof(int16_t));
+  }
+
+ private:
+  int width;
+  int16_t* errorRow0;
+  int16_t* errorRow1;
+  int16_t* errorRow2;
+};
+
+// Floyd-Steinberg error diffusion dithering with serpentine scanning
+// Serpentine scanning alternates direction each row to reduce "worm" artifacts
+// Error distribution pattern (left-to-right):
+//       X   7/16
+// 3/16 5/16 1/16
+// Error distribution pattern (right-to-left, mirrored):
+// 1/16 5/16 3/16
+//      7/16  X
+template <typename Levels>
+class FloydSteinbergDither {
+ public:
+  explicit FloydSteinbergDither(int width) : width(width), rowCount(0) {
+    errorCurRow = new int16_t[width + 2]();  // +2 for boundary handling
+    errorNextRow = new int16_t[width + 2]();
+  }
+
+  ~FloydSteinbergDither() {
+    delete[] errorCurRow;
+    delete[] errorNextRow;
+  }
+
+  FloydSteinbergDither(const FloydSteinbergDither& other) = delete;
+  FloydSteinbergDither& operator=(const FloydSteinbergDither& other) = delete;
+
+  // gray is expected to be tone-mapped already (see TONE_CURVE)
+  // x is the logical x position (0 to width-1), direction handled internally
+  uint8_t processPixel(const int gray, const int x) {
+    const int adjusted = dithering::clamp255(gray + errorCurRow[x + 1]);
+    const uint8_t quantized = Levels::LEVEL[adjusted];
+    const int error = adjusted - Levels::SHOWN[quantized];
+
+    // Distribute error to neighbors (serpentine: direction-aware)
+    if (!isReverseRow()) {
+      errorCurRow[x + 2] += (error * 7) >> 4;   // Right: 7/16
+      errorNextRow[x] += (error * 3) >> 4;      // Bottom-left: 3/16
+      errorNextRow[x + 1] += (error * 5) >> 4;  // Bottom: 5/16
+      errorNextRow[x + 2] += error >> 4;        // Bottom-right: 1/16
+    } else {
+      errorCurRow[x] += (error * 7) >> 4;       // Left: 7/16
+      errorNextRow[x + 2] += (error * 3) >> 4;  // Bottom-right: 3/16
+      errorNextRow[x + 1] += (error * 5) >> 4;  // Bottom: 5/16
+      errorNextRow[x] += error >> 4;            // Bottom-left: 1/16
+    }
+
+    return quantized;
+  }
+
+  // Call at the end of each row to swap buffers
+  void nextRow() {
+    int16_t* temp = errorCurRow;
+    errorCurRow = errorNextRow;
+    errorNextRow = temp;
+    memset(errorNextRow, 0, (width + 2) * sizeof(int16_t));
+    rowCount++;
+  }
+
+  // Check if current row should be processed in reverse
+  bool isReverseRow() const { return (rowCount & 1) != 0; }
+
+  // Reset for a new image or MCU block
+  void reset() {
+    memset(errorCurRow, 0, (width + 2) * sizeof(int16_t));
+    memset(errorNextRow, 0, (width + 2) * sizeof(int16_t));
+    rowCount = 0;
+  }
+
+ private:
+  int width;
+  int rowCount;
+  int16_t* errorCurRow;
+  int16_t* errorNextRow;
+};
+
+using AtkinsonDitherer = AtkinsonDither<TwoBitLevels>;
+using Atkinson1BitDitherer = AtkinsonDither<OneBitLevels>;
+using FloydSteinbergDitherer = FloydSteinbergDither<TwoBitLevels>;
+
+namespace dithering {
+// Signed threshold offsets of the 4x4 Bayer matrix, scaled to +/-40 (half of the quantization step 85)
+constexpr int8_t bayerOffset(const int cell) {
+  constexpr uint8_t BAYER_4X4[16] = {0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5};
+  return static_cast<int8_t>((BAYER_4X4[cell] - 8) * 5);
+}
+
+constexpr std::array<std::array<int8_t, 4>, 4> buildBayerOffsets() {
+  std::array<std::array<int8_t, 4>, 4> table{};
+  for (int i = 0; i < 16; i++) table[i / 4][i % 4] = bayerOffset(i);
+  return table;
+}
+
+// Gray to level 0-3: thresholds 64/128/192 after the Bayer offsets, gray / 85 for plain quantization
+constexpr std::array<uint8_t, 256> buildLevelTable(const bool ordered) {
+  std::array<uint8_t, 256> table{};
+  for (int v = 0; v < 256; v++) {
+    const int plain = v / 85;
+    table[v] = static_cast<uint8_t>(ordered ? v >> 6 : (plain > 3 ? 3 : plain));
+  }
+  return table;
+}
+}  // namespace dithering
+
+// Ordered (Bayer) dithering to 4 levels (0-3) after the shared tone curve. Stateless, so it works with any pixel
+// processing order (inline images are drawn block by block). With dithering disabled the offsets are all zero and
+// the level table is plain gray / 85 quantization, so neither mode needs a per-pixel branch.
+class OrderedDitherer {
+ public:
+  explicit OrderedDitherer(const bool dither)
+      : offsets(dither ? &BAYER_OFFSETS : &NO_OFFSETS), levels(dither ? &BAYER_LEVELS : &PLAIN_LEVELS) {}
+
+  uint8_t processPixel(const uint8_t gray, const int x, const int y) const {
+    return (*levels)[dithering::clamp255(TONE_CURVE[gray] + (*offsets)[y & 3][x & 3])];
+  }
+
+ private:
+  using OffsetTable = std::array<std::array<int8_t, 4>, 4>;
+  using LevelTable = std::array<uint8_t, 256>;
+  static constexpr OffsetTable BAYER_OFFSETS = dithering::buildBayerOffsets();
+  static constexpr OffsetTable NO_OFFSETS = {};
+  static constexpr LevelTable BAYER_LEVELS = dithering::buildLevelTable(true);
+  static constexpr LevelTable PLAIN_LEVELS = dithering::buildLevelTable(false);
+
+  const OffsetTable* offsets;
+  const LevelTable* levels;
+};
@@ -1,8 +1,13 @@
 #include "GfxRenderer.h"
 
 #include <Logging.h>
+#include <MemoryBudget.h>
 #include <Utf8.h>
 
+#include <algorithm>
+
+#include "PackBits.h"
+
 const uint8_t* GfxRenderer::getGlyphBitmap(const EpdFontData* fontData, const EpdGlyph* glyph) const {
   if (fontData->groups != nullptr) {
     if (!fontDecompressor) {
@@ -21,10 +26,28 @@ void GfxRenderer::begin() {
     LOG_ERR("GFX", "!! No framebuffer");
     assert(false);
   }
+
+  // The snapshot buffer is only worth keeping between grayscale renders, never while it holds a stored frame
+  MemBudget.registerCache("bw snapshot", MemoryBudget::Priority::Medium, [this] {
+    if (bwSnapshotSize == 0) {
+      free(bwSnapshot);
+      bwSnapshot = nullptr;
+    }
+  });
 }
 
 void GfxRenderer::insertFont(const int fontId, EpdFontFamily font) { fontMap.insert({fontId, font}); }
 
+const EpdFontFamily* GfxRenderer::findFont(const int fontId) const {
+  const auto fontIt = fontMap.find(fontId);
+  if (fontIt != fontMap.end()) {
+    return &fontIt->second;
+  }
+  // Families the resolver supplies are static, so they are looked up on every use rather than cached in fontMap:
+  // the const getters never modify the map and are safe to call from any task
+  return fontResolver ? fontResolver(fontId) : nullptr;
+}
+
 // Translate logical (x,y) coordinates to physical panel coordinates based on current orientation
 // This should always be inlined for better performance
 static inline void rotateCoordinates(const GfxRenderer::Orientation orientation, const int x, const int y, int* phyX,
@@ -181,14 +204,14 @@ void GfxRenderer::drawPixel(const int x, const int y, const bool state) const {
 }
 
 int GfxRenderer::getTextWidth(const int fontId, const char* text, const EpdFontFamily::Style style) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
 
   int w = 0, h = 0;
-  fontIt->second.getTextDimensions(text, &w, &h, style);
+  font->getTextDimensions(text, &w, &h, style);
   return w;
 }
 
@@ -211,19 +234,18 @@ void GfxRenderer::drawText(const int fontId, const int x, const int y, const cha
     return;
   }
 
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return;
   }
-  const auto& font = fontIt->second;
   constexpr int MIN_COMBINING_GAP_PX = 1;
 
   uint32_t cp;
   uint32_t prevCp = 0;
   while ((cp = utf8NextCodepoint(reinterpret_cast<const uint8_t**>(&text)))) {
     if (utf8IsCombiningMark(cp)) {
-      const EpdGlyph* combiningGlyph = font.getGlyph(cp, style);
+      const EpdGlyph* combiningGlyph = font->getGlyph(cp, style);
       int raiseBy = 0;
       if (combiningGlyph) {
         const int currentGap = combiningGlyph->top - combiningGlyph->height - lastBaseTop;
@@ -234,21 +256,21 @@ void GfxRenderer::drawText(const int fontId, const int x, const int y, const cha
 
       const int combiningX = lastBaseX + fp4::toPixel(lastBaseAdvanceFP / 2);
       const int combiningY = yPos - raiseBy;
-      renderCharImpl<TextRotation::None>(*this, renderMode, font, cp, combiningX, combiningY, black, style);
+      renderCharImpl<TextRotation::None>(*this, renderMode, *font, cp, combiningX, combiningY, black, style);
       continue;
     }
 
-    cp = font.applyLigatures(cp, text, style);
-    const int kernFP = (prevCp != 0) ? font.getKerning(prevCp, cp, style) : 0;  // 4.4 fixed-point kern
+    cp = font->applyLigatures(cp, text, style);
+    const int kernFP = (prevCp != 0) ? font->getKerning(prevCp, cp, style) : 0;  // 4.4 fixed-point kern
     xPosFP += kernFP;
 
     lastBaseX = fp4::toPixel(xPosFP);  // snap 12.4 fixed-point to nearest pixel
-    const EpdGlyph* glyph = font.getGlyph(cp, style);
+    const EpdGlyph* glyph = font->getGlyph(cp, style);
 
     lastBaseAdvanceFP = glyph ? glyph->advanceX : 0;
     lastBaseTop = glyph ? glyph->top : 0;
 
-    renderCharImpl<TextRotation::None>(*this, renderMode, font, cp, lastBaseX, yPos, black, style);
+    renderCharImpl<TextRotation::None>(*this, renderMode, *font, cp, lastBaseX, yPos, black, style);
     if (glyph) {
       xPosFP += glyph->advanceX;  // 12.4 fixed-point advance
     }
@@ -808,6 +830,7 @@ void GfxRenderer::clearScreen(const uint8_t color) const {
 }
 
 void GfxRenderer::invertScreen() const {
+  display.waitForRefresh();
   for (int i = 0; i < HalDisplay::BUFFER_SIZE; i++) {
     frameBuffer[i] = ~frameBuffer[i];
   }
@@ -819,6 +842,12 @@ void GfxRenderer::displayBuffer(const HalDisplay::RefreshMode refreshMode) const
   display.displayBuffer(refreshMode, fadingFix);
 }
 
+HalDisplay::RefreshHandle GfxRenderer::displayBufferAsync(const HalDisplay::RefreshMode refreshMode) const {
+  auto elapsed = millis() - start_ms;
+  LOG_DBG("GFX", "Time = %lu ms from clearScreen to displayBufferAsync", elapsed);
+  return display.displayBufferAsync(refreshMode, fadingFix);
+}
+
 std::string GfxRenderer::truncatedText(const int fontId, const char* text, const int maxWidth,
                                        const EpdFontFamily::Style style) const {
   if (!text || maxWidth <= 0) return "";
@@ -933,36 +962,35 @@ int GfxRenderer::getScreenHeight() const {
 }
 
 int GfxRenderer::getSpaceWidth(const int fontId, const EpdFontFamily::Style style) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
 
-  const EpdGlyph* spaceGlyph = fontIt->second.getGlyph(' ', style);
+  const EpdGlyph* spaceGlyph = font->getGlyph(' ', style);
   return spaceGlyph ? fp4::toPixel(spaceGlyph->advanceX) : 0;  // snap 12.4 fixed-point to nearest pixel
 }
 
 int GfxRenderer::getSpaceKernAdjust(const int fontId, const uint32_t leftCp, const uint32_t rightCp,
                                     const EpdFontFamily::Style style) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) return 0;
-  const auto& font = fontIt->second;
-  const int kernFP = font.getKerning(leftCp, ' ', style) + font.getKerning(' ', rightCp, style);  // 4.4 fixed-point
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) return 0;
+  const int kernFP = font->getKerning(leftCp, ' ', style) + font->getKerning(' ', rightCp, style);  // 4.4 fixed-point
   return fp4::toPixel(kernFP);  // snap 4.4 fixed-point to nearest pixel
 }
 
 int GfxRenderer::getKerning(const int fontId, const uint32_t leftCp, const uint32_t rightCp,
                             const EpdFontFamily::Style style) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) return 0;
-  const int kernFP = fontIt->second.getKerning(leftCp, rightCp, style);  // 4.4 fixed-point
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) return 0;
+  const int kernFP = font->getKerning(leftCp, rightCp, style);  // 4.4 fixed-point
   return fp4::toPixel(kernFP);                                           // snap 4.4 fixed-point to nearest pixel
 }
 
 int GfxRenderer::getTextAdvanceX(const int fontId, const char* text, EpdFontFamily::Style style) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
@@ -970,16 +998,15 @@ int GfxRenderer::getTextAdvanceX(const int fontId, const char* text, EpdFontFami
   uint32_t cp;
   uint32_t prevCp = 0;
   int32_t widthFP = 0;  // 12.4 fixed-point accumulator
-  const auto& font = fontIt->second;
   while ((cp = utf8NextCodepoint(reinterpret_cast<const uint8_t**>(&text)))) {
     if (utf8IsCombiningMark(cp)) {
       continue;
     }
-    cp = font.applyLigatures(cp, text, style);
+    cp = font->applyLigatures(cp, text, style);
     if (prevCp != 0) {
-      widthFP += font.getKerning(prevCp, cp, style);  // 4.4 fixed-point kern
+      widthFP += font->getKerning(prevCp, cp, style);  // 4.4 fixed-point kern
     }
-    const EpdGlyph* glyph = font.getGlyph(cp, style);
+    const EpdGlyph* glyph = font->getGlyph(cp, style);
     if (glyph) widthFP += glyph->advanceX;  // 12.4 fixed-point advance
     prevCp = cp;
   }
@@ -987,32 +1014,32 @@ int GfxRenderer::getTextAdvanceX(const int fontId, const char* text, EpdFontFami
 }
 
 int GfxRenderer::getFontAscenderSize(const int fontId) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
 
-  return fontIt->second.getData(EpdFontFamily::REGULAR)->ascender;
+  return font->getData(EpdFontFamily::REGULAR)->ascender;
 }
 
 int GfxRenderer::getLineHeight(const int fontId) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
 
-  return fontIt->second.getData(EpdFontFamily::REGULAR)->advanceY;
+  return font->getData(EpdFontFamily::REGULAR)->advanceY;
 }
 
 int GfxRenderer::getTextHeight(const int fontId) const {
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return 0;
   }
-  return fontIt->second.getData(EpdFontFamily::REGULAR)->ascender;
+  return font->getData(EpdFontFamily::REGULAR)->ascender;
 }
 
 void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y, const char* text, const bool black,
@@ -1022,14 +1049,12 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
     return;
   }
 
-  const auto fontIt = fontMap.find(fontId);
-  if (fontIt == fontMap.end()) {
+  const EpdFontFamily* font = findFont(fontId);
+  if (!font) {
     LOG_ERR("GFX", "Font %d not found", fontId);
     return;
   }
 
-  const auto& font = fontIt->second;
-
   int32_t yPosFP = fp4::fromPixel(y);  // 12.4 fixed-point accumulator
   int lastBaseY = y;
   int lastBaseAdvanceFP = 0;  // 12.4 fixed-point
@@ -1040,7 +1065,7 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
   uint32_t prevCp = 0;
   while ((cp = utf8NextCodepoint(reinterpret_cast<const uint8_t**>(&text)))) {
     if (utf8IsCombiningMark(cp)) {
-      const EpdGlyph* combiningGlyph = font.getGlyph(cp, style);
+      const EpdGlyph* combiningGlyph = font->getGlyph(cp, style);
       int raiseBy = 0;
       if (combiningGlyph) {
         const int currentGap = combiningGlyph->top - combiningGlyph->height - lastBaseTop;
@@ -1051,22 +1076,22 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
 
       const int combiningX = x - raiseBy;
       const int combiningY = lastBaseY - fp4::toPixel(lastBaseAdvanceFP / 2);
-      renderCharImpl<TextRotation::Rotated90CW>(*this, renderMode, font, cp, combiningX, combiningY, black, style);
+      renderCharImpl<TextRotation::Rotated90CW>(*this, renderMode, *font, cp, combiningX, combiningY, black, style);
       continue;
     }
 
-    cp = font.applyLigatures(cp, text, style);
+    cp = font->applyLigatures(cp, text, style);
     if (prevCp != 0) {
-      yPosFP -= font.getKerning(prevCp, cp, style);  // 4.4 fixed-point kern (subtract for rotated)
+      yPosFP -= font->getKerning(prevCp, cp, style);  // 4.4 fixed-point kern (subtract for rotated)
     }
 
     lastBaseY = fp4::toPixel(yPosFP);  // snap 12.4 fixed-point to nearest pixel
-    const EpdGlyph* glyph = font.getGlyph(cp, style);
+    const EpdGlyph* glyph = font->getGlyph(cp, style);
 
     lastBaseAdvanceFP = glyph ? glyph->advanceX : 0;  // 12.4 fixed-point
     lastBaseTop = glyph ? glyph->top : 0;
 
-    renderCharImpl<TextRotation::Rotated90CW>(*this, renderMode, font, cp, x, lastBaseY, black, style);
+    renderCharImpl<TextRotation::Rotated90CW>(*this, renderMode, *font, cp, x, lastBaseY, black, style);
     if (glyph) {
       yPosFP -= glyph->advanceX;  // 12.4 fixed-point advance (subtract for rotated)
     }
@@ -1074,10 +1099,37 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
   }
 }
 
-uint8_t* GfxRenderer::getFrameBuffer() const { return frameBuffer; }
+uint8_t* GfxRenderer::getFrameBuffer() const {
+  display.waitForRefresh();
+  return frameBuffer;
+}
 
 size_t GfxRenderer::getBufferSize() { return HalDisplay::BUFFER_SIZE; }
 
+void GfxRenderer::toPhysical(const int x, const int y, int* phyX, int* phyY) const {
+  rotateCoordinates(orientation, x, y, phyX, phyY);
+}
+
+void GfxRenderer::drawPhysicalMask(const int byteX, const int phyY, const int rowBytes, const int rows,
+                                   const uint8_t* mask) const {
+  if (byteX < 0 || rowBytes <= 0 || byteX + rowBytes > HalDisplay::DISPLAY_WIDTH_BYTES || phyY < 0 ||
+      phyY + rows > HalDisplay::DISPLAY_HEIGHT) {
+    LOG_ERR("GFX", "!! Mask outside range (%d, %d) %dx%d", byteX, phyY, rowBytes, rows);
+    return;
+  }
+
+  uint8_t* dst = frameBuffer + phyY * HalDisplay::DISPLAY_WIDTH_BYTES + byteX;
+  for (int row = 0; row < rows; row++) {
+    if (renderMode == BW) {
+      for (int i = 0; i < rowBytes; i++) dst[i] &= ~mask[i];
+    } else {
+      for (int i = 0; i < rowBytes; i++) dst[i] |= mask[i];
+    }
+    dst += HalDisplay::DISPLAY_WIDTH_BYTES;
+    mask += rowBytes;
+  }
+}
+
 // unused
 // void GfxRenderer::grayscaleRevert() const { display.grayscaleRevert(); }
 
@@ -1099,10 +1151,33 @@ void GfxRenderer::freeBwBufferChunks() {
 /**
  * This should be called before grayscale buffers are populated.
  * A `restoreBwBuffer` call should always follow the grayscale render if this method was called.
- * Uses chunked allocation to avoid needing 48KB of contiguous memory.
+ * The frame is PackBits-compressed into a small persistent buffer; only when it doesn't fit (busy image pages) is it
+ * copied uncompressed, using chunked allocation to avoid needing 48KB of contiguous memory.
  * Returns true if buffer was stored successfully, false if allocation failed.
  */
 bool GfxRenderer::storeBwBuffer() {
+  if (bwSnapshotSize > 0) {
+    LOG_ERR("GFX", "!! BW snapshot already stored - this is likely a bug, dropping it");
+    bwSnapshotSize = 0;
+  }
+
+  if (!bwSnapshot) {
+    bwSnapshot = static_cast<uint8_t*>(
+        MemBudget.allocate("bw snapshot", BW_SNAPSHOT_CAPACITY, MemoryBudget::Priority::Medium));
+    if (!bwSnapshot) {
+      LOG_ERR("GFX", "!! Failed to allocate BW snapshot buffer (%zu bytes)", BW_SNAPSHOT_CAPACITY);
+    }
+  }
+  if (bwSnapshot) {
+    bwSnapshotSize = packbits::encode(frameBuffer, HalDisplay::BUFFER_SIZE, bwSnapshot, BW_SNAPSHOT_CAPACITY);
+    if (bwSnapshotSize > 0) {
+      freeBwBufferChunks();
+      LOG_DBG("GFX", "Stored BW buffer compressed to %zu bytes", bwSnapshotSize);
+      return true;
+    }
+    LOG_DBG("GFX", "BW buffer does not compress below %zu bytes, storing uncompressed", BW_SNAPSHOT_CAPACITY);
+  }
+
   // Allocate and copy each chunk
   for (size_t i = 0; i < BW_BUFFER_NUM_CHUNKS; i++) {
     // Check if any chunks are already allocated
@@ -1132,32 +1207,38 @@ bool GfxRenderer::storeBwBuffer() {
 /**
  * This can only be called if `storeBwBuffer` was called prior to the grayscale render.
  * It should be called to restore the BW buffer state after grayscale rendering is complete.
- * Uses chunked restoration to match chunked storage.
+ * Unpacks the compressed snapshot, or copies back and frees the uncompressed chunks.
  */
 void GfxRenderer::restoreBwBuffer() {
-  // Check if all chunks are allocated
-  bool missingChunks = false;
-  for (const auto& bwBufferChunk : bwBufferChunks) {
-    if (!bwBufferChunk) {
-      missingChunks = true;
-      break;
+  if (bwSnapshotSize > 0) {
+    display.waitForRefresh();
+    packbits::decode(bwSnapshot, bwSnapshotSize, frameBuffer, HalDisplay::BUFFER_SIZE);
+    bwSnapshotSize = 0;
+  } else {
+    // Check if all chunks are allocated
+    bool missingChunks = false;
+    for (const auto& bwBufferChunk : bwBufferChunks) {
+      if (!bwBufferChunk) {
+        missingChunks = true;
+        break;
+      }
     }
-  }
 
-  if (missingChunks) {
-    freeBwBufferChunks();
-    return;
-  }
+    if (missingChunks) {
+      freeBwBufferChunks();
+      return;
+    }
 
-  for (size_t i = 0; i < BW_BUFFER_NUM_CHUNKS; i++) {
-    const size_t offset = i * BW_BUFFER_CHUNK_SIZE;
-    memcpy(frameBuffer + offset, bwBufferChunks[i], BW_BUFFER_CHUNK_SIZE);
+    display.waitForRefresh();
+    for (size_t i = 0; i < BW_BUFFER_NUM_CHUNKS; i++) {
+      const size_t offset = i * BW_BUFFER_CHUNK_SIZE;
+      memcpy(frameBuffer + offset, bwBufferChunks[i], BW_BUFFER_CHUNK_SIZE);
+    }
+    freeBwBufferChunks();
   }
 
   display.cleanupGrayscaleBuffers(frameBuffer);
-
-  freeBwBufferChunks();
-  LOG_DBG("GFX", "Restored and freed BW buffer chunks");
+  LOG_DBG("GFX", "Restored BW buffer");
 }
 
 /**
@@ -27,6 +27,9 @@ class GfxRenderer {
   };
 
  private:
+  // BW snapshot for grayscale passes: PackBits-compressed into a persistent buffer (a text page is mostly white and
+  // packs to a few KB). Only frames that don't fit fall back to the uncompressed, chunked copy.
+  static constexpr size_t BW_SNAPSHOT_CAPACITY = 16 * 1024;
   static constexpr size_t BW_BUFFER_CHUNK_SIZE = 8000;  // 8KB chunks to allow for non-contiguous memory
   static constexpr size_t BW_BUFFER_NUM_CHUNKS = HalDisplay::BUFFER_SIZE / BW_BUFFER_CHUNK_SIZE;
   static_assert(BW_BUFFER_CHUNK_SIZE * BW_BUFFER_NUM_CHUNKS == HalDisplay::BUFFER_SIZE,
@@ -37,10 +40,15 @@ class GfxRenderer {
   Orientation orientation;
   bool fadingFix;
   uint8_t* frameBuffer = nullptr;
+  uint8_t* bwSnapshot = nullptr;  // allocated on first use, kept for the renderer's lifetime
+  size_t bwSnapshotSize = 0;      // compressed bytes held in bwSnapshot, 0 when none is stored
   uint8_t* bwBufferChunks[BW_BUFFER_NUM_CHUNKS] = {nullptr};
   std::map<int, EpdFontFamily> fontMap;
+  const EpdFontFamily* (*fontResolver)(int fontId) = nullptr;
   FontDecompressor* fontDecompressor = nullptr;
+
   void freeBwBufferChunks();
+  const EpdFontFamily* findFont(int fontId) const;
   template <Color color>
   void drawPixelDither(int x, int y) const;
   template <Color color>
@@ -49,7 +57,10 @@ class GfxRenderer {
  public:
   explicit GfxRenderer(HalDisplay& halDisplay)
       : display(halDisplay), renderMode(BW), orientation(Portrait), fadingFix(false) {}
-  ~GfxRenderer() { freeBwBufferChunks(); }
+  ~GfxRenderer() {
+    freeBwBufferChunks();
+    free(bwSnapshot);
+  }
 
   static constexpr int VIEWABLE_MARGIN_TOP = 9;
   static constexpr int VIEWABLE_MARGIN_RIGHT = 3;
@@ -59,6 +70,8 @@ class GfxRenderer {
   // Setup
   void begin();  // must be called right after display.begin()
   void insertFont(int fontId, EpdFontFamily font);
+  // Supplies fonts that were not inserted up front; returns nullptr for unknown ids
+  void setFontResolver(const EpdFontFamily* (*resolver)(int fontId)) { fontResolver = resolver; }
   void setFontDecompressor(FontDecompressor* d) { fontDecompressor = d; }
   void clearFontCache() {
     if (fontDecompressor) fontDecompressor->clearCache();
@@ -75,6 +88,11 @@ class GfxRenderer {
   int getScreenWidth() const;
   int getScreenHeight() const;
   void displayBuffer(HalDisplay::RefreshMode refreshMode = HalDisplay::FAST_REFRESH) const;
+  // Starts the refresh and returns at once, so CPU work that needs neither the SD card nor the frame buffer can run
+  // during the panel's BUSY time. Nothing may draw into the frame buffer until the handle is done; clearScreen() and
+  // the buffer/display calls wait by themselves.
+  HalDisplay::RefreshHandle displayBufferAsync(HalDisplay::RefreshMode refreshMode = HalDisplay::FAST_REFRESH) const;
+  void waitForRefresh() const { display.waitForRefresh(); }
   // EXPERIMENTAL: Windowed update - display only a rectangular region
   // void displayWindow(int x, int y, int width, int height) const;
   void invertScreen() const;
@@ -147,4 +165,9 @@ class GfxRenderer {
   // Low level functions
   uint8_t* getFrameBuffer() const;
   static size_t getBufferSize();
+  // Map a logical coordinate to physical panel coordinates for the current orientation
+  void toPhysical(int x, int y, int* phyX, int* phyY) const;
+  // Apply a 1bpp ink mask laid out in panel space, starting at byte column byteX of panel row phyY.
+  // BW mode clears the masked bits (black), grayscale modes set them - same as drawPixel(true/false).
+  void drawPhysicalMask(int byteX, int phyY, int rowBytes, int rows, const uint8_t* mask) const;
 };
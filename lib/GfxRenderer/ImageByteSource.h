@@ -0,0 +1,37 @@
+#pragma once
+
+#include <HalStorage.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Sequential byte input for the image decoders. Lets covers be decoded straight from a ZIP entry
+// as well as from a file on the SD card.
+class ImageByteSource {
+ public:
+  virtual ~ImageByteSource() = default;
+  // Returns the number of bytes read; 0 at end of stream or on error
+  virtual size_t read(uint8_t* dest, size_t len) = 0;
+  // Discards len bytes. Default implementation reads through a small scratch buffer.
+  virtual bool skip(size_t len) {
+    uint8_t scratch[64];
+    while (len > 0) {
+      const size_t chunk = len < sizeof(scratch) ? len : sizeof(scratch);
+      if (read(scratch, chunk) != chunk) return false;
+      len -= chunk;
+    }
+    return true;
+  }
+};
+
+class FileByteSource final : public ImageByteSource {
+  FsFile& file;
+
+ public:
+  explicit FileByteSource(FsFile& file) : file(file) {}
+  size_t read(uint8_t* dest, const size_t len) override {
+    const int bytesRead = file.read(dest, len);
+    return bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+  }
+  bool skip(const size_t len) override { return file.seekCur(len); }
+};
@@ -0,0 +1,58 @@
+#include "PackBits.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace packbits {
+
+size_t encode(const uint8_t* src, const size_t length, uint8_t* dst, const size_t capacity) {
+  size_t out = 0;
+  size_t i = 0;
+  while (i < length) {
+    size_t run = 1;
+    while (i + run < length && run < 128 && src[i + run] == src[i]) run++;
+    if (run >= 2) {
+      if (out + 2 > capacity) return 0;
+      dst[out++] = static_cast<uint8_t>(257 - run);
+      dst[out++] = src[i];
+      i += run;
+      continue;
+    }
+
+    // Literal span, ended by the next pair of equal bytes
+    size_t literal = 1;
+    while (i + literal < length && literal < 128 &&
+           !(i + literal + 1 < length && src[i + literal] == src[i + literal + 1])) {
+      literal++;
+    }
+    if (out + 1 + literal > capacity) return 0;
+    dst[out++] = static_cast<uint8_t>(literal - 1);
+    memcpy(dst + out, src + i, literal);
+    out += literal;
+    i += literal;
+  }
+  return out;
+}
+
+size_t decode(const uint8_t* src, const size_t length, uint8_t* dst, const size_t dstLength) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < length && out < dstLength) {
+    const uint8_t header = src[in++];
+    if (header < 128) {
+      if (in + header + 1 > length) break;  // truncated input
+      const size_t count = std::min<size_t>(header + 1, dstLength - out);
+      memcpy(dst + out, src + in, count);
+      in += header + 1;
+      out += count;
+    } else if (header > 128) {
+      if (in >= length) break;
+      const size_t count = std::min<size_t>(257 - header, dstLength - out);
+      memset(dst + out, src[in++], count);
+      out += count;
+    }
+  }
+  return out;
+}
+
+}  // namespace packbits
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// PackBits run-length coding, used for frame buffer snapshots: a page of text is mostly white and shrinks to a few KB.
+// Header n < 128 is followed by n + 1 literal bytes, n > 128 by one byte repeated 257 - n times.
+namespace packbits {
+
+// Returns the packed size, or 0 if it would exceed capacity
+size_t encode(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity);
+
+// Unpacks into dst, writing at most dstLength bytes. Returns the number of bytes written.
+size_t decode(const uint8_t* src, size_t length, uint8_t* dst, size_t dstLength);
+
+}  // namespace packbits
@@ -0,0 +1,191 @@
+#include "ScaledBmpWriter.h"
+
+#include <Logging.h>
+#include <Print.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "BitmapHelpers.h"
+
+// ============================================================================
+// IMAGE PROCESSING OPTIONS - shared by JpegToBmpConverter and PngToBmpConverter
+// ============================================================================
+constexpr bool USE_8BIT_OUTPUT = false;  // true: 8-bit grayscale (no quantization), false: 2-bit (4 levels)
+// Dithering method selection (only one should be true, or all false for simple quantization):
+constexpr bool USE_ATKINSON = true;          // Atkinson dithering (cleaner than F-S, less error diffusion)
+constexpr bool USE_FLOYD_STEINBERG = false;  // Floyd-Steinberg error diffusion (can cause "worm" artifacts)
+// ============================================================================
+
+namespace {
+inline void write16(Print& out, const uint16_t value) {
+  out.write(value & 0xFF);
+  out.write((value >> 8) & 0xFF);
+}
+
+inline void write32(Print& out, const uint32_t value) {
+  out.write(value & 0xFF);
+  out.write((value >> 8) & 0xFF);
+  out.write((value >> 16) & 0xFF);
+  out.write((value >> 24) & 0xFF);
+}
+
+// Tone-maps and error-diffuses one output row, packing BITS-per-pixel levels MSB first. Templated on the kernel so
+// the per-pixel loop has no mode branches.
+template <int BITS, typename Ditherer>
+void ditherRow(Ditherer& ditherer, const uint8_t* grayRow, uint8_t* packed, const int width) {
+  constexpr int PIXELS_PER_BYTE = 8 / BITS;
+  for (int x = 0; x < width; x++) {
+    const uint8_t level = ditherer.processPixel(TONE_CURVE[grayRow[x]], x);
+    packed[x / PIXELS_PER_BYTE] |= level << ((PIXELS_PER_BYTE - 1 - x % PIXELS_PER_BYTE) * BITS);
+  }
+  ditherer.nextRow();
+}
+
+// Writes a top-down BITMAPINFOHEADER BMP header followed by a gray palette of (1 << bitsPerPixel) entries
+void writeBmpHeader(Print& bmpOut, const int width, const int height, const int bitsPerPixel) {
+  const int bytesPerRow = (width * bitsPerPixel + 31) / 32 * 4;  // rows padded to 4 bytes
+  const uint32_t imageSize = bytesPerRow * height;
+  const uint32_t colors = 1u << bitsPerPixel;
+  const uint32_t dataOffset = 14 + 40 + colors * 4;
+
+  // BMP File Header (14 bytes)
+  bmpOut.write('B');
+  bmpOut.write('M');
+  write32(bmpOut, dataOffset + imageSize);  // File size
+  write32(bmpOut, 0);                       // Reserved
+  write32(bmpOut, dataOffset);              // Offset to pixel data
+
+  // DIB Header (BITMAPINFOHEADER - 40 bytes)
+  write32(bmpOut, 40);
+  write32(bmpOut, static_cast<uint32_t>(width));
+  write32(bmpOut, static_cast<uint32_t>(-height));  // Negative height = top-down bitmap
+  write16(bmpOut, 1);                               // Color planes
+  write16(bmpOut, bitsPerPixel);
+  write32(bmpOut, 0);  // BI_RGB (no compression)
+  write32(bmpOut, imageSize);
+  write32(bmpOut, 2835);  // xPixelsPerMeter (72 DPI)
+  write32(bmpOut, 2835);  // yPixelsPerMeter (72 DPI)
+  write32(bmpOut, colors);
+  write32(bmpOut, colors);
+
+  // Evenly spaced grays, BGRA: 1-bit 0/255, 2-bit 0/85/170/255, 8-bit 0..255
+  for (uint32_t i = 0; i < colors; i++) {
+    const auto level = static_cast<uint8_t>(i * 255 / (colors - 1));
+    bmpOut.write(level);
+    bmpOut.write(level);
+    bmpOut.write(level);
+    bmpOut.write(static_cast<uint8_t>(0));
+  }
+}
+}  // namespace
+
+void ScaledBmpWriter::scaledSize(const int srcWidth, const int srcHeight, const int targetWidth,
+                                 const int targetHeight, const bool crop, int* outWidth, int* outHeight) {
+  *outWidth = srcWidth;
+  *outHeight = srcHeight;
+  if (targetWidth <= 0 || targetHeight <= 0 || (srcWidth == targetWidth && srcHeight == targetHeight)) {
+    return;
+  }
+
+  const float scaleToFitWidth = static_cast<float>(targetWidth) / srcWidth;
+  const float scaleToFitHeight = static_cast<float>(targetHeight) / srcHeight;
+  float scale;
+  if (crop) {  // scale to the larger factor so the image fills the target
+    scale = (scaleToFitWidth > scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
+  } else {  // else, scale to the smaller factor to fit
+    scale = (scaleToFitWidth < scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
+  }
+
+  *outWidth = static_cast<int>(srcWidth * scale);
+  *outHeight = static_cast<int>(srcHeight * scale);
+  if (*outWidth < 1) *outWidth = 1;
+  if (*outHeight < 1) *outHeight = 1;
+}
+
+ScaledBmpWriter::ScaledBmpWriter(Print& out, const int outWidth, const int outHeight, const bool oneBit)
+    : out(out), outWidth(outWidth), outHeight(outHeight), oneBit(oneBit) {}
+
+ScaledBmpWriter::~ScaledBmpWriter() {
+  delete atkinsonDitherer;
+  delete fsDitherer;
+  delete atkinson1BitDitherer;
+  free(rowBuffer);
+}
+
+bool ScaledBmpWriter::begin(const int srcWidth, const int srcHeight) {
+  this->srcWidth = srcWidth;
+  currentOutY = 0;
+  if (!scaler.begin(srcWidth, srcHeight, outWidth, outHeight)) {
+    return false;
+  }
+
+  int bitsPerPixel;
+  if (oneBit) {
+    bitsPerPixel = 1;
+  } else if (USE_8BIT_OUTPUT) {
+    bitsPerPixel = 8;
+  } else {
+    bitsPerPixel = 2;
+  }
+  bytesPerRow = (outWidth * bitsPerPixel + 31) / 32 * 4;
+
+  rowBuffer = static_cast<uint8_t*>(malloc(bytesPerRow));
+  if (!rowBuffer) {
+    LOG_ERR("BMW", "Failed to allocate row buffer (%d bytes)", bytesPerRow);
+    return false;
+  }
+
+  // Dither at OUTPUT dimensions (after prescaling) to avoid artifacts from post-downsampling
+  if (oneBit) {
+    atkinson1BitDitherer = new Atkinson1BitDitherer(outWidth);
+  } else if (!USE_8BIT_OUTPUT) {
+    if (USE_ATKINSON) {
+      atkinsonDitherer = new AtkinsonDitherer(outWidth);
+    } else if (USE_FLOYD_STEINBERG) {
+      fsDitherer = new FloydSteinbergDitherer(outWidth);
+    }
+  }
+
+  writeBmpHeader(out, outWidth, outHeight, bitsPerPixel);
+  return true;
+}
+
+// Quantizes one averaged output row into the BMP
+void ScaledBmpWriter::writeOutputRow(const uint8_t* grayRow) {
+  memset(rowBuffer, 0, bytesPerRow);
+
+  if (atkinson1BitDitherer) {
+    ditherRow<1>(*atkinson1BitDitherer, grayRow, rowBuffer, outWidth);
+  } else if (atkinsonDitherer) {
+    ditherRow<2>(*atkinsonDitherer, grayRow, rowBuffer, outWidth);
+  } else if (fsDitherer) {
+    ditherRow<2>(*fsDitherer, grayRow, rowBuffer, outWidth);
+  } else if (USE_8BIT_OUTPUT) {
+    for (int x = 0; x < outWidth; x++) {
+      rowBuffer[x] = TONE_CURVE[grayRow[x]];
+    }
+  } else {
+    for (int x = 0; x < outWidth; x++) {
+      rowBuffer[x / 4] |= quantize(TONE_CURVE[grayRow[x]], x, currentOutY) << (6 - (x % 4) * 2);
+    }
+  }
+
+  out.write(rowBuffer, bytesPerRow);
+  currentOutY++;
+}
+
+void ScaledBmpWriter::pushRow(const uint8_t* grayRow) {
+  scaler.addSegment(grayRow, 0, srcWidth);
+  endRow();
+}
+
+void ScaledBmpWriter::endRow() {
+  if (!rowBuffer) {
+    return;
+  }
+  // One source row may complete several output rows when upscaling
+  for (int rows = scaler.endRow(); rows > 0; rows--) {
+    writeOutputRow(scaler.averagedRow());
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AreaScaler.h"
+#include "Dithering.h"
+
+class Print;
+
+// One requested BMP rendition of a decoded image (e.g. cover, cropped cover, home screen thumbnail)
+struct ScaledBmpTarget {
+  Print* out;
+  int maxWidth;
+  int maxHeight;
+  bool oneBit;  // 1-bit (thumbnails) instead of 2-bit
+  bool crop;    // scale to fill maxWidth x maxHeight instead of fitting inside it
+};
+
+// Streams grayscale source rows into an area-averaged (see AreaScaler), dithered, top-down BMP.
+// Decoders push every source row to each writer, so a single decode can emit several sizes at once.
+class ScaledBmpWriter {
+ public:
+  // Output size for a srcWidth x srcHeight image scaled to fit (or fill, with crop) the target, keeping aspect ratio
+  static void scaledSize(int srcWidth, int srcHeight, int targetWidth, int targetHeight, bool crop, int* outWidth,
+                         int* outHeight);
+
+  ScaledBmpWriter(Print& out, int outWidth, int outHeight, bool oneBit);
+  ~ScaledBmpWriter();
+
+  ScaledBmpWriter(const ScaledBmpWriter&) = delete;
+  ScaledBmpWriter& operator=(const ScaledBmpWriter&) = delete;
+
+  // Writes the BMP header and allocates row state. Returns false on allocation failure.
+  bool begin(int srcWidth, int srcHeight);
+  // Feeds the next source row (srcWidth gray pixels); emits any output rows it completes
+  void pushRow(const uint8_t* grayRow);
+  // Same as pushRow, for decoders that convert a source row in segments (in order, then endRow)
+  void pushSegment(const uint8_t* gray, int startX, int count) { scaler.addSegment(gray, startX, count); }
+  void endRow();
+
+  int getOutputWidth() const { return outWidth; }
+  int getOutputHeight() const { return outHeight; }
+
+ private:
+  void writeOutputRow(const uint8_t* grayRow);
+
+  Print& out;
+  int outWidth;
+  int outHeight;
+  bool oneBit;
+
+  int srcWidth = 0;
+  int bytesPerRow = 0;
+  int currentOutY = 0;
+
+  AreaScaler scaler;
+  uint8_t* rowBuffer = nullptr;
+  AtkinsonDitherer* atkinsonDitherer = nullptr;
+  FloydSteinbergDitherer* fsDitherer = nullptr;
+  Atkinson1BitDitherer* atkinson1BitDitherer = nullptr;
+};
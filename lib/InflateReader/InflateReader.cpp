@@ -1,5 +1,9 @@
 #include "InflateReader.h"
 
+#include <AllocTracker.h>
+#include <MemoryBudget.h>
+#include <Trace.h>
+
 #include <cstring>
 #include <type_traits>
 
@@ -14,10 +18,12 @@ static_assert(std::is_standard_layout<InflateReader>::value,
 InflateReader::~InflateReader() { deinit(); }
 
 bool InflateReader::init(const bool streaming) {
+  ALLOC_TAG(Inflate);
   deinit();  // free any previously allocated ring buffer and reset state
 
   if (streaming) {
-    ringBuffer = static_cast<uint8_t*>(malloc(INFLATE_DICT_SIZE));
+    ringBuffer =
+        static_cast<uint8_t*>(MemBudget.allocate("inflate", INFLATE_DICT_SIZE, MemoryBudget::Priority::High));
     if (!ringBuffer) return false;
     memset(ringBuffer, 0, INFLATE_DICT_SIZE);
   }
@@ -27,6 +33,7 @@ bool InflateReader::init(const bool streaming) {
 }
 
 void InflateReader::deinit() {
+  ALLOC_TAG(Inflate);
   if (ringBuffer) {
     free(ringBuffer);
     ringBuffer = nullptr;
@@ -47,6 +54,7 @@ void InflateReader::skipZlibHeader() {
 }
 
 bool InflateReader::read(uint8_t* dest, size_t len) {
+  TRACE_SPAN_MIN("inflate", 500);
   if (!ringBuffer) {
     // One-shot mode: back-references use absolute offset from dest_start.
     // Valid only when read() is called once with the full output buffer.
@@ -61,6 +69,7 @@ bool InflateReader::read(uint8_t* dest, size_t len) {
 }
 
 InflateStatus InflateReader::readAtMost(uint8_t* dest, size_t maxLen, size_t* produced) {
+  TRACE_SPAN_MIN("inflate", 500);
   if (!ringBuffer) {
     // One-shot mode: back-references use absolute offset from dest_start.
     // Valid only when readAtMost() is called once with the full output buffer.
@@ -2,14 +2,15 @@
 
 #include <HalStorage.h>
 
+#include <cstddef>
+
 class Print;
-class ZipFile;
+class ImageByteSource;
+struct ScaledBmpTarget;
 
 class JpegToBmpConverter {
   static unsigned char jpegReadCallback(unsigned char* pBuf, unsigned char buf_size,
                                         unsigned char* pBytes_actually_read, void* pCallback_data);
-  static bool jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bmpOut, int targetWidth, int targetHeight,
-                                          bool oneBit, bool crop = true);
 
  public:
   static bool jpegFileToBmpStream(FsFile& jpegFile, Print& bmpOut, bool crop = true);
@@ -17,4 +18,6 @@ class JpegToBmpConverter {
   static bool jpegFileToBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   // Convert to 1-bit BMP (black and white only, no grays) for fast home screen rendering
   static bool jpegFileTo1BitBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Decode once and write every target (e.g. cover, cropped cover and thumbnails) in the same pass
+  static bool jpegToBmpStreams(ImageByteSource& source, const ScaledBmpTarget* targets, size_t targetCount);
 };
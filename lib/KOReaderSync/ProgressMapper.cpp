@@ -2,19 +2,27 @@
 
 #include <Logging.h>
 
+#include <algorithm>
 #include <cmath>
 
-KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos) {
+KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos,
+                                            const PageMap* pageMap) {
   KOReaderPosition result;
 
-  // Calculate page progress within current spine item
-  float intraSpineProgress = 0.0f;
-  if (pos.totalPages > 0) {
-    intraSpineProgress = static_cast<float>(pos.pageNumber) / static_cast<float>(pos.totalPages);
-  }
+  if (pageMap && pageMap->isComplete() && pageMap->getTotalPages() > 0) {
+    // Every section's page count is known, so the book position is exact
+    result.percentage = static_cast<float>(pageMap->getBookPage(pos.spineIndex, pos.pageNumber)) /
+                        static_cast<float>(pageMap->getTotalPages());
+  } else {
+    // Calculate page progress within current spine item
+    float intraSpineProgress = 0.0f;
+    if (pos.totalPages > 0) {
+      intraSpineProgress = static_cast<float>(pos.pageNumber) / static_cast<float>(pos.totalPages);
+    }
 
-  // Calculate overall book progress (0.0-1.0)
-  result.percentage = epub->calculateProgress(pos.spineIndex, intraSpineProgress);
+    // Calculate overall book progress (0.0-1.0)
+    result.percentage = epub->calculateProgress(pos.spineIndex, intraSpineProgress);
+  }
 
   // Generate XPath with estimated paragraph position based on page
   result.xpath = generateXPath(pos.spineIndex, pos.pageNumber, pos.totalPages);
@@ -30,12 +38,24 @@ KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, c
 }
 
 CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epub, const KOReaderPosition& koPos,
-                                                int currentSpineIndex, int totalPagesInCurrentSpine) {
+                                                int currentSpineIndex, int totalPagesInCurrentSpine,
+                                                const PageMap* pageMap) {
   CrossPointPosition result;
   result.spineIndex = 0;
   result.pageNumber = 0;
   result.totalPages = 0;
 
+  if (pageMap && pageMap->isComplete() && pageMap->getTotalPages() > 0) {
+    const auto bookPage =
+        static_cast<uint32_t>(std::max(0.0f, koPos.percentage) * static_cast<float>(pageMap->getTotalPages()));
+    if (pageMap->locateBookPage(bookPage, result.spineIndex, result.pageNumber)) {
+      result.totalPages = pageMap->getSectionPages(result.spineIndex);
+      LOG_DBG("ProgressMapper", "KOReader -> CrossPoint: %.2f%% -> spine=%d, page=%d (page map)",
+              koPos.percentage * 100, result.spineIndex, result.pageNumber);
+      return result;
+    }
+  }
+
   const size_t bookSize = epub->getBookSize();
   if (bookSize == 0) {
     return result;
@@ -45,23 +65,9 @@ CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epu
   // XPath parsing is unreliable since CrossPoint doesn't preserve detailed HTML structure
   const size_t targetBytes = static_cast<size_t>(bookSize * koPos.percentage);
 
-  // Find the spine item that contains this byte position
-  const int spineCount = epub->getSpineItemsCount();
-  bool spineFound = false;
-  for (int i = 0; i < spineCount; i++) {
-    const size_t cumulativeSize = epub->getCumulativeSpineItemSize(i);
-    if (cumulativeSize >= targetBytes) {
-      result.spineIndex = i;
-      spineFound = true;
-      break;
-    }
-  }
-
-  // If no spine item was found (e.g., targetBytes beyond last cumulative size),
-  // default to the last spine item so we map to the end of the book instead of the beginning.
-  if (!spineFound && spineCount > 0) {
-    result.spineIndex = spineCount - 1;
-  }
+  // Find the spine item that contains this byte position. Past the last cumulative size this is the last spine item,
+  // so we map to the end of the book instead of the beginning.
+  result.spineIndex = std::max(0, epub->getSpineIndexForBookOffset(targetBytes));
 
   // Estimate page number within the spine item using percentage
   if (result.spineIndex < epub->getSpineItemsCount()) {
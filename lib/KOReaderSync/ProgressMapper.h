@@ -1,5 +1,6 @@
 #pragma once
 #include <Epub.h>
+#include <Epub/PageMap.h>
 
 #include <memory>
 #include <string>
@@ -38,9 +39,11 @@ class ProgressMapper {
    *
    * @param epub The EPUB book
    * @param pos CrossPoint position
+   * @param pageMap Book page map for the current layout; the percentage is exact when it is complete
    * @return KOReader position
    */
-  static KOReaderPosition toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos);
+  static KOReaderPosition toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos,
+                                     const PageMap* pageMap = nullptr);
 
   /**
    * Convert KOReader position to CrossPoint format.
@@ -52,10 +55,12 @@ class ProgressMapper {
    * @param koPos KOReader position
    * @param currentSpineIndex Index of the currently open spine item (for density estimation)
    * @param totalPagesInCurrentSpine Total pages in the current spine item (for density estimation)
+   * @param pageMap Book page map for the current layout; the position is exact when it is complete
    * @return CrossPoint position
    */
   static CrossPointPosition toCrossPoint(const std::shared_ptr<Epub>& epub, const KOReaderPosition& koPos,
-                                         int currentSpineIndex = -1, int totalPagesInCurrentSpine = 0);
+                                         int currentSpineIndex = -1, int totalPagesInCurrentSpine = 0,
+                                         const PageMap* pageMap = nullptr);
 
  private:
   /**
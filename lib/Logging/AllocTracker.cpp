@@ -0,0 +1,189 @@
+#ifdef ENABLE_ALLOC_TRACKER
+
+#include "AllocTracker.h"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstring>
+
+#include "Logging.h"
+
+namespace {
+// Same heap ESP.getFreeHeap() / ESP.getMaxAllocHeap() report on
+constexpr uint32_t HEAP_CAPS = MALLOC_CAP_INTERNAL;
+// Tasks that can hold a tag at the same time: main loop, render, display refresh, one spare
+constexpr size_t MAX_TAGGED_TASKS = 4;
+
+constexpr const char* TAG_NAMES[] = {"other", "epub-index", "fonts", "images", "webserver", "inflate"};
+static_assert(sizeof(TAG_NAMES) / sizeof(TAG_NAMES[0]) == alloctrack::TAG_COUNT, "TAG_NAMES out of sync with Tag");
+
+struct TaskTag {
+  TaskHandle_t task;
+  alloctrack::Tag tag;
+};
+
+alloctrack::TagStats tagStats[alloctrack::TAG_COUNT] = {};
+TaskTag taskTags[MAX_TAGGED_TASKS] = {};
+
+char activityName[32] = "boot";
+uint32_t activityMinFree = UINT32_MAX;
+uint32_t activityMinLargestBlock = UINT32_MAX;
+
+// Callers hold the critical section
+alloctrack::Tag currentTag() {
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  if (task) {
+    for (const auto& entry : taskTags) {
+      if (entry.task == task) return entry.tag;
+    }
+  }
+  return alloctrack::Tag::Other;
+}
+
+// Callers hold the critical section. A task past MAX_TAGGED_TASKS keeps counting as Other.
+void setCurrentTag(const alloctrack::Tag tag) {
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  if (!task) return;
+  TaskTag* freeSlot = nullptr;
+  for (auto& entry : taskTags) {
+    if (entry.task == task) {
+      if (tag == alloctrack::Tag::Other) {
+        entry.task = nullptr;
+      } else {
+        entry.tag = tag;
+      }
+      return;
+    }
+    if (!entry.task && !freeSlot) freeSlot = &entry;
+  }
+  if (freeSlot && tag != alloctrack::Tag::Other) *freeSlot = {task, tag};
+}
+
+void sampleActivityLowWater(const uint32_t freeHeap, const uint32_t largestBlock) {
+  // Unsynchronized on purpose: a lost sample only makes the low-water mark slightly optimistic
+  if (freeHeap < activityMinFree) activityMinFree = freeHeap;
+  if (largestBlock < activityMinLargestBlock) activityMinLargestBlock = largestBlock;
+}
+
+void noteAlloc(const size_t size) {
+  taskENTER_CRITICAL(nullptr);
+  auto& s = tagStats[static_cast<size_t>(currentTag())];
+  s.allocCount++;
+  s.allocBytes += size;
+  s.liveBytes += static_cast<int32_t>(size);
+  if (s.liveBytes > s.peakLiveBytes) s.peakLiveBytes = s.liveBytes;
+  taskEXIT_CRITICAL(nullptr);
+  // The largest free block is only sampled at scope ends and snapshots, it is too slow to query per allocation
+  sampleActivityLowWater(heap_caps_get_free_size(HEAP_CAPS), UINT32_MAX);
+}
+
+void noteFree(const size_t size) {
+  taskENTER_CRITICAL(nullptr);
+  auto& s = tagStats[static_cast<size_t>(currentTag())];
+  s.freeCount++;
+  s.liveBytes -= static_cast<int32_t>(size);
+  taskEXIT_CRITICAL(nullptr);
+}
+}  // namespace
+
+// Linker-wrapped allocator entry points (-Wl,--wrap=...). Sizes are the real block sizes from the heap, so frees
+// balance allocations even when the caller doesn't know the size.
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(const size_t size) {
+  void* ptr = __real_malloc(size);
+  if (ptr) noteAlloc(heap_caps_get_allocated_size(ptr));
+  return ptr;
+}
+
+void __wrap_free(void* ptr) {
+  if (ptr) noteFree(heap_caps_get_allocated_size(ptr));
+  __real_free(ptr);
+}
+
+void* __wrap_calloc(const size_t count, const size_t size) {
+  void* ptr = __real_calloc(count, size);
+  if (ptr) noteAlloc(heap_caps_get_allocated_size(ptr));
+  return ptr;
+}
+
+void* __wrap_realloc(void* ptr, const size_t size) {
+  const size_t oldSize = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+  void* newPtr = __real_realloc(ptr, size);
+  if (newPtr) {
+    if (oldSize) noteFree(oldSize);
+    noteAlloc(heap_caps_get_allocated_size(newPtr));
+  } else if (size == 0 && oldSize) {
+    noteFree(oldSize);
+  }
+  return newPtr;
+}
+}
+
+const char* alloctrack::tagName(const Tag tag) { return TAG_NAMES[static_cast<size_t>(tag)]; }
+
+alloctrack::TagStats alloctrack::stats(const Tag tag) {
+  taskENTER_CRITICAL(nullptr);
+  const TagStats s = tagStats[static_cast<size_t>(tag)];
+  taskEXIT_CRITICAL(nullptr);
+  return s;
+}
+
+void alloctrack::logSnapshot() {
+  const uint32_t freeHeap = heap_caps_get_free_size(HEAP_CAPS);
+  const uint32_t largestBlock = heap_caps_get_largest_free_block(HEAP_CAPS);
+  sampleActivityLowWater(freeHeap, largestBlock);
+
+  LOG_INF("ALC", "Free: %u bytes, largest block: %u bytes (%u%% fragmented)", freeHeap, largestBlock,
+          freeHeap ? 100 - largestBlock * 100 / freeHeap : 0);
+  for (size_t i = 0; i < TAG_COUNT; i++) {
+    const TagStats s = stats(static_cast<Tag>(i));
+    if (s.allocCount == 0 && s.freeCount == 0) continue;
+    LOG_INF("ALC", "%-10s allocs: %u, frees: %u, bytes: %u, live: %d, peak: %d, retained: %d, largest block drop: %u",
+            TAG_NAMES[i], s.allocCount, s.freeCount, s.allocBytes, s.liveBytes, s.peakLiveBytes, s.retainedBytes,
+            s.largestBlockDrop);
+  }
+}
+
+void alloctrack::activityEntered(const char* name) {
+  sampleActivityLowWater(heap_caps_get_free_size(HEAP_CAPS), heap_caps_get_largest_free_block(HEAP_CAPS));
+  LOG_INF("ALC", "Activity %s high-water: min free %u bytes, min largest block %u bytes", activityName,
+          activityMinFree, activityMinLargestBlock);
+
+  strncpy(activityName, name, sizeof(activityName) - 1);
+  activityName[sizeof(activityName) - 1] = '\0';
+  activityMinFree = UINT32_MAX;
+  activityMinLargestBlock = UINT32_MAX;
+}
+
+alloctrack::ScopedTag::ScopedTag(const Tag tag) : tag(tag) {
+  taskENTER_CRITICAL(nullptr);
+  previousTag = currentTag();
+  setCurrentTag(tag);
+  taskEXIT_CRITICAL(nullptr);
+  freeHeapAtStart = heap_caps_get_free_size(HEAP_CAPS);
+  largestBlockAtStart = heap_caps_get_largest_free_block(HEAP_CAPS);
+}
+
+alloctrack::ScopedTag::~ScopedTag() {
+  const uint32_t freeHeap = heap_caps_get_free_size(HEAP_CAPS);
+  const uint32_t largestBlock = heap_caps_get_largest_free_block(HEAP_CAPS);
+  sampleActivityLowWater(freeHeap, largestBlock);
+
+  taskENTER_CRITICAL(nullptr);
+  auto& s = tagStats[static_cast<size_t>(tag)];
+  s.retainedBytes += static_cast<int32_t>(freeHeapAtStart - freeHeap);
+  if (largestBlockAtStart > largestBlock && largestBlockAtStart - largestBlock > s.largestBlockDrop) {
+    s.largestBlockDrop = largestBlockAtStart - largestBlock;
+  }
+  setCurrentTag(previousTag);
+  taskEXIT_CRITICAL(nullptr);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Heap allocation profiler, attributing heap use to subsystem tags.
+
+Define ENABLE_ALLOC_TRACKER and link with
+    -Wl,--wrap=malloc -Wl,--wrap=free -Wl,--wrap=calloc -Wl,--wrap=realloc
+(see [env:heap_profile] in platformio.ini). Without the flag every macro below expands to nothing.
+
+Each task has a current tag, set for a scope with ALLOC_TAG:
+    ALLOC_TAG(Fonts);
+Allocations and frees made by that task while the tag is active are counted against it. On top of that each scope
+measures how much heap it kept (free heap before vs. after) and how far it shrank the largest free block, which is
+what actually fails large allocations once the heap is fragmented. Nested scopes count toward both tags' retained
+bytes.
+
+ALLOC_TRACK_SNAPSHOT() logs one [ALC] line per tag; ALLOC_TRACK_ACTIVITY(name) logs the heap high-water mark of
+the activity being left (lowest free heap and smallest largest free block) and starts tracking the next one.
+*/
+
+namespace alloctrack {
+
+enum class Tag : uint8_t { Other, EpubIndex, Fonts, Images, WebServer, Inflate, _COUNT };
+
+constexpr size_t TAG_COUNT = static_cast<size_t>(Tag::_COUNT);
+
+struct TagStats {
+  uint32_t allocCount;
+  uint32_t freeCount;
+  uint32_t allocBytes;        // total bytes handed out
+  int32_t liveBytes;          // allocated minus freed while the tag was active
+  int32_t peakLiveBytes;
+  int32_t retainedBytes;      // heap still held when the tag's scopes ended
+  uint32_t largestBlockDrop;  // worst shrink of the largest free block over one scope
+};
+
+const char* tagName(Tag tag);
+
+// Copies the counters of one tag
+TagStats stats(Tag tag);
+
+void logSnapshot();
+
+// Logs the high-water mark of the previous activity and starts one for the given activity
+void activityEntered(const char* name);
+
+class ScopedTag {
+ public:
+  explicit ScopedTag(Tag tag);
+  ~ScopedTag();
+
+  ScopedTag(const ScopedTag&) = delete;
+  ScopedTag& operator=(const ScopedTag&) = delete;
+
+ private:
+  Tag tag;
+  Tag previousTag;
+  uint32_t freeHeapAtStart;
+  uint32_t largestBlockAtStart;
+};
+
+}  // namespace alloctrack
+
+#ifdef ENABLE_ALLOC_TRACKER
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_TAG(tag) const alloctrack::ScopedTag ALLOC_CONCAT(allocTag, __LINE__)(alloctrack::Tag::tag)
+#define ALLOC_TRACK_SNAPSHOT() alloctrack::logSnapshot()
+#define ALLOC_TRACK_ACTIVITY(name) alloctrack::activityEntered(name)
+#else
+#define ALLOC_TAG(tag)
+#define ALLOC_TRACK_SNAPSHOT()
+#define ALLOC_TRACK_ACTIVITY(name)
+#endif
@@ -0,0 +1,53 @@
+#include "Trace.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "Logging.h"
+
+#ifdef ENABLE_TRACE
+namespace {
+trace::Span ring[trace::RING_SIZE];
+size_t spanCount = 0;  // total spans recorded; the ring keeps the last RING_SIZE
+}  // namespace
+
+void trace::record(const char* name, const uint32_t startUs, const uint32_t durationUs) {
+  // Spans come from the main, render and display refresh tasks
+  taskENTER_CRITICAL(nullptr);
+  ring[spanCount % RING_SIZE] = {name, startUs, durationUs};
+  spanCount++;
+  taskEXIT_CRITICAL(nullptr);
+}
+
+size_t trace::snapshot(Span* out, const size_t maxSpans) {
+  taskENTER_CRITICAL(nullptr);
+  const size_t available = spanCount < RING_SIZE ? spanCount : RING_SIZE;
+  const size_t count = available < maxSpans ? available : maxSpans;
+  const size_t first = spanCount - count;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = ring[(first + i) % RING_SIZE];
+  }
+  taskEXIT_CRITICAL(nullptr);
+  return count;
+}
+#else
+// Trace points are compiled out: no ring, and the serial and web exports report no spans
+void trace::record(const char*, uint32_t, uint32_t) {}
+
+size_t trace::snapshot(Span*, size_t) { return 0; }
+#endif
+
+void trace::dumpToSerial() {
+  auto* spans = static_cast<Span*>(malloc(sizeof(Span) * RING_SIZE));
+  if (!spans) {
+    LOG_ERR("TRC", "Failed to allocate trace snapshot");
+    return;
+  }
+  const size_t count = snapshot(spans, RING_SIZE);
+  logSerial.printf("TRACE_START:%u\n", static_cast<unsigned>(count));
+  for (size_t i = 0; i < count; i++) {
+    logSerial.printf("%s,%u,%u\n", spans[i].name, spans[i].startUs, spans[i].durationUs);
+  }
+  logSerial.printf("TRACE_END\n");
+  free(spans);
+}
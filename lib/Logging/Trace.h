@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Lightweight timing spans for hot paths (page load, render passes, display refresh, SD reads, inflate).
+
+Define ENABLE_TRACE to compile the trace points in; without it TRACE_SPAN expands to nothing and no ring is kept.
+A span records name, start and duration (microseconds) into a fixed RAM ring when its scope ends:
+    TRACE_SPAN("page.load");
+    TRACE_SPAN_MIN("sd.read", 1000);  // only kept when it took at least 1000us, so tiny calls don't flood the ring
+
+The ring is dumped with the CMD:TRACE serial command (see scripts/debugging_monitor.py) and GET /api/trace.
+Names must be string literals, only the pointer is stored.
+*/
+
+namespace trace {
+
+struct Span {
+  const char* name;
+  uint32_t startUs;
+  uint32_t durationUs;
+};
+
+constexpr size_t RING_SIZE = 128;
+
+void record(const char* name, uint32_t startUs, uint32_t durationUs);
+
+// Copies the recorded spans, oldest first, and returns how many were copied
+size_t snapshot(Span* out, size_t maxSpans);
+
+// Writes the ring to logSerial between TRACE_START:<count> and TRACE_END, one "name,startUs,durationUs" per line
+void dumpToSerial();
+
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const char* name, const uint32_t minDurationUs = 0)
+      : name(name), minDurationUs(minDurationUs), startUs(micros()) {}
+  ~ScopedSpan() {
+    const uint32_t durationUs = micros() - startUs;
+    if (durationUs >= minDurationUs) record(name, startUs, durationUs);
+  }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  const char* name;
+  uint32_t minDurationUs;
+  uint32_t startUs;
+};
+
+}  // namespace trace
+
+#ifdef ENABLE_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) const trace::ScopedSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SPAN_MIN(name, minDurationUs) \
+  const trace::ScopedSpan TRACE_CONCAT(traceSpan, __LINE__)(name, minDurationUs)
+#else
+#define TRACE_SPAN(name)
+#define TRACE_SPAN_MIN(name, minDurationUs)
+#endif
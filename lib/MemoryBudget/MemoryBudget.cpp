@@ -0,0 +1,101 @@
+#include "MemoryBudget.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+
+#include <cstdlib>
+
+MemoryBudget MemoryBudget::instance;
+
+namespace {
+// Recursive so an evict callback that tears its cache down may unregister it
+class BudgetLock {
+ public:
+  explicit BudgetLock(SemaphoreHandle_t mutex) : mutex(mutex) { xSemaphoreTakeRecursive(mutex, portMAX_DELAY); }
+  ~BudgetLock() { xSemaphoreGiveRecursive(mutex); }
+
+  BudgetLock(const BudgetLock&) = delete;
+  BudgetLock& operator=(const BudgetLock&) = delete;
+
+ private:
+  SemaphoreHandle_t mutex;
+};
+}  // namespace
+
+MemoryBudget::MemoryBudget() { mutex = xSemaphoreCreateRecursiveMutex(); }
+
+int MemoryBudget::registerCache(const char* name, const Priority priority, std::function<void()> evict) {
+  BudgetLock lock(mutex);
+  for (size_t i = 0; i < MAX_CACHES; i++) {
+    if (!caches[i].name) {
+      caches[i] = {name, priority, std::move(evict)};
+      return static_cast<int>(i);
+    }
+  }
+  LOG_ERR("MEM", "Cache registry full, %s won't be evictable", name);
+  return -1;
+}
+
+void MemoryBudget::unregisterCache(const int handle) {
+  if (handle < 0 || handle >= static_cast<int>(MAX_CACHES)) return;
+  BudgetLock lock(mutex);
+  caches[handle] = {};
+}
+
+bool MemoryBudget::evictOne(const char* owner, const Priority below, bool (&evicted)[MAX_CACHES]) {
+  if (ownerLockHeld && !ownerLockHeld()) {
+    // The caches' owners may be using them right now
+    LOG_DBG("MEM", "%s: not holding the cache owners' lock, nothing evicted", owner);
+    return false;
+  }
+
+  int victim = -1;
+  for (size_t i = 0; i < MAX_CACHES; i++) {
+    if (caches[i].name && !evicted[i] && caches[i].priority < below &&
+        (victim < 0 || caches[i].priority < caches[victim].priority)) {
+      victim = static_cast<int>(i);
+    }
+  }
+  if (victim < 0) return false;
+
+  evicted[victim] = true;
+  const char* name = caches[victim].name;
+  const auto evict = caches[victim].evict;  // copy: the callback may unregister its cache
+  const uint32_t freeBefore = ESP.getFreeHeap();
+  evict();
+  LOG_INF("MEM", "Evicted %s for %s (%d bytes released)", name, owner,
+          static_cast<int>(ESP.getFreeHeap() - freeBefore));
+  return true;
+}
+
+void* MemoryBudget::allocate(const char* owner, const size_t size, const Priority priority) {
+  void* ptr = malloc(size);
+  if (ptr) return ptr;
+
+  BudgetLock lock(mutex);
+  bool evicted[MAX_CACHES] = {};
+  while (evictOne(owner, priority, evicted)) {
+    ptr = malloc(size);
+    if (ptr) return ptr;
+  }
+  LOG_ERR("MEM", "%s: no room for %u bytes (free %u, max alloc %u)", owner, static_cast<unsigned>(size),
+          ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+  return nullptr;
+}
+
+bool MemoryBudget::makeRoom(const char* owner, const size_t freeBytes, const size_t largestBlock,
+                            const Priority priority) {
+  const auto fits = [freeBytes, largestBlock] {
+    return ESP.getFreeHeap() >= freeBytes && ESP.getMaxAllocHeap() >= largestBlock;
+  };
+  if (fits()) return true;
+
+  BudgetLock lock(mutex);
+  bool evicted[MAX_CACHES] = {};
+  while (evictOne(owner, priority, evicted)) {
+    if (fits()) return true;
+  }
+  LOG_ERR("MEM", "%s: can't make room for %u bytes (free %u, max alloc %u)", owner, static_cast<unsigned>(freeBytes),
+          ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+  return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/*
+Arbitrates large buffers between subsystems.
+
+Caches that can be rebuilt (home cover buffer, prefetched reader page, font groups, BW snapshot buffer) register an
+evict callback with a priority. Large buffers are requested with allocate(), and decoders that allocate internally
+reserve their working set with makeRoom(). When the heap can't satisfy a request, registered caches of lower
+priority than the request are emptied, lowest priority first, until it can. Caches stay registered and refill on
+their next use. A request never evicts caches of its own priority, so a cache refilling itself can't evict its peers.
+
+Evict callbacks run on the requesting task, must free their memory before returning and must not request memory.
+The caches are used under their owners' lock (the render lock), so eviction only happens on a task already holding
+that lock, as reported by the check given to setOwnerLockCheck(). A request from any other task can't evict and fails
+if the heap can't satisfy it. The lock isn't recursive, so it is never taken here.
+*/
+class MemoryBudget {
+ public:
+  enum class Priority : uint8_t {
+    Low,     // caches that are cheap to rebuild
+    Medium,  // caches that cost a decode to rebuild, optional working buffers
+    High,    // buffers the current operation fails without
+  };
+
+  MemoryBudget();
+
+  // Returns a handle for unregisterCache(), or -1 when the registry is full
+  int registerCache(const char* name, Priority priority, std::function<void()> evict);
+  void unregisterCache(int handle);
+
+  // malloc() that evicts lower-priority caches when the heap has no block of this size. nullptr if still failing.
+  // Free with free().
+  void* allocate(const char* owner, size_t size, Priority priority);
+
+  // Evicts lower-priority caches until at least freeBytes are free and largestBlock can be allocated in one piece
+  bool makeRoom(const char* owner, size_t freeBytes, size_t largestBlock, Priority priority);
+
+  // Whether the calling task holds the lock the registered caches are used under. Until set, any task may evict.
+  void setOwnerLockCheck(bool (*holdsOwnerLock)()) { ownerLockHeld = holdsOwnerLock; }
+
+  static MemoryBudget& getInstance() { return instance; }
+
+ private:
+  static constexpr size_t MAX_CACHES = 8;
+
+  struct Cache {
+    const char* name = nullptr;
+    Priority priority = Priority::Low;
+    std::function<void()> evict;
+  };
+
+  static MemoryBudget instance;
+
+  Cache caches[MAX_CACHES];
+  SemaphoreHandle_t mutex = nullptr;
+  bool (*ownerLockHeld)() = nullptr;
+
+  // Evicts the lowest-priority cache below the given priority not evicted yet for this request; false when none is
+  // left
+  bool evictOne(const char* owner, Priority below, bool (&evicted)[MAX_CACHES]);
+};
+
+#define MemBudget MemoryBudget::getInstance()
@@ -0,0 +1,513 @@
+#include "PngScanlineDecoder.h"
+
+#include <ImageByteSource.h>
+#include <InflateReader.h>
+#include <Logging.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// PNG constants
+uint8_t PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+// PNG color types
+enum PngColorType : uint8_t {
+  PNG_COLOR_GRAYSCALE = 0,
+  PNG_COLOR_RGB = 2,
+  PNG_COLOR_PALETTE = 3,
+  PNG_COLOR_GRAYSCALE_ALPHA = 4,
+  PNG_COLOR_RGBA = 6,
+};
+
+// PNG filter types
+enum PngFilter : uint8_t {
+  PNG_FILTER_NONE = 0,
+  PNG_FILTER_SUB = 1,
+  PNG_FILTER_UP = 2,
+  PNG_FILTER_AVERAGE = 3,
+  PNG_FILTER_PAETH = 4,
+};
+
+// Read a big-endian 32-bit value from the source
+bool readBE32(ImageByteSource& file, uint32_t& value) {
+  uint8_t buf[4];
+  if (file.read(buf, 4) != 4) return false;
+  value = (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
+          (static_cast<uint32_t>(buf[2]) << 8) | buf[3];
+  return true;
+}
+
+// Paeth predictor function per PNG spec
+inline uint8_t paethPredictor(uint8_t a, uint8_t b, uint8_t c) {
+  int p = static_cast<int>(a) + b - c;
+  int pa = p > a ? p - a : a - p;
+  int pb = p > b ? p - b : b - p;
+  int pc = p > c ? p - c : c - p;
+  if (pa <= pb && pa <= pc) return a;
+  if (pb <= pc) return b;
+  return c;
+}
+
+inline uint8_t rgbToGray(const uint8_t r, const uint8_t g, const uint8_t b) {
+  return static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8);
+}
+
+// Composite onto a white background
+inline uint8_t blendWhite(const uint8_t gray, const uint8_t alpha) {
+  return static_cast<uint8_t>((gray * alpha + 255 * (255 - alpha)) / 255);
+}
+
+// Bit depths the PNG spec allows for each color type (IHDR table); anything else is a corrupt header
+bool isValidBitDepth(const uint8_t colorType, const uint8_t bitDepth) {
+  switch (colorType) {
+    case PNG_COLOR_GRAYSCALE:
+      return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+    case PNG_COLOR_PALETTE:
+      return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+    case PNG_COLOR_RGB:
+    case PNG_COLOR_GRAYSCALE_ALPHA:
+    case PNG_COLOR_RGBA:
+      return bitDepth == 8 || bitDepth == 16;
+    default:
+      return false;
+  }
+}
+
+struct PngHeader {
+  uint32_t width;
+  uint32_t height;
+  uint8_t bitDepth;
+  uint8_t colorType;
+  uint8_t interlace;
+};
+
+// Signature + IHDR (including its CRC)
+bool readHeader(ImageByteSource& source, PngHeader& header) {
+  uint8_t sig[8];
+  if (source.read(sig, 8) != 8 || memcmp(sig, PNG_SIGNATURE, 8) != 0) {
+    LOG_ERR("PNG", "Invalid PNG signature");
+    return false;
+  }
+
+  uint32_t ihdrLen;
+  if (!readBE32(source, ihdrLen)) return false;
+
+  uint8_t ihdrType[4];
+  if (source.read(ihdrType, 4) != 4 || memcmp(ihdrType, "IHDR", 4) != 0) {
+    LOG_ERR("PNG", "Missing IHDR chunk");
+    return false;
+  }
+
+  if (!readBE32(source, header.width) || !readBE32(source, header.height)) return false;
+
+  uint8_t ihdrRest[5];
+  if (source.read(ihdrRest, 5) != 5) return false;
+  header.bitDepth = ihdrRest[0];
+  header.colorType = ihdrRest[1];
+  header.interlace = ihdrRest[4];
+
+  if (ihdrRest[2] != 0 || ihdrRest[3] != 0) {
+    LOG_ERR("PNG", "Unsupported compression/filter method");
+    return false;
+  }
+
+  // Skip IHDR CRC
+  return source.skip(4);
+}
+}  // namespace
+
+// Context for streaming PNG decompression
+// IMPORTANT: reader must be the first field - the uzlib callback casts uzlib_uncomp* to PngDecodeContext*
+struct PngDecodeContext {
+  InflateReader reader;  // Must be first — callback casts uzlib_uncomp* to PngDecodeContext*
+  ImageByteSource* file;
+
+  // PNG image properties
+  uint32_t width;
+  uint32_t height;
+  uint8_t bitDepth;
+  uint8_t colorType;
+  uint8_t bytesPerPixel;  // after expanding sub-byte depths
+  uint32_t rawRowBytes;   // bytes per raw row (without filter byte)
+
+  // Scanline buffers
+  uint8_t* currentRow;   // current defiltered scanline
+  uint8_t* previousRow;  // previous defiltered scanline
+
+  // Chunk reading state
+  uint32_t chunkBytesRemaining;  // bytes left in current IDAT chunk
+  bool idatFinished;             // no more IDAT chunks
+
+  // File read buffer for feeding uzlib
+  uint8_t readBuf[2048];
+
+  // Palette for indexed color (type 3), with per-entry alpha from tRNS
+  uint8_t palette[256 * 3];
+  uint8_t paletteAlpha[256];
+  int paletteSize;
+  bool hasPaletteAlpha;
+};
+
+// Read the next IDAT chunk header, skipping non-IDAT chunks
+// Returns true if an IDAT chunk was found
+static bool findNextIdatChunk(PngDecodeContext& ctx) {
+  while (true) {
+    uint32_t chunkLen;
+    if (!readBE32(*ctx.file, chunkLen)) return false;
+
+    uint8_t chunkType[4];
+    if (ctx.file->read(chunkType, 4) != 4) return false;
+
+    if (memcmp(chunkType, "IDAT", 4) == 0) {
+      ctx.chunkBytesRemaining = chunkLen;
+      return true;
+    }
+
+    // Skip this chunk's data + 4-byte CRC
+    if (!ctx.file->skip(chunkLen + 4)) return false;
+
+    // If we hit IEND, there are no more chunks
+    if (memcmp(chunkType, "IEND", 4) == 0) {
+      return false;
+    }
+  }
+}
+
+// uzlib callback: reads the next batch of IDAT data from the source
+static int pngIdatReadCallback(uzlib_uncomp* uncomp) {
+  auto* ctx = reinterpret_cast<PngDecodeContext*>(uncomp);
+
+  if (ctx->idatFinished) return -1;
+
+  // Skip 4-byte CRC and find next IDAT chunk when current chunk is exhausted
+  while (ctx->chunkBytesRemaining == 0) {
+    if (!ctx->file->skip(4)) {  // skip 4-byte CRC of previous IDAT
+      ctx->idatFinished = true;
+      return -1;
+    }
+    if (!findNextIdatChunk(*ctx)) {
+      ctx->idatFinished = true;
+      return -1;
+    }
+  }
+
+  // Read from current IDAT chunk into the read buffer
+  size_t toRead = sizeof(ctx->readBuf);
+  if (toRead > ctx->chunkBytesRemaining) toRead = ctx->chunkBytesRemaining;
+
+  const size_t bytesRead = ctx->file->read(ctx->readBuf, toRead);
+  if (bytesRead == 0) {
+    ctx->idatFinished = true;
+    return -1;
+  }
+
+  ctx->chunkBytesRemaining -= bytesRead;
+
+  // Give uzlib the buffer (skip first byte since we return it directly)
+  uncomp->source = ctx->readBuf + 1;
+  uncomp->source_limit = ctx->readBuf + bytesRead;
+  return ctx->readBuf[0];
+}
+
+PngScanlineDecoder::~PngScanlineDecoder() {
+  if (ctx) {
+    free(ctx->currentRow);
+    free(ctx->previousRow);
+    delete ctx;  // reader destructor frees the ring buffer
+  }
+}
+
+bool PngScanlineDecoder::readDimensions(ImageByteSource& source, uint32_t* width, uint32_t* height) {
+  PngHeader header;
+  if (!readHeader(source, header)) {
+    return false;
+  }
+  *width = header.width;
+  *height = header.height;
+  return true;
+}
+
+uint32_t PngScanlineDecoder::getWidth() const { return ctx ? ctx->width : 0; }
+uint32_t PngScanlineDecoder::getHeight() const { return ctx ? ctx->height : 0; }
+
+bool PngScanlineDecoder::begin(ImageByteSource& source) {
+  PngHeader header;
+  if (!readHeader(source, header)) {
+    return false;
+  }
+
+  LOG_DBG("PNG", "Image: %ux%u, depth=%u, color=%u, interlace=%u", header.width, header.height, header.bitDepth,
+          header.colorType, header.interlace);
+
+  if (header.interlace != 0) {
+    LOG_ERR("PNG", "Interlaced PNGs not supported");
+    return false;
+  }
+
+  if (header.width == 0 || header.height == 0) {
+    LOG_ERR("PNG", "Image has zero size");
+    return false;
+  }
+
+  // Sub-byte unpacking divides by the depth, so only the depths of the spec get past here
+  if (!isValidBitDepth(header.colorType, header.bitDepth)) {
+    LOG_ERR("PNG", "Unsupported bit depth %u for color type %u", header.bitDepth, header.colorType);
+    return false;
+  }
+
+  // Calculate bytes per pixel and raw row bytes (64-bit: the width is not otherwise bounded)
+  uint8_t bytesPerPixel;
+  uint64_t rawRowBytes;
+
+  switch (header.colorType) {
+    case PNG_COLOR_GRAYSCALE:
+      if (header.bitDepth == 16) {
+        bytesPerPixel = 2;
+        rawRowBytes = static_cast<uint64_t>(header.width) * 2;
+      } else if (header.bitDepth == 8) {
+        bytesPerPixel = 1;
+        rawRowBytes = header.width;
+      } else {
+        // Sub-byte: 1, 2, or 4 bits
+        bytesPerPixel = 1;
+        rawRowBytes = (static_cast<uint64_t>(header.width) * header.bitDepth + 7) / 8;
+      }
+      break;
+    case PNG_COLOR_RGB:
+      bytesPerPixel = (header.bitDepth == 16) ? 6 : 3;
+      rawRowBytes = static_cast<uint64_t>(header.width) * bytesPerPixel;
+      break;
+    case PNG_COLOR_PALETTE:
+      bytesPerPixel = 1;
+      rawRowBytes = (static_cast<uint64_t>(header.width) * header.bitDepth + 7) / 8;
+      break;
+    case PNG_COLOR_GRAYSCALE_ALPHA:
+      bytesPerPixel = (header.bitDepth == 16) ? 4 : 2;
+      rawRowBytes = static_cast<uint64_t>(header.width) * bytesPerPixel;
+      break;
+    case PNG_COLOR_RGBA:
+      bytesPerPixel = (header.bitDepth == 16) ? 8 : 4;
+      rawRowBytes = static_cast<uint64_t>(header.width) * bytesPerPixel;
+      break;
+    default:
+      LOG_ERR("PNG", "Unsupported color type: %d", header.colorType);
+      return false;
+  }
+
+  // Two raw rows are held while decoding; their size is only bounded by what the heap can allocate below
+  if (rawRowBytes > UINT32_MAX) {
+    LOG_ERR("PNG", "Row too large: %llu bytes", static_cast<unsigned long long>(rawRowBytes));
+    return false;
+  }
+
+  ctx = new PngDecodeContext();
+  ctx->file = &source;
+  ctx->width = header.width;
+  ctx->height = header.height;
+  ctx->bitDepth = header.bitDepth;
+  ctx->colorType = header.colorType;
+  ctx->bytesPerPixel = bytesPerPixel;
+  ctx->rawRowBytes = static_cast<uint32_t>(rawRowBytes);
+  memset(ctx->paletteAlpha, 0xFF, sizeof(ctx->paletteAlpha));
+
+  // Allocate scanline buffers (zeroed: the first row is defiltered against an all-zero previous row)
+  ctx->currentRow = static_cast<uint8_t*>(calloc(ctx->rawRowBytes, 1));
+  ctx->previousRow = static_cast<uint8_t*>(calloc(ctx->rawRowBytes, 1));
+  if (!ctx->currentRow || !ctx->previousRow) {
+    LOG_ERR("PNG", "Failed to allocate scanline buffers (%u bytes each)", ctx->rawRowBytes);
+    return false;
+  }
+
+  // Scan for PLTE/tRNS chunks and the first IDAT chunk
+  bool foundIdat = false;
+  while (!foundIdat) {
+    uint32_t chunkLen;
+    if (!readBE32(source, chunkLen)) break;
+
+    uint8_t chunkType[4];
+    if (source.read(chunkType, 4) != 4) break;
+
+    if (memcmp(chunkType, "PLTE", 4) == 0) {
+      int entries = chunkLen / 3;
+      if (entries > 256) entries = 256;
+      ctx->paletteSize = entries;
+      size_t palBytes = entries * 3;
+      source.read(ctx->palette, palBytes);
+      // Skip any remaining palette data
+      if (chunkLen > palBytes) source.skip(chunkLen - palBytes);
+      source.skip(4);  // CRC
+    } else if (memcmp(chunkType, "tRNS", 4) == 0 && header.colorType == PNG_COLOR_PALETTE) {
+      const size_t alphaBytes = chunkLen < 256 ? chunkLen : 256;
+      source.read(ctx->paletteAlpha, alphaBytes);
+      if (chunkLen > alphaBytes) source.skip(chunkLen - alphaBytes);
+      source.skip(4);  // CRC
+      ctx->hasPaletteAlpha = true;
+    } else if (memcmp(chunkType, "IDAT", 4) == 0) {
+      ctx->chunkBytesRemaining = chunkLen;
+      foundIdat = true;
+    } else if (memcmp(chunkType, "IEND", 4) == 0) {
+      break;
+    } else {
+      // Skip unknown chunk
+      source.skip(chunkLen + 4);
+    }
+  }
+
+  if (!foundIdat) {
+    LOG_ERR("PNG", "No IDAT chunk found");
+    return false;
+  }
+
+  // Initialize streaming decompressor with 32KB ring buffer for back-reference history
+  if (!ctx->reader.init(true)) {
+    LOG_ERR("PNG", "Failed to init inflate reader");
+    return false;
+  }
+  ctx->reader.setReadCallback(pngIdatReadCallback);
+  // PNG IDAT data is zlib-wrapped: consume the 2-byte zlib header (CMF + FLG)
+  ctx->reader.skipZlibHeader();
+  return true;
+}
+
+// Decode one scanline: decompress filter byte + raw bytes, then unfilter
+bool PngScanlineDecoder::nextRow() {
+  if (!ctx) return false;
+
+  // The previous row becomes the reference for the Up/Average/Paeth filters
+  uint8_t* temp = ctx->previousRow;
+  ctx->previousRow = ctx->currentRow;
+  ctx->currentRow = temp;
+
+  // Decompress filter byte
+  uint8_t filterType;
+  if (!ctx->reader.read(&filterType, 1)) return false;
+
+  // Decompress raw row data into currentRow
+  uint8_t* row = ctx->currentRow;
+  const uint8_t* prev = ctx->previousRow;
+  const uint32_t rawRowBytes = ctx->rawRowBytes;
+  if (!ctx->reader.read(row, rawRowBytes)) return false;
+
+  // Apply reverse filter
+  const uint32_t bpp = ctx->bytesPerPixel;
+
+  switch (filterType) {
+    case PNG_FILTER_NONE:
+      break;
+
+    case PNG_FILTER_SUB:
+      for (uint32_t i = bpp; i < rawRowBytes; i++) {
+        row[i] += row[i - bpp];
+      }
+      break;
+
+    case PNG_FILTER_UP:
+      for (uint32_t i = 0; i < rawRowBytes; i++) {
+        row[i] += prev[i];
+      }
+      break;
+
+    case PNG_FILTER_AVERAGE:
+      for (uint32_t i = 0; i < rawRowBytes; i++) {
+        uint8_t a = (i >= bpp) ? row[i - bpp] : 0;
+        uint8_t b = prev[i];
+        row[i] += (a + b) / 2;
+      }
+      break;
+
+    case PNG_FILTER_PAETH:
+      for (uint32_t i = 0; i < rawRowBytes; i++) {
+        uint8_t a = (i >= bpp) ? row[i - bpp] : 0;
+        uint8_t b = prev[i];
+        uint8_t c = (i >= bpp) ? prev[i - bpp] : 0;
+        row[i] += paethPredictor(a, b, c);
+      }
+      break;
+
+    default:
+      LOG_ERR("PNG", "Unknown filter type: %d", filterType);
+      return false;
+  }
+
+  return true;
+}
+
+// Branches once on colorType/bitDepth, then runs a tight loop over the segment
+void PngScanlineDecoder::toGray(const uint32_t startX, const uint32_t count, uint8_t* gray) const {
+  const uint8_t* src = ctx->currentRow;
+  const uint32_t end = startX + count;
+
+  switch (ctx->colorType) {
+    case PNG_COLOR_GRAYSCALE:
+      if (ctx->bitDepth == 8) {
+        memcpy(gray, src + startX, count);
+      } else if (ctx->bitDepth == 16) {
+        for (uint32_t x = startX; x < end; x++) *gray++ = src[x * 2];
+      } else {
+        const int ppb = 8 / ctx->bitDepth;
+        const uint8_t mask = (1 << ctx->bitDepth) - 1;
+        for (uint32_t x = startX; x < end; x++) {
+          int shift = (ppb - 1 - (x % ppb)) * ctx->bitDepth;
+          *gray++ = (src[x / ppb] >> shift & mask) * 255 / mask;
+        }
+      }
+      break;
+
+    case PNG_COLOR_RGB:
+      if (ctx->bitDepth == 8) {
+        // Fast path: most common EPUB cover format
+        for (uint32_t x = startX; x < end; x++) {
+          const uint8_t* p = src + x * 3;
+          *gray++ = rgbToGray(p[0], p[1], p[2]);
+        }
+      } else {
+        for (uint32_t x = startX; x < end; x++) {
+          const uint8_t* p = src + x * 6;
+          *gray++ = rgbToGray(p[0], p[2], p[4]);
+        }
+      }
+      break;
+
+    case PNG_COLOR_PALETTE: {
+      const int ppb = 8 / ctx->bitDepth;
+      const uint8_t mask = (1 << ctx->bitDepth) - 1;
+      const uint8_t* pal = ctx->palette;
+      const int palSize = ctx->paletteSize;
+      for (uint32_t x = startX; x < end; x++) {
+        int shift = (ppb - 1 - (x % ppb)) * ctx->bitDepth;
+        uint8_t idx = (src[x / ppb] >> shift) & mask;
+        if (idx >= palSize) idx = 0;
+        const uint8_t value = rgbToGray(pal[idx * 3], pal[idx * 3 + 1], pal[idx * 3 + 2]);
+        *gray++ = ctx->hasPaletteAlpha ? blendWhite(value, ctx->paletteAlpha[idx]) : value;
+      }
+      break;
+    }
+
+    case PNG_COLOR_GRAYSCALE_ALPHA:
+      if (ctx->bitDepth == 8) {
+        for (uint32_t x = startX; x < end; x++) *gray++ = blendWhite(src[x * 2], src[x * 2 + 1]);
+      } else {
+        for (uint32_t x = startX; x < end; x++) *gray++ = blendWhite(src[x * 4], src[x * 4 + 2]);
+      }
+      break;
+
+    case PNG_COLOR_RGBA:
+      if (ctx->bitDepth == 8) {
+        for (uint32_t x = startX; x < end; x++) {
+          const uint8_t* p = src + x * 4;
+          *gray++ = blendWhite(rgbToGray(p[0], p[1], p[2]), p[3]);
+        }
+      } else {
+        for (uint32_t x = startX; x < end; x++) {
+          const uint8_t* p = src + x * 8;
+          *gray++ = blendWhite(rgbToGray(p[0], p[2], p[4]), p[6]);
+        }
+      }
+      break;
+
+    default:
+      memset(gray, 128, count);
+      break;
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class ImageByteSource;
+struct PngDecodeContext;
+
+// Streaming, non-interlaced PNG decoder that produces one defiltered scanline at a time.
+// Apart from the 32KB inflate window, the only buffers are the current and previous raw scanlines (needed by the
+// Up/Average/Paeth filters); callers convert the row to gray in segments, so no gray buffer at source width exists.
+class PngScanlineDecoder {
+ public:
+  PngScanlineDecoder() = default;
+  ~PngScanlineDecoder();
+
+  PngScanlineDecoder(const PngScanlineDecoder&) = delete;
+  PngScanlineDecoder& operator=(const PngScanlineDecoder&) = delete;
+
+  // Reads only the signature and IHDR chunk
+  static bool readDimensions(ImageByteSource& source, uint32_t* width, uint32_t* height);
+
+  // Parses the header chunks up to the first IDAT and prepares inflation
+  bool begin(ImageByteSource& source);
+  uint32_t getWidth() const;
+  uint32_t getHeight() const;
+
+  // Decodes and defilters the next scanline. Returns false on error.
+  bool nextRow();
+  // Converts count pixels of the current scanline, starting at column startX, to 8-bit gray.
+  // Alpha (including palette tRNS) is blended onto white.
+  void toGray(uint32_t startX, uint32_t count, uint8_t* gray) const;
+
+ private:
+  PngDecodeContext* ctx = nullptr;
+};
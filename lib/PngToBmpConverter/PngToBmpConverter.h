@@ -2,14 +2,17 @@
 
 #include <HalStorage.h>
 
+#include <cstddef>
+
 class Print;
+class ImageByteSource;
+struct ScaledBmpTarget;
 
 class PngToBmpConverter {
-  static bool pngFileToBmpStreamInternal(FsFile& pngFile, Print& bmpOut, int targetWidth, int targetHeight, bool oneBit,
-                                         bool crop = true);
-
  public:
   static bool pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, bool crop = true);
   static bool pngFileToBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   static bool pngFileTo1BitBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Decode once and write every target (e.g. cover, cropped cover and thumbnails) in the same pass
+  static bool pngToBmpStreams(ImageByteSource& source, const ScaledBmpTarget* targets, size_t targetCount);
 };
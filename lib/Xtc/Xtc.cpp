@@ -112,66 +112,10 @@ const std::vector<xtc::ChapterInfo>& Xtc::getChapters() const {
 
 std::string Xtc::getCoverBmpPath() const { return cachePath + "/cover.bmp"; }
 
-bool Xtc::generateCoverBmp() const {
-  // Already generated
-  if (Storage.exists(getCoverBmpPath().c_str())) {
-    return true;
-  }
-
-  if (!loaded || !parser) {
-    LOG_ERR("XTC", "Cannot generate cover BMP, file not loaded");
-    return false;
-  }
-
-  if (parser->getPageCount() == 0) {
-    LOG_ERR("XTC", "No pages in XTC file");
-    return false;
-  }
-
-  // Setup cache directory
-  setupCacheDir();
-
-  // Get first page info for cover
-  xtc::PageInfo pageInfo;
-  if (!parser->getPageInfo(0, pageInfo)) {
-    LOG_DBG("XTC", "Failed to get first page info");
-    return false;
-  }
-
-  // Get bit depth
-  const uint8_t bitDepth = parser->getBitDepth();
-
-  // Allocate buffer for page data
-  // XTG (1-bit): Row-major, ((width+7)/8) * height bytes
-  // XTH (2-bit): Two bit planes, column-major, ((width * height + 7) / 8) * 2 bytes
-  size_t bitmapSize;
-  if (bitDepth == 2) {
-    bitmapSize = ((static_cast<size_t>(pageInfo.width) * pageInfo.height + 7) / 8) * 2;
-  } else {
-    bitmapSize = ((pageInfo.width + 7) / 8) * pageInfo.height;
-  }
-  uint8_t* pageBuffer = static_cast<uint8_t*>(malloc(bitmapSize));
-  if (!pageBuffer) {
-    LOG_ERR("XTC", "Failed to allocate page buffer (%lu bytes)", bitmapSize);
-    return false;
-  }
-
-  // Load first page (cover)
-  size_t bytesRead = const_cast<xtc::XtcParser*>(parser.get())->loadPage(0, pageBuffer, bitmapSize);
-  if (bytesRead == 0) {
-    LOG_ERR("XTC", "Failed to load cover page");
-    free(pageBuffer);
-    return false;
-  }
-
-  // Create BMP file
-  FsFile coverBmp;
-  if (!Storage.openFileForWrite("XTC", getCoverBmpPath(), coverBmp)) {
-    LOG_DBG("XTC", "Failed to create cover BMP file");
-    free(pageBuffer);
-    return false;
-  }
-
+namespace {
+// Writes the page as a full-size 1-bit BMP (XTH grays are thresholded to black)
+bool writeCoverBmp(FsFile& coverBmp, const uint8_t* pageBuffer, const xtc::PageInfo& pageInfo,
+                   const uint8_t bitDepth) {
   // Write BMP header
   // BMP file header (14 bytes)
   const uint32_t rowSize = ((pageInfo.width + 31) / 32) * 4;  // Row size aligned to 4 bytes
@@ -237,8 +181,7 @@ bool Xtc::generateCoverBmp() const {
     // Allocate a row buffer for 1-bit output
     uint8_t* rowBuffer = static_cast<uint8_t*>(malloc(dstRowSize));
     if (!rowBuffer) {
-      free(pageBuffer);
-      coverBmp.close();
+      LOG_ERR("XTC", "Failed to allocate cover row buffer");
       return false;
     }
 
@@ -294,111 +237,14 @@ bool Xtc::generateCoverBmp() const {
     }
   }
 
-  coverBmp.close();
-  free(pageBuffer);
-
-  LOG_DBG("XTC", "Generated cover BMP: %s", getCoverBmpPath().c_str());
   return true;
 }
 
-std::string Xtc::getThumbBmpPath() const { return cachePath + "/thumb_[HEIGHT].bmp"; }
-std::string Xtc::getThumbBmpPath(int height) const { return cachePath + "/thumb_" + std::to_string(height) + ".bmp"; }
-
-bool Xtc::generateThumbBmp(int height) const {
-  // Already generated
-  if (Storage.exists(getThumbBmpPath(height).c_str())) {
-    return true;
-  }
-
-  if (!loaded || !parser) {
-    LOG_ERR("XTC", "Cannot generate thumb BMP, file not loaded");
-    return false;
-  }
-
-  if (parser->getPageCount() == 0) {
-    LOG_ERR("XTC", "No pages in XTC file");
-    return false;
-  }
-
-  // Setup cache directory
-  setupCacheDir();
-
-  // Get first page info for cover
-  xtc::PageInfo pageInfo;
-  if (!parser->getPageInfo(0, pageInfo)) {
-    LOG_DBG("XTC", "Failed to get first page info");
-    return false;
-  }
-
-  // Get bit depth
-  const uint8_t bitDepth = parser->getBitDepth();
-
-  // Calculate target dimensions for thumbnail (fit within 240x400 Continue Reading card)
-  int THUMB_TARGET_WIDTH = height * 0.6;
-  int THUMB_TARGET_HEIGHT = height;
-
-  // Calculate scale factor
-  float scaleX = static_cast<float>(THUMB_TARGET_WIDTH) / pageInfo.width;
-  float scaleY = static_cast<float>(THUMB_TARGET_HEIGHT) / pageInfo.height;
-  float scale = (scaleX > scaleY) ? scaleX : scaleY;  // for cropping
-
-  // Only scale down, never up
-  if (scale >= 1.0f) {
-    // Page is already small enough, just use cover.bmp
-    // Copy cover.bmp to thumb.bmp
-    if (generateCoverBmp()) {
-      FsFile src, dst;
-      if (Storage.openFileForRead("XTC", getCoverBmpPath(), src)) {
-        if (Storage.openFileForWrite("XTC", getThumbBmpPath(height), dst)) {
-          uint8_t buffer[512];
-          while (src.available()) {
-            size_t bytesRead = src.read(buffer, sizeof(buffer));
-            dst.write(buffer, bytesRead);
-          }
-          dst.close();
-        }
-        src.close();
-      }
-      LOG_DBG("XTC", "Copied cover to thumb (no scaling needed)");
-      return Storage.exists(getThumbBmpPath(height).c_str());
-    }
-    return false;
-  }
-
-  uint16_t thumbWidth = static_cast<uint16_t>(pageInfo.width * scale);
-  uint16_t thumbHeight = static_cast<uint16_t>(pageInfo.height * scale);
-
-  LOG_DBG("XTC", "Generating thumb BMP: %dx%d -> %dx%d (scale: %.3f)", pageInfo.width, pageInfo.height, thumbWidth,
-          thumbHeight, scale);
-
-  // Allocate buffer for page data
-  size_t bitmapSize;
-  if (bitDepth == 2) {
-    bitmapSize = ((static_cast<size_t>(pageInfo.width) * pageInfo.height + 7) / 8) * 2;
-  } else {
-    bitmapSize = ((pageInfo.width + 7) / 8) * pageInfo.height;
-  }
-  uint8_t* pageBuffer = static_cast<uint8_t*>(malloc(bitmapSize));
-  if (!pageBuffer) {
-    LOG_ERR("XTC", "Failed to allocate page buffer (%lu bytes)", bitmapSize);
-    return false;
-  }
-
-  // Load first page (cover)
-  size_t bytesRead = const_cast<xtc::XtcParser*>(parser.get())->loadPage(0, pageBuffer, bitmapSize);
-  if (bytesRead == 0) {
-    LOG_ERR("XTC", "Failed to load cover page for thumb");
-    free(pageBuffer);
-    return false;
-  }
-
-  // Create thumbnail BMP file - use 1-bit format for fast home screen rendering (no gray passes)
-  FsFile thumbBmp;
-  if (!Storage.openFileForWrite("XTC", getThumbBmpPath(height), thumbBmp)) {
-    LOG_DBG("XTC", "Failed to create thumb BMP file");
-    free(pageBuffer);
-    return false;
-  }
+// Area-averages the page down by scale into a 1-bit BMP with hash-based noise dithering
+bool writeThumbBmp(FsFile& thumbBmp, const uint8_t* pageBuffer, const size_t bitmapSize,
+                   const xtc::PageInfo& pageInfo, const uint8_t bitDepth, const float scale) {
+  const uint16_t thumbWidth = static_cast<uint16_t>(pageInfo.width * scale);
+  const uint16_t thumbHeight = static_cast<uint16_t>(pageInfo.height * scale);
 
   // Write 1-bit BMP header for fast home screen rendering
   const uint32_t rowSize = (thumbWidth + 31) / 32 * 4;  // 1 bit per pixel, aligned to 4 bytes
@@ -447,8 +293,7 @@ bool Xtc::generateThumbBmp(int height) const {
   // Allocate row buffer for 1-bit output
   uint8_t* rowBuffer = static_cast<uint8_t*>(malloc(rowSize));
   if (!rowBuffer) {
-    free(pageBuffer);
-    thumbBmp.close();
+    LOG_ERR("XTC", "Failed to allocate thumb row buffer");
     return false;
   }
 
@@ -555,12 +400,140 @@ bool Xtc::generateThumbBmp(int height) const {
   }
 
   free(rowBuffer);
-  thumbBmp.close();
-  free(pageBuffer);
-
-  LOG_DBG("XTC", "Generated thumb BMP (%dx%d): %s", thumbWidth, thumbHeight, getThumbBmpPath(height).c_str());
   return true;
 }
+}  // namespace
+
+bool Xtc::generateCoverBmp() const {
+  // Already generated
+  if (Storage.exists(getCoverBmpPath().c_str())) {
+    return true;
+  }
+
+  return generateCovers(0);
+}
+
+std::string Xtc::getThumbBmpPath() const { return cachePath + "/thumb_[HEIGHT].bmp"; }
+std::string Xtc::getThumbBmpPath(int height) const { return cachePath + "/thumb_" + std::to_string(height) + ".bmp"; }
+
+bool Xtc::generateThumbBmp(int height) const {
+  // Already generated
+  if (Storage.exists(getThumbBmpPath(height).c_str())) {
+    return true;
+  }
+
+  return generateCovers(height);
+}
+
+bool Xtc::generateCovers(const int thumbHeight) const {
+  const bool needCover = !Storage.exists(getCoverBmpPath().c_str());
+  const bool needThumb = thumbHeight > 0 && !Storage.exists(getThumbBmpPath(thumbHeight).c_str());
+  if (!needCover && !needThumb) {
+    return true;
+  }
+
+  if (!loaded || !parser) {
+    LOG_ERR("XTC", "Cannot generate cover BMP, file not loaded");
+    return false;
+  }
+
+  if (parser->getPageCount() == 0) {
+    LOG_ERR("XTC", "No pages in XTC file");
+    return false;
+  }
+
+  // Setup cache directory
+  setupCacheDir();
+
+  // Get first page info for cover
+  xtc::PageInfo pageInfo;
+  if (!parser->getPageInfo(0, pageInfo)) {
+    LOG_DBG("XTC", "Failed to get first page info");
+    return false;
+  }
+
+  // Get bit depth
+  const uint8_t bitDepth = parser->getBitDepth();
+
+  // Allocate buffer for page data
+  // XTG (1-bit): Row-major, ((width+7)/8) * height bytes
+  // XTH (2-bit): Two bit planes, column-major, ((width * height + 7) / 8) * 2 bytes
+  size_t bitmapSize;
+  if (bitDepth == 2) {
+    bitmapSize = ((static_cast<size_t>(pageInfo.width) * pageInfo.height + 7) / 8) * 2;
+  } else {
+    bitmapSize = ((pageInfo.width + 7) / 8) * pageInfo.height;
+  }
+  uint8_t* pageBuffer = static_cast<uint8_t*>(malloc(bitmapSize));
+  if (!pageBuffer) {
+    LOG_ERR("XTC", "Failed to allocate page buffer (%lu bytes)", bitmapSize);
+    return false;
+  }
+
+  // Load first page (cover) once for both the cover and the thumbnail
+  size_t bytesRead = const_cast<xtc::XtcParser*>(parser.get())->loadPage(0, pageBuffer, bitmapSize);
+  if (bytesRead == 0) {
+    LOG_ERR("XTC", "Failed to load cover page");
+    free(pageBuffer);
+    return false;
+  }
+
+  bool success = true;
+
+  if (needCover) {
+    FsFile coverBmp;
+    if (!Storage.openFileForWrite("XTC", getCoverBmpPath(), coverBmp)) {
+      LOG_DBG("XTC", "Failed to create cover BMP file");
+      success = false;
+    } else {
+      const bool written = writeCoverBmp(coverBmp, pageBuffer, pageInfo, bitDepth);
+      coverBmp.close();
+      if (written) {
+        LOG_DBG("XTC", "Generated cover BMP: %s", getCoverBmpPath().c_str());
+      } else {
+        Storage.remove(getCoverBmpPath().c_str());
+        success = false;
+      }
+    }
+  }
+
+  if (needThumb) {
+    // Calculate target dimensions for thumbnail (fit within 240x400 Continue Reading card)
+    int THUMB_TARGET_WIDTH = thumbHeight * 0.6;
+    int THUMB_TARGET_HEIGHT = thumbHeight;
+
+    // Calculate scale factor
+    float scaleX = static_cast<float>(THUMB_TARGET_WIDTH) / pageInfo.width;
+    float scaleY = static_cast<float>(THUMB_TARGET_HEIGHT) / pageInfo.height;
+    float scale = (scaleX > scaleY) ? scaleX : scaleY;  // for cropping
+
+    FsFile thumbBmp;
+    if (!Storage.openFileForWrite("XTC", getThumbBmpPath(thumbHeight), thumbBmp)) {
+      LOG_DBG("XTC", "Failed to create thumb BMP file");
+      success = false;
+    } else {
+      // Only scale down, never up: a page that is already small enough is written as the cover is
+      bool written;
+      if (scale >= 1.0f) {
+        written = writeCoverBmp(thumbBmp, pageBuffer, pageInfo, bitDepth);
+      } else {
+        LOG_DBG("XTC", "Generating thumb BMP: %dx%d -> %dx%d (scale: %.3f)", pageInfo.width, pageInfo.height,
+                static_cast<int>(pageInfo.width * scale), static_cast<int>(pageInfo.height * scale), scale);
+        written = writeThumbBmp(thumbBmp, pageBuffer, bitmapSize, pageInfo, bitDepth, scale);
+      }
+      thumbBmp.close();
+      if (written) {
+        LOG_DBG("XTC", "Generated thumb BMP: %s", getThumbBmpPath(thumbHeight).c_str());
+      } else {
+        Storage.remove(getThumbBmpPath(thumbHeight).c_str());
+        success = false;
+      }
+    }
+  }
+
+  free(pageBuffer);
+  return success;
+}
 
 uint32_t Xtc::getPageCount() const {
   if (!loaded || !parser) {
@@ -67,6 +67,9 @@ class Xtc {
   std::string getThumbBmpPath() const;
   std::string getThumbBmpPath(int height) const;
   bool generateThumbBmp(int height) const;
+  // Loads the first page once and writes whichever of cover.bmp and thumb_<thumbHeight>.bmp (thumbHeight > 0)
+  // are missing
+  bool generateCovers(int thumbHeight) const;
 
   // Page access
   uint32_t getPageCount() const;
@@ -3,6 +3,7 @@
 #include <HalStorage.h>
 #include <InflateReader.h>
 #include <Logging.h>
+#include <Trace.h>
 
 #include <algorithm>
 
@@ -387,6 +388,7 @@ int ZipFile::fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector
 }
 
 uint8_t* ZipFile::readFileToMemory(const char* filename, size_t* size, const bool trailingNullByte) {
+  TRACE_SPAN("zip.read");
   const bool wasOpen = isOpen();
   if (!wasOpen && !open()) {
     return nullptr;
@@ -489,6 +491,7 @@ uint8_t* ZipFile::readFileToMemory(const char* filename, size_t* size, const boo
 }
 
 bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t chunkSize) {
+  TRACE_SPAN("zip.stream");
   const bool wasOpen = isOpen();
   if (!wasOpen && !open()) {
     return false;
@@ -531,7 +534,14 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
         return false;
       }
 
-      out.write(buffer, dataRead);
+      if (out.write(buffer, dataRead) != dataRead) {
+        LOG_DBG("ZIP", "Output stream stopped accepting data");
+        free(buffer);
+        if (!wasOpen) {
+          close();
+        }
+        return false;
+      }
       remaining -= dataRead;
     }
 
@@ -595,7 +605,7 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
 
       if (produced > 0) {
         if (out.write(outputBuffer, produced) != produced) {
-          LOG_ERR("ZIP", "Failed to write all output bytes to stream");
+          LOG_DBG("ZIP", "Output stream stopped accepting data");
           break;
         }
       }
@@ -633,3 +643,92 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
   LOG_ERR("ZIP", "Unsupported compression method");
   return false;
 }
+
+bool ZipFile::openEntry(const char* filename, EntryReader& reader, const size_t chunkSize) {
+  reader.close();
+
+  const bool wasOpen = isOpen();
+  if (!wasOpen && !open()) {
+    return false;
+  }
+
+  FileStatSlim fileStat = {};
+  const long fileOffset = loadFileStatSlim(filename, &fileStat) ? getDataOffset(fileStat) : -1;
+  if (fileOffset < 0 || (fileStat.method != ZIP_METHOD_STORED && fileStat.method != ZIP_METHOD_DEFLATED)) {
+    if (fileOffset >= 0) {
+      LOG_ERR("ZIP", "Unsupported compression method");
+    }
+    if (!wasOpen) {
+      close();
+    }
+    return false;
+  }
+
+  file.seek(fileOffset);
+
+  if (fileStat.method == ZIP_METHOD_DEFLATED) {
+    auto* ctx = new ZipInflateCtx;
+    ctx->file = &file;
+    ctx->fileRemaining = fileStat.compressedSize;
+    ctx->readBufSize = chunkSize;
+    ctx->readBuf = static_cast<uint8_t*>(malloc(chunkSize));
+    if (!ctx->readBuf || !ctx->reader.init(true)) {
+      LOG_ERR("ZIP", "Failed to set up entry inflater");
+      free(ctx->readBuf);
+      delete ctx;
+      if (!wasOpen) {
+        close();
+      }
+      return false;
+    }
+    ctx->reader.setReadCallback(zipReadCallback);
+    reader.ctx = ctx;
+  }
+
+  reader.zip = this;
+  reader.uncompressedSize = fileStat.uncompressedSize;
+  reader.remaining = fileStat.uncompressedSize;
+  reader.closeZip = !wasOpen;
+  return true;
+}
+
+size_t ZipFile::EntryReader::read(uint8_t* dest, size_t len) {
+  if (!zip || remaining == 0) {
+    return 0;
+  }
+  if (len > remaining) {
+    len = remaining;
+  }
+
+  size_t produced = 0;
+  if (!ctx) {
+    const int bytesRead = zip->file.read(dest, len);
+    produced = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+  } else if (ctx->reader.readAtMost(dest, len, &produced) == InflateStatus::Error) {
+    LOG_ERR("ZIP", "Decompression failed");
+    produced = 0;
+  }
+
+  if (produced == 0) {
+    // Truncated or corrupt entry: report end of stream from now on
+    remaining = 0;
+    return 0;
+  }
+  remaining -= produced;
+  return produced;
+}
+
+void ZipFile::EntryReader::close() {
+  if (ctx) {
+    free(ctx->readBuf);
+    delete ctx;  // reader destructor frees the ring buffer
+    ctx = nullptr;
+  }
+  if (zip && closeZip) {
+    zip->close();
+  }
+  zip = nullptr;
+  uncompressedSize = 0;
+  remaining = 0;
+  closeZip = false;
+}
@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <vector>
 
+struct ZipInflateCtx;
+
 class ZipFile {
  public:
   struct FileStatSlim {
@@ -27,6 +29,31 @@ class ZipFile {
     uint16_t index;  // Caller's index (e.g. spine index)
   };
 
+  // Pull-style reader over one entry, for consumers that parse incrementally (e.g. image decoders) instead of
+  // receiving pushed chunks. Reads through the owning ZipFile's handle, so no other ZipFile call may be made
+  // while it is open; the zip is closed again on close() if openEntry() had to open it.
+  class EntryReader {
+   public:
+    EntryReader() = default;
+    ~EntryReader() { close(); }
+    EntryReader(const EntryReader&) = delete;
+    EntryReader& operator=(const EntryReader&) = delete;
+
+    bool isOpen() const { return zip != nullptr; }
+    size_t size() const { return uncompressedSize; }
+    // Returns the number of bytes read; 0 at end of entry or on error
+    size_t read(uint8_t* dest, size_t len);
+    void close();
+
+   private:
+    friend class ZipFile;
+    ZipFile* zip = nullptr;
+    ZipInflateCtx* ctx = nullptr;  // deflated entries only
+    size_t uncompressedSize = 0;
+    size_t remaining = 0;
+    bool closeZip = false;
+  };
+
   // FNV-1a 64-bit hash computed from char buffer (no std::string allocation)
   static uint64_t fnvHash64(const char* s, size_t len) {
     uint64_t hash = 14695981039346656037ull;
@@ -37,6 +64,16 @@ class ZipFile {
     return hash;
   }
 
+  // FNV-1a 32-bit hash; pass the previous result as hash to continue it over another buffer
+  static uint32_t fnvHash32(const void* data, const size_t len, uint32_t hash = 2166136261u) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+      hash ^= bytes[i];
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
  private:
   const std::string& filePath;
   FsFile file;
@@ -68,5 +105,8 @@ class ZipFile {
   // Due to the memory required to run each of these, it is recommended to not preopen the zip file for multiple
   // These functions will open and close the zip as needed
   uint8_t* readFileToMemory(const char* filename, size_t* size = nullptr, bool trailingNullByte = false);
+  // Stops and returns false when out accepts fewer bytes than written, so a consumer can end the read early
   bool readFileToStream(const char* filename, Print& out, size_t chunkSize);
+  // Opens an entry for pull-style reading, inflating on demand through a chunkSize read buffer
+  bool openEntry(const char* filename, EntryReader& reader, size_t chunkSize);
 };
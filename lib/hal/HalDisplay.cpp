@@ -1,23 +1,40 @@
 #include <HalDisplay.h>
 #include <HalGPIO.h>
+#include <HalPowerManager.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Trace.h>
 
 #define SD_SPI_MISO 7
 
+// The panel and the SD card share the SPI bus (SPI_MISO in HalGPIO.h), so driver calls that talk to the panel take
+// the storage lock every SD access takes
+using SpiBusLock = HalStorage::StorageLock;
+
 HalDisplay::HalDisplay() : einkDisplay(EPD_SCLK, EPD_MOSI, EPD_CS, EPD_DC, EPD_RST, EPD_BUSY) {}
 
 HalDisplay::~HalDisplay() {}
 
-void HalDisplay::begin() { einkDisplay.begin(); }
+void HalDisplay::begin() {
+  SpiBusLock busLock;
+  einkDisplay.begin();
+}
 
-void HalDisplay::clearScreen(uint8_t color) const { einkDisplay.clearScreen(color); }
+void HalDisplay::clearScreen(uint8_t color) const {
+  waitForRefresh();
+  SpiBusLock busLock;
+  einkDisplay.clearScreen(color);
+}
 
 void HalDisplay::drawImage(const uint8_t* imageData, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
                            bool fromProgmem) const {
+  waitForRefresh();
   einkDisplay.drawImage(imageData, x, y, w, h, fromProgmem);
 }
 
 void HalDisplay::drawImageTransparent(const uint8_t* imageData, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
                                       bool fromProgmem) const {
+  waitForRefresh();
   einkDisplay.drawImageTransparent(imageData, x, y, w, h, fromProgmem);
 }
 
@@ -34,25 +51,134 @@ EInkDisplay::RefreshMode convertRefreshMode(HalDisplay::RefreshMode mode) {
 }
 
 void HalDisplay::displayBuffer(HalDisplay::RefreshMode mode, bool turnOffScreen) {
+  waitForRefresh();
+  TRACE_SPAN("display.refresh");
+  SpiBusLock busLock;
   einkDisplay.displayBuffer(convertRefreshMode(mode), turnOffScreen);
 }
 
 void HalDisplay::refreshDisplay(HalDisplay::RefreshMode mode, bool turnOffScreen) {
+  waitForRefresh();
+  SpiBusLock busLock;
   einkDisplay.refreshDisplay(convertRefreshMode(mode), turnOffScreen);
 }
 
-void HalDisplay::deepSleep() { einkDisplay.deepSleep(); }
+void HalDisplay::deepSleep() {
+  waitForRefresh();
+  SpiBusLock busLock;
+  einkDisplay.deepSleep();
+}
 
-uint8_t* HalDisplay::getFrameBuffer() const { return einkDisplay.getFrameBuffer(); }
+uint8_t* HalDisplay::getFrameBuffer() const {
+  waitForRefresh();
+  return einkDisplay.getFrameBuffer();
+}
 
 void HalDisplay::copyGrayscaleBuffers(const uint8_t* lsbBuffer, const uint8_t* msbBuffer) {
+  waitForRefresh();
+  SpiBusLock busLock;
   einkDisplay.copyGrayscaleBuffers(lsbBuffer, msbBuffer);
 }
 
-void HalDisplay::copyGrayscaleLsbBuffers(const uint8_t* lsbBuffer) { einkDisplay.copyGrayscaleLsbBuffers(lsbBuffer); }
+void HalDisplay::copyGrayscaleLsbBuffers(const uint8_t* lsbBuffer) {
+  waitForRefresh();
+  SpiBusLock busLock;
+  einkDisplay.copyGrayscaleLsbBuffers(lsbBuffer);
+}
 
-void HalDisplay::copyGrayscaleMsbBuffers(const uint8_t* msbBuffer) { einkDisplay.copyGrayscaleMsbBuffers(msbBuffer); }
+void HalDisplay::copyGrayscaleMsbBuffers(const uint8_t* msbBuffer) {
+  waitForRefresh();
+  SpiBusLock busLock;
+  einkDisplay.copyGrayscaleMsbBuffers(msbBuffer);
+}
 
-void HalDisplay::cleanupGrayscaleBuffers(const uint8_t* bwBuffer) { einkDisplay.cleanupGrayscaleBuffers(bwBuffer); }
+void HalDisplay::cleanupGrayscaleBuffers(const uint8_t* bwBuffer) {
+  waitForRefresh();
+  SpiBusLock busLock;
+  einkDisplay.cleanupGrayscaleBuffers(bwBuffer);
+}
+
+void HalDisplay::displayGrayBuffer(bool turnOffScreen) {
+  waitForRefresh();
+  TRACE_SPAN("display.gray");
+  SpiBusLock busLock;
+  einkDisplay.displayGrayBuffer(turnOffScreen);
+}
 
-void HalDisplay::displayGrayBuffer(bool turnOffScreen) { einkDisplay.displayGrayBuffer(turnOffScreen); }
+HalDisplay::RefreshHandle HalDisplay::displayBufferAsync(HalDisplay::RefreshMode mode, bool turnOffScreen) {
+  return startRefresh(RefreshJob::Bw, mode, turnOffScreen);
+}
+
+HalDisplay::RefreshHandle HalDisplay::displayGrayBufferAsync(bool turnOffScreen) {
+  return startRefresh(RefreshJob::Gray, FAST_REFRESH, turnOffScreen);
+}
+
+void HalDisplay::waitForRefresh() const {
+  if (refreshesCompleted == refreshesStarted) {
+    return;
+  }
+  // The refresh task holds refreshIdle until the panel is done
+  xSemaphoreTake(refreshIdle, portMAX_DELAY);
+  xSemaphoreGive(refreshIdle);
+}
+
+HalDisplay::RefreshHandle HalDisplay::startRefresh(const RefreshJob job, const RefreshMode mode,
+                                                   const bool turnOffScreen) {
+  if (!refreshTaskHandle) {
+    if (!refreshIdle) {
+      refreshIdle = xSemaphoreCreateBinary();
+      if (refreshIdle) xSemaphoreGive(refreshIdle);
+    }
+    if (refreshIdle) {
+      // Same priority as the render task: the driver sleeps while polling BUSY, leaving the CPU to the caller
+      xTaskCreate(&refreshTaskTrampoline, "DisplayRefresh", 4096, this, 1, &refreshTaskHandle);
+    }
+    if (!refreshTaskHandle) {
+      LOG_ERR("DSP", "Failed to create refresh task, refreshing synchronously");
+      SpiBusLock busLock;
+      if (job == RefreshJob::Gray) {
+        einkDisplay.displayGrayBuffer(turnOffScreen);
+      } else {
+        einkDisplay.displayBuffer(convertRefreshMode(mode), turnOffScreen);
+      }
+      return {};
+    }
+  }
+
+  xSemaphoreTake(refreshIdle, portMAX_DELAY);  // previous refresh finished
+  pendingJob = job;
+  pendingMode = mode;
+  pendingTurnOffScreen = turnOffScreen;
+  const uint32_t ticket = refreshesStarted + 1;
+  refreshesStarted = ticket;
+  xTaskNotifyGive(refreshTaskHandle);
+  return {this, ticket};
+}
+
+void HalDisplay::refreshTaskTrampoline(void* param) {
+  auto* self = static_cast<HalDisplay*>(param);
+  self->refreshTaskLoop();
+}
+
+void HalDisplay::refreshTaskLoop() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const unsigned long start = millis();
+    {
+      TRACE_SPAN("display.async");
+      // Mostly spent polling BUSY, the clock can drop unless another task needs it
+      HalPowerManager::Lock powerLock(HalPowerManager::Workload::Wait);
+      // The driver sends the frame and polls BUSY in one call, so the bus stays taken until the panel is done: SD
+      // access from other tasks waits, only their CPU work overlaps the refresh
+      SpiBusLock busLock;
+      if (pendingJob == RefreshJob::Gray) {
+        einkDisplay.displayGrayBuffer(pendingTurnOffScreen);
+      } else {
+        einkDisplay.displayBuffer(convertRefreshMode(pendingMode), pendingTurnOffScreen);
+      }
+    }
+    LOG_DBG("DSP", "Async refresh done in %lu ms", millis() - start);
+    refreshesCompleted = refreshesStarted;
+    xSemaphoreGive(refreshIdle);
+  }
+}
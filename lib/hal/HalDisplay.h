@@ -1,6 +1,9 @@
 #pragma once
 #include <Arduino.h>
 #include <EInkDisplay.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 class HalDisplay {
  public:
@@ -17,6 +20,22 @@ class HalDisplay {
     FAST_REFRESH   // Fast refresh using custom LUT
   };
 
+  // Completion handle of an asynchronous refresh
+  class RefreshHandle {
+   public:
+    RefreshHandle() = default;
+    bool done() const { return display == nullptr || display->isRefreshDone(ticket); }
+    void wait() const {
+      if (display) display->waitForRefresh();
+    }
+
+   private:
+    friend class HalDisplay;
+    RefreshHandle(const HalDisplay* display, const uint32_t ticket) : display(display), ticket(ticket) {}
+    const HalDisplay* display = nullptr;
+    uint32_t ticket = 0;
+  };
+
   // Initialize the display hardware and driver
   void begin();
 
@@ -36,6 +55,16 @@ class HalDisplay {
   void displayBuffer(RefreshMode mode = RefreshMode::FAST_REFRESH, bool turnOffScreen = false);
   void refreshDisplay(RefreshMode mode = RefreshMode::FAST_REFRESH, bool turnOffScreen = false);
 
+  // Start a refresh on the display task and return at once, so the caller can do CPU work while the panel is BUSY.
+  // The driver sends the frame and waits for BUSY in one call, so the refresh holds the SPI bus it shares with the SD
+  // card until it completes: SD access from any task, page reads included, waits for it. The frame buffer is read
+  // until the refresh completes: don't draw into it before the handle is done. Every other HalDisplay call waits for a
+  // running refresh first; only one refresh is in flight at a time.
+  RefreshHandle displayBufferAsync(RefreshMode mode = RefreshMode::FAST_REFRESH, bool turnOffScreen = false);
+  RefreshHandle displayGrayBufferAsync(bool turnOffScreen = false);
+  bool isRefreshDone(uint32_t ticket) const { return refreshesCompleted >= ticket; }
+  void waitForRefresh() const;
+
   // Power management
   void deepSleep();
 
@@ -50,5 +79,20 @@ class HalDisplay {
   void displayGrayBuffer(bool turnOffScreen = false);
 
  private:
+  enum class RefreshJob : uint8_t { Bw, Gray };
+
   EInkDisplay einkDisplay;
+
+  // Refresh task, created on the first asynchronous refresh. refreshIdle is held while a refresh runs.
+  TaskHandle_t refreshTaskHandle = nullptr;
+  SemaphoreHandle_t refreshIdle = nullptr;
+  volatile uint32_t refreshesStarted = 0;
+  volatile uint32_t refreshesCompleted = 0;
+  RefreshJob pendingJob = RefreshJob::Bw;
+  RefreshMode pendingMode = RefreshMode::FAST_REFRESH;
+  bool pendingTurnOffScreen = false;
+
+  RefreshHandle startRefresh(RefreshJob job, RefreshMode mode, bool turnOffScreen);
+  static void refreshTaskTrampoline(void* param);
+  [[noreturn]] void refreshTaskLoop();
 };
@@ -1,22 +1,78 @@
 #include "HalPowerManager.h"
 
 #include <Logging.h>
+#include <Trace.h>
 #include <WiFi.h>
 #include <esp_sleep.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include "HalGPIO.h"
 
 HalPowerManager powerManager;  // Singleton instance
 
+namespace {
+// Residency stretches land in the trace ring under these names, so the trace summary adds up time per workload
+constexpr const char* WORKLOAD_NAMES[] = {"cpu.idle", "cpu.wait", "cpu.interactive"};
+static_assert(sizeof(WORKLOAD_NAMES) / sizeof(WORKLOAD_NAMES[0]) ==
+                  static_cast<size_t>(HalPowerManager::Workload::_COUNT),
+              "WORKLOAD_NAMES out of sync with Workload");
+}  // namespace
+
 void HalPowerManager::begin() {
   pinMode(BAT_GPIO0, INPUT);
   normalFreq = getCpuFrequencyMhz();
+  workloadSinceUs = micros();
   modeMutex = xSemaphoreCreateMutex();
   assert(modeMutex != nullptr);
 }
 
+int HalPowerManager::frequencyFor(const Workload workload) const {
+  switch (workload) {
+    case Workload::Idle:
+      return LOW_POWER_FREQ;
+    case Workload::Wait:
+      return std::min(WAIT_FREQ, normalFreq);
+    default:
+      return normalFreq;
+  }
+}
+
+void HalPowerManager::applyWorkload() {
+  if (normalFreq <= 0) {
+    return;  // not started yet
+  }
+
+  Workload target = powerSaving ? Workload::Idle : Workload::Interactive;
+  for (const auto workload : {Workload::Wait, Workload::Interactive}) {
+    if (demand[static_cast<size_t>(workload)] > 0) target = workload;
+  }
+  if (target == currentWorkload) {
+    return;
+  }
+
+  const int freq = frequencyFor(target);
+  if (target == Workload::Idle) {
+    LOG_DBG("PWR", "Going to low-power mode");
+  } else if (currentWorkload == Workload::Idle) {
+    LOG_DBG("PWR", "Restoring normal CPU frequency");
+  }
+  if (freq != frequencyFor(currentWorkload) && !setCpuFrequencyMhz(freq)) {
+    LOG_DBG("PWR", "Failed to set CPU frequency = %d MHz", freq);
+    return;
+  }
+
+  const uint32_t now = micros();
+  residencyUs[static_cast<size_t>(currentWorkload)] += now - workloadSinceUs;
+#ifdef ENABLE_TRACE
+  trace::record(WORKLOAD_NAMES[static_cast<size_t>(currentWorkload)], workloadSinceUs, now - workloadSinceUs);
+#endif
+  currentWorkload = target;
+  workloadSinceUs = now;
+  switchCount++;
+}
+
 void HalPowerManager::setPowerSaving(bool enabled) {
   if (normalFreq <= 0) {
     return;  // invalid state
@@ -28,28 +84,16 @@ void HalPowerManager::setPowerSaving(bool enabled) {
     enabled = false;
   }
 
-  // Note: We don't use mutex here to avoid too much overhead,
-  // it's not very important if we read a slightly stale value for currentLockMode
-  const LockMode mode = currentLockMode;
-
-  if (mode == None && enabled && !isLowPower) {
-    LOG_DBG("PWR", "Going to low-power mode");
-    if (!setCpuFrequencyMhz(LOW_POWER_FREQ)) {
-      LOG_DBG("PWR", "Failed to set CPU frequency = %d MHz", LOW_POWER_FREQ);
-      return;
-    }
-    isLowPower = true;
-
-  } else if ((!enabled || mode != None) && isLowPower) {
-    LOG_DBG("PWR", "Restoring normal CPU frequency");
-    if (!setCpuFrequencyMhz(normalFreq)) {
-      LOG_DBG("PWR", "Failed to set CPU frequency = %d MHz", normalFreq);
-      return;
-    }
-    isLowPower = false;
+  // Called on every loop iteration: only take the mutex when the request changes.
+  // A slightly stale read just defers the change to the next iteration.
+  if (enabled == powerSaving) {
+    return;
   }
 
-  // Otherwise, no change needed
+  xSemaphoreTake(modeMutex, portMAX_DELAY);
+  powerSaving = enabled;
+  applyWorkload();
+  xSemaphoreGive(modeMutex);
 }
 
 void HalPowerManager::startDeepSleep(HalGPIO& gpio) const {
@@ -69,27 +113,42 @@ uint16_t HalPowerManager::getBatteryPercentage() const {
   return battery.readPercentage();
 }
 
-HalPowerManager::Lock::Lock() {
-  xSemaphoreTake(powerManager.modeMutex, portMAX_DELAY);
-  // Current limitation: only one lock at a time
-  if (powerManager.currentLockMode != None) {
-    LOG_ERR("PWR", "Lock already held, ignore");
-    valid = false;
-  } else {
-    powerManager.currentLockMode = NormalSpeed;
-    valid = true;
+uint64_t HalPowerManager::getResidencyUs(const Workload workload) {
+  xSemaphoreTake(modeMutex, portMAX_DELAY);
+  uint64_t residency = residencyUs[static_cast<size_t>(workload)];
+  if (workload == currentWorkload) {
+    residency += micros() - workloadSinceUs;
   }
-  xSemaphoreGive(powerManager.modeMutex);
-  if (valid) {
-    // Immediately restore normal CPU frequency if currently in low-power mode
-    powerManager.setPowerSaving(false);
+  xSemaphoreGive(modeMutex);
+  return residency;
+}
+
+void HalPowerManager::logResidency() {
+  uint64_t totalUs = 0;
+  uint64_t residency[static_cast<size_t>(Workload::_COUNT)];
+  for (size_t i = 0; i < static_cast<size_t>(Workload::_COUNT); i++) {
+    residency[i] = getResidencyUs(static_cast<Workload>(i));
+    totalUs += residency[i];
+  }
+  if (totalUs == 0) {
+    return;
   }
+  LOG_INF("PWR", "CPU residency: idle %u%%, wait %u%%, interactive %u%% (%u switches)",
+          static_cast<unsigned>(residency[0] * 100 / totalUs), static_cast<unsigned>(residency[1] * 100 / totalUs),
+          static_cast<unsigned>(residency[2] * 100 / totalUs), static_cast<unsigned>(switchCount));
+}
+
+HalPowerManager::Lock::Lock(const Workload workload) : workload(workload) {
+  xSemaphoreTake(powerManager.modeMutex, portMAX_DELAY);
+  powerManager.demand[static_cast<size_t>(workload)]++;
+  // Immediately switch to the workload's frequency, e.g. out of low-power mode
+  powerManager.applyWorkload();
+  xSemaphoreGive(powerManager.modeMutex);
 }
 
 HalPowerManager::Lock::~Lock() {
   xSemaphoreTake(powerManager.modeMutex, portMAX_DELAY);
-  if (valid) {
-    powerManager.currentLockMode = None;
-  }
+  powerManager.demand[static_cast<size_t>(workload)]--;
+  powerManager.applyWorkload();
   xSemaphoreGive(powerManager.modeMutex);
 }
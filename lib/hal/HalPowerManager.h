@@ -13,15 +13,34 @@ class HalPowerManager;
 extern HalPowerManager powerManager;  // Singleton
 
 class HalPowerManager {
+ public:
+  // Workload classes the CPU clock is picked for. With several in flight the highest one wins; Idle applies only
+  // when nothing is in flight and power saving is on.
+  enum class Workload : uint8_t {
+    Idle,         // LOW_POWER_FREQ, waiting for input after IDLE_POWER_SAVING_MS
+    Wait,         // WAIT_FREQ, waiting for the e-ink panel to finish a refresh (BUSY)
+    Interactive,  // normal frequency, rendering, UI and indexing
+    _COUNT
+  };
+
+ private:
   int normalFreq = 0;  // MHz
-  bool isLowPower = false;
+  bool powerSaving = false;
 
-  enum LockMode { None, NormalSpeed };
-  LockMode currentLockMode = None;
-  SemaphoreHandle_t modeMutex = nullptr;  // Protect access to currentLockMode
+  Workload currentWorkload = Workload::Interactive;
+  uint8_t demand[static_cast<size_t>(Workload::_COUNT)] = {};  // Locks held per workload
+  uint64_t residencyUs[static_cast<size_t>(Workload::_COUNT)] = {};
+  uint32_t workloadSinceUs = 0;
+  uint32_t switchCount = 0;
+  SemaphoreHandle_t modeMutex = nullptr;  // Protect demand, powerSaving and the residency counters
+
+  int frequencyFor(Workload workload) const;
+  // Switches the clock to the workload demand asks for. Callers hold modeMutex.
+  void applyWorkload();
 
  public:
   static constexpr int LOW_POWER_FREQ = 10;                    // MHz
+  static constexpr int WAIT_FREQ = 80;                         // MHz, lowest that keeps the APB bus (SPI) at 80 MHz
   static constexpr unsigned long IDLE_POWER_SAVING_MS = 3000;  // ms
 
   void begin();
@@ -30,21 +49,26 @@ class HalPowerManager {
   void setPowerSaving(bool enabled);
 
   // Setup wake up GPIO and enter deep sleep
-  // Should be called inside main loop() to handle the currentLockMode
+  // Should be called inside main loop() so no Lock is held
   void startDeepSleep(HalGPIO& gpio) const;
 
   // Get battery percentage (range 0-100)
   uint16_t getBatteryPercentage() const;
 
+  // Time spent at each workload's frequency since boot, including the current stretch
+  uint64_t getResidencyUs(Workload workload);
+  // Logs residency per workload and the number of clock switches
+  void logResidency();
+
   // RAII helper class to manage power saving locks
   // Usage: create an instance of Lock in a scope to disable power saving, for example when running a task that needs
   // full performance. When the Lock instance is destroyed (goes out of scope), power saving will be re-enabled.
+  // Pass a workload to pick the clock for it instead, e.g. Wait around a panel refresh.
   class Lock {
-    friend class HalPowerManager;
-    bool valid = false;
+    Workload workload;
 
    public:
-    explicit Lock();
+    explicit Lock(Workload workload = Workload::Interactive);
     ~Lock();
 
     // Non-copyable and non-movable
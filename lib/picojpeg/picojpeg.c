@@ -154,6 +154,11 @@ static uint8 gMCUBufB[256];
 static int16 gQuant0[8 * 8];
 static int16 gQuant1[8 * 8];
 
+// Unscaled quantization entries (zag order) for the reduced IDCT, which only needs the low-frequency 4x4 corner
+#define PJPG_REDUCED_QUANT_ENTRIES 25
+static int16 gRawQuant0[PJPG_REDUCED_QUANT_ENTRIES];
+static int16 gRawQuant1[PJPG_REDUCED_QUANT_ENTRIES];
+
 // 6 bytes
 static int16 gLastDC[3];
 
@@ -579,6 +584,13 @@ static uint8 readDQTMarker(void) {
         gQuant1[i] = (int16)temp;
       else
         gQuant0[i] = (int16)temp;
+
+      if (i < PJPG_REDUCED_QUANT_ENTRIES) {
+        if (n)
+          gRawQuant1[i] = (int16)temp;
+        else
+          gRawQuant0[i] = (int16)temp;
+      }
     }
 
     createWinogradQuant(n ? gQuant1 : gQuant0);
@@ -1907,6 +1919,55 @@ static void transformBlockReduce(uint8 mcuBlock) {
   }
 }
 //------------------------------------------------------------------------------
+// Reduced IDCT kernels: C(u) * cos((2i + 1) * u * pi / (2N)) in 1.11 fixed point, indexed [i][u]
+static const int16 gReduceKernel4[4][4] = {
+    {1448, 1892, 1448, 784},
+    {1448, 784, -1448, -1892},
+    {1448, -784, -1448, 1892},
+    {1448, -1892, 1448, -784},
+};
+static const int16 gReduceKernel2[2][2] = {
+    {1448, 1448},
+    {1448, -1448},
+};
+
+// Reconstruct an NxN (N = 4 or 2) luma block from the low-frequency NxN corner of the unscaled coefficients in
+// gCoeffBuf. Sampling the 8-point basis at the centre of each NxN cell makes this a direct 1/2 or 1/4 scale decode:
+// f(i, j) = 1/4 * sum(C(u) C(v) F(u, v) cos((2i + 1) u pi / 2N) cos((2j + 1) v pi / 2N)).
+// Output goes to all three component buffers at row stride 8, so the block offsets match a full decode.
+static void transformBlockReduced(uint8 mcuBlock) {
+  long tmp[4 * 4];
+  const uint8 n = (gReduce == PJPG_REDUCE_HALF) ? 4 : 2;
+  const int16* pKernel = (n == 4) ? &gReduceKernel4[0][0] : &gReduceKernel2[0][0];
+  uint8 ofs, x, y, u;
+
+  // Luma blocks come first in the MCU; only YH1V2 stacks them vertically
+  ofs = (uint8)(mcuBlock * ((gScanType == PJPG_YH1V2) ? 128 : 64));
+
+  // Horizontal pass: tmp[v][x] = sum_u K[x][u] * F(v, u)
+  for (y = 0; y < n; y++) {
+    for (x = 0; x < n; x++) {
+      long sum = 0;
+      for (u = 0; u < n; u++) sum += (long)pKernel[x * n + u] * gCoeffBuf[y * 8 + u];
+      tmp[y * 4 + x] = (sum + (1 << 10)) >> 11;
+    }
+  }
+
+  // Vertical pass, then the 1/4 normalization (and the kernel scale) in a single shift
+  for (y = 0; y < n; y++) {
+    for (x = 0; x < n; x++) {
+      long sum = 0;
+      uint8 c;
+      for (u = 0; u < n; u++) sum += (long)pKernel[y * n + u] * tmp[u * 4 + x];
+      sum = (sum + (1 << 12)) >> 13;
+      c = (sum < -128) ? 0 : ((sum > 127) ? 255 : (uint8)(sum + 128));
+      gMCUBufR[ofs + y * 8 + x] = c;
+      gMCUBufG[ofs + y * 8 + x] = c;
+      gMCUBufB[ofs + y * 8 + x] = c;
+    }
+  }
+}
+//------------------------------------------------------------------------------
 static uint8 decodeNextMCU(void) {
   uint8 status;
   uint8 mcuBlock;
@@ -1941,7 +2002,55 @@ static uint8 decodeNextMCU(void) {
 
     compACTab = gCompACTab[componentID];
 
-    if (gReduce) {
+    if (gReduce >= PJPG_REDUCE_HALF) {
+      // Keep only the unscaled low-frequency NxN corner of the luma blocks; chroma is decoded and discarded
+      const uint8 n = (gReduce == PJPG_REDUCE_HALF) ? 4 : 2;
+      const uint8 isLuma = (componentID == 0);
+      const int16* pRawQ = compQuant ? gRawQuant1 : gRawQuant0;
+
+      for (k = 0; k < 4; k++) {
+        gCoeffBuf[k * 8 + 0] = 0;
+        gCoeffBuf[k * 8 + 1] = 0;
+        gCoeffBuf[k * 8 + 2] = 0;
+        gCoeffBuf[k * 8 + 3] = 0;
+      }
+      gCoeffBuf[0] = dc * pRawQ[0];
+
+      for (k = 1; k < 64; k++) {
+        uint16 extraBits;
+
+        s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
+
+        extraBits = 0;
+        numExtraBits = s & 0xF;
+        if (numExtraBits) extraBits = getBits2(numExtraBits);
+
+        r = s >> 4;
+        s &= 15;
+
+        if (s) {
+          if (r) {
+            if ((k + r) > 63) return PJPG_DECODE_ERROR;
+
+            k = (uint8)(k + r);
+          }
+
+          if (isLuma && k < PJPG_REDUCED_QUANT_ENTRIES) {
+            const uint8 zag = (uint8)ZAG[k];
+            if ((zag >> 3) < n && (zag & 7) < n) gCoeffBuf[zag] = huffExtend(extraBits, s) * pRawQ[k];
+          }
+        } else {
+          if (r == 15) {
+            if ((k + 16) > 64) return PJPG_DECODE_ERROR;
+
+            k += (16 - 1);  // - 1 because the loop counter is k
+          } else
+            break;
+        }
+      }
+
+      if (isLuma) transformBlockReduced(mcuBlock);
+    } else if (gReduce) {
       // Decode, but throw out the AC coefficients in reduce mode.
       for (k = 1; k < 64; k++) {
         s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
@@ -2038,6 +2147,12 @@ unsigned char pjpeg_decode_mcu(void) {
   return 0;
 }
 //------------------------------------------------------------------------------
+unsigned char pjpeg_decode_set_reduce(unsigned char reduce) {
+  if (reduce > PJPG_REDUCE_QUARTER) return PJPG_UNSUPPORTED_MODE;
+  gReduce = reduce;
+  return 0;
+}
+//------------------------------------------------------------------------------
 unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
                                 void* pCallback_data, unsigned char reduce) {
   uint8 status;
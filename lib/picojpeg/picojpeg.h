@@ -49,6 +49,9 @@ enum {
   PJPG_UNSUPPORTED_MODE,  // picojpeg doesn't support progressive JPEG's
 };
 
+// Reduce modes (output scale) for pjpeg_decode_init() / pjpeg_decode_set_reduce()
+enum { PJPG_REDUCE_NONE = 0, PJPG_REDUCE_EIGHTH = 1, PJPG_REDUCE_HALF = 2, PJPG_REDUCE_QUARTER = 3 };
+
 // Scan types
 typedef enum { PJPG_GRAYSCALE, PJPG_YH1V1, PJPG_YH2V1, PJPG_YH1V2, PJPG_YH2V2 } pjpeg_scan_type_t;
 
@@ -109,9 +112,16 @@ typedef unsigned char (*pjpeg_need_bytes_callback_t)(unsigned char* pBuf, unsign
 // pNeed_bytes_callback will be called to fill the decompressor's internal input buffer.
 // If reduce is 1, only the first pixel of each block will be decoded. This mode is much faster because it skips the AC
 // dequantization, IDCT and chroma upsampling of every image pixel. Not thread safe.
+// If reduce is PJPG_REDUCE_HALF or PJPG_REDUCE_QUARTER, each block is reconstructed at 4x4 or 2x2 pixels from its
+// low-frequency coefficients only. These modes decode luma only (R, G and B all receive Y) and leave the pixels at
+// row stride 8 inside each block, so only the top-left corner of every 8x8 block is valid.
 unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
                                 void* pCallback_data, unsigned char reduce);
 
+// Changes the reduce mode after pjpeg_decode_init() has parsed the headers (so the caller can pick a scale from the
+// image size). Must be called before the first pjpeg_decode_mcu(). Returns 0 on success.
+unsigned char pjpeg_decode_set_reduce(unsigned char reduce);
+
 // Decompresses the file's next MCU. Returns 0 on success, PJPG_NO_MORE_BLOCKS if no more blocks are available, or an
 // error code. Must be called a total of m_MCUSPerRow*m_MCUSPerCol times to completely decompress the image. Not thread
 // safe.
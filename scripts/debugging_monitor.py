@@ -11,6 +11,7 @@ Features:
 - Interactive memory usage graphing with matplotlib
 - Command input interface for sending commands to the ESP32 device
 - Screenshot capture and processing (1-bit black/white format)
+- Performance trace capture (TRACE command, firmware built with -DENABLE_TRACE), saved to trace.csv
 - Graceful shutdown handling with Ctrl-C signal processing
 - Configurable filtering and suppression of log messages
 - Thread-safe operation with coordinated shutdown events
@@ -90,7 +91,7 @@ init(autoreset=True)
 # Color mapping for log lines
 COLOR_KEYWORDS: dict[str, list[str]] = {
     Fore.RED: ["ERROR", "[ERR]", "[SCT]", "FAILED", "WARNING"],
-    Fore.CYAN: ["[MEM]", "FREE:"],
+    Fore.CYAN: ["[MEM]", "FREE:", "[TRC]"],
     Fore.MAGENTA: [
         "[GFX]",
         "[ERS]",
@@ -195,6 +196,35 @@ def parse_memory_line(line: str) -> tuple[int | None, int | None, int | None]:
     )
 
 
+def save_trace(trace_lines: list[str]) -> None:
+    """
+    Saves the spans of a TRACE dump to trace.csv and prints a per-name summary.
+    Each line is "name,startUs,durationUs".
+    """
+    stats: dict[str, list[int]] = {}
+    with open("trace.csv", "w", encoding="utf-8") as f:
+        f.write("name,start_us,duration_us\n")
+        for line in trace_lines:
+            parts = line.split(",")
+            if len(parts) != 3:
+                continue
+            try:
+                duration = int(parts[2])
+            except ValueError:
+                continue
+            f.write(line + "\n")
+            stats.setdefault(parts[0], []).append(duration)
+
+    print(f"{Fore.GREEN}Trace saved to trace.csv ({len(trace_lines)} spans){Style.RESET_ALL}")
+    print(f"{Fore.CYAN}[TRC] {'span':<16} {'count':>5} {'total ms':>10} {'avg ms':>8} {'max ms':>8}")
+    for name, durations in sorted(stats.items(), key=lambda item: -sum(item[1])):
+        total = sum(durations) / 1000
+        print(
+            f"{Fore.CYAN}[TRC] {name:<16} {len(durations):>5} {total:>10.1f} "
+            f"{total / len(durations):>8.1f} {max(durations) / 1000:>8.1f}"
+        )
+
+
 def serial_worker(ser, kwargs: dict[str, str]) -> None:
     """
     Runs in a background thread. Handles reading serial data, printing to console,
@@ -222,6 +252,7 @@ def serial_worker(ser, kwargs: dict[str, str]) -> None:
     expecting_screenshot = False
     screenshot_size = 0
     screenshot_data = b""
+    trace_lines: list[str] | None = None
 
     try:
         while not shutdown_event.is_set():
@@ -264,6 +295,17 @@ def serial_worker(ser, kwargs: dict[str, str]) -> None:
                         continue
                     elif clean_line == "SCREENSHOT_END":
                         continue  # ignore
+                    elif clean_line.startswith("TRACE_START:"):
+                        trace_lines = []
+                        continue
+                    elif clean_line == "TRACE_END":
+                        if trace_lines is not None:
+                            save_trace(trace_lines)
+                        trace_lines = None
+                        continue
+                    elif trace_lines is not None:
+                        trace_lines.append(clean_line)
+                        continue
 
                     # Add PC timestamp
                     pc_time = datetime.now().strftime("%H:%M:%S")
@@ -0,0 +1,264 @@
+#include "CacheManager.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "CrossPointSettings.h"
+
+namespace {
+constexpr uint8_t CACHE_FILE_VERSION = 1;
+constexpr char CACHE_ROOT[] = "/.crosspoint";
+constexpr char CACHE_FILE[] = "/.crosspoint/cache.bin";
+// Kept when a book is trimmed: cheap to keep, and progress can't be rebuilt
+constexpr const char* KEPT_FILES[] = {"book.bin", "progress.bin", "css_rules.cache"};
+
+std::string getDirName(const std::string& cachePath) {
+  const size_t lastSlash = cachePath.find_last_of('/');
+  return lastSlash == std::string::npos ? cachePath : cachePath.substr(lastSlash + 1);
+}
+
+uint32_t measureDir(const std::string& path) {
+  auto dir = Storage.open(path.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return 0;
+  }
+
+  uint32_t total = 0;
+  char name[128];
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    if (file.isDirectory()) {
+      file.getName(name, sizeof(name));
+      file.close();
+      total += measureDir(path + "/" + name);
+    } else {
+      total += file.size();
+      file.close();
+    }
+  }
+  dir.close();
+  return total;
+}
+
+// Removes everything but KEPT_FILES from a book cache directory
+void dropDerivedData(const std::string& path) {
+  auto dir = Storage.open(path.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return;
+  }
+
+  std::vector<std::string> subDirs;
+  std::vector<std::string> files;
+  char name[128];
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    if (file.isDirectory()) {
+      subDirs.emplace_back(name);
+    } else if (std::none_of(std::begin(KEPT_FILES), std::end(KEPT_FILES),
+                            [&name](const char* kept) { return strcmp(name, kept) == 0; })) {
+      files.emplace_back(name);
+    }
+    file.close();
+  }
+  dir.close();
+
+  // Removed after the listing, deleting while iterating skips entries on FAT
+  for (const auto& subDir : subDirs) {
+    Storage.removeDir((path + "/" + subDir).c_str());
+  }
+  for (const auto& file : files) {
+    Storage.remove((path + "/" + file).c_str());
+  }
+}
+
+class ManagerLock {
+ public:
+  explicit ManagerLock(SemaphoreHandle_t mutex) : mutex(mutex) { xSemaphoreTake(mutex, portMAX_DELAY); }
+  ~ManagerLock() { xSemaphoreGive(mutex); }
+
+  ManagerLock(const ManagerLock&) = delete;
+  ManagerLock& operator=(const ManagerLock&) = delete;
+
+ private:
+  SemaphoreHandle_t mutex;
+};
+}  // namespace
+
+CacheManager CacheManager::instance;
+
+CacheManager::CacheManager() { mutex = xSemaphoreCreateMutex(); }
+
+void CacheManager::ensureLoaded() {
+  if (loaded) {
+    return;
+  }
+  loaded = true;
+  if (!loadFromFile()) {
+    scanCacheDirs();
+  }
+}
+
+void CacheManager::onBookOpened(const std::string& cachePath) {
+  ManagerLock lock(mutex);
+  ensureLoaded();
+
+  const std::string dirName = getDirName(cachePath);
+  Entry& entry = getEntry(dirName);
+  entry.lastUse = ++useClock;
+  entry.trimmed = false;
+
+  enforceLimit(dirName);
+  saveToFile();
+}
+
+void CacheManager::onBookClosed(const std::string& cachePath) {
+  // The indexer measures after it lets go of the render lock, keep the walk out of the lock too
+  const uint32_t sizeBytes = measureDir(cachePath);
+
+  ManagerLock lock(mutex);
+  // The indexer can finish a book that wasn't opened since boot
+  ensureLoaded();
+  getEntry(getDirName(cachePath)).sizeBytes = sizeBytes;
+  saveToFile();
+}
+
+void CacheManager::reset() {
+  ManagerLock lock(mutex);
+  entries.clear();
+  useClock = 0;
+  loaded = true;
+  Storage.remove(CACHE_FILE);
+}
+
+CacheManager::Entry& CacheManager::getEntry(const std::string& dirName) {
+  const auto it =
+      std::find_if(entries.begin(), entries.end(), [&dirName](const Entry& entry) { return entry.dirName == dirName; });
+  if (it != entries.end()) {
+    return *it;
+  }
+  entries.push_back({dirName, 0, 0, false});
+  return entries.back();
+}
+
+void CacheManager::enforceLimit(const std::string& keepDirName) {
+  const uint64_t limit = SETTINGS.getCacheLimitBytes();
+  if (limit == 0) {
+    return;
+  }
+
+  uint64_t total = 0;
+  for (const auto& entry : entries) {
+    total += entry.sizeBytes;
+  }
+  if (total <= limit) {
+    return;
+  }
+
+  // Least recently read first
+  std::vector<Entry*> candidates;
+  for (auto& entry : entries) {
+    if (!entry.trimmed && entry.dirName != keepDirName) {
+      candidates.push_back(&entry);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Entry* a, const Entry* b) { return a->lastUse < b->lastUse; });
+
+  for (Entry* entry : candidates) {
+    if (total <= limit) {
+      break;
+    }
+    const std::string path = std::string(CACHE_ROOT) + "/" + entry->dirName;
+    dropDerivedData(path);
+    const uint32_t sizeBytes = measureDir(path);
+    LOG_INF("CAC", "Trimmed %s: %u -> %u bytes", entry->dirName.c_str(), entry->sizeBytes, sizeBytes);
+    total -= entry->sizeBytes - std::min(entry->sizeBytes, sizeBytes);
+    entry->sizeBytes = sizeBytes;
+    entry->trimmed = true;
+  }
+
+  // Directories removed outside the manager (clearing a single book's cache) measure as empty, forget them
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+                               [](const Entry& entry) { return entry.trimmed && entry.sizeBytes == 0; }),
+                entries.end());
+  if (total > limit) {
+    LOG_INF("CAC", "Caches still over the limit after trimming: %llu bytes", static_cast<unsigned long long>(total));
+  }
+}
+
+void CacheManager::scanCacheDirs() {
+  // First run, or the list was lost: pick up the caches already on the card, all older than the current book
+  auto root = Storage.open(CACHE_ROOT);
+  if (!root || !root.isDirectory()) {
+    if (root) root.close();
+    return;
+  }
+
+  char name[128];
+  for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
+    file.getName(name, sizeof(name));
+    const bool isBookCache = file.isDirectory() && strncmp(name, "epub_", 5) == 0;
+    file.close();
+    if (isBookCache) {
+      getEntry(name).sizeBytes = measureDir(std::string(CACHE_ROOT) + "/" + name);
+    }
+  }
+  root.close();
+  LOG_DBG("CAC", "Found %u book caches", static_cast<unsigned>(entries.size()));
+}
+
+bool CacheManager::saveToFile() const {
+  FsFile file;
+  if (!Storage.openFileForWrite("CAC", CACHE_FILE, file)) {
+    return false;
+  }
+  serialization::writePod(file, CACHE_FILE_VERSION);
+  serialization::writePod(file, useClock);
+  serialization::writePod(file, static_cast<uint16_t>(entries.size()));
+  for (const auto& entry : entries) {
+    serialization::writeString(file, entry.dirName);
+    serialization::writePod(file, entry.lastUse);
+    serialization::writePod(file, entry.sizeBytes);
+    serialization::writePod(file, static_cast<uint8_t>(entry.trimmed));
+  }
+  file.close();
+  return true;
+}
+
+bool CacheManager::loadFromFile() {
+  FsFile file;
+  if (!Storage.openFileForRead("CAC", CACHE_FILE, file)) {
+    return false;
+  }
+
+  uint8_t version;
+  serialization::readPod(file, version);
+  if (version != CACHE_FILE_VERSION) {
+    LOG_ERR("CAC", "Unknown cache list version %u, rescanning", version);
+    file.close();
+    return false;
+  }
+
+  uint16_t count;
+  serialization::readPod(file, useClock);
+  serialization::readPod(file, count);
+  entries.clear();
+  entries.reserve(count);
+  for (uint16_t i = 0; i < count; i++) {
+    Entry entry;
+    uint8_t trimmed;
+    serialization::readString(file, entry.dirName);
+    serialization::readPod(file, entry.lastUse);
+    serialization::readPod(file, entry.sizeBytes);
+    serialization::readPod(file, trimmed);
+    entry.trimmed = trimmed != 0;
+    entries.push_back(std::move(entry));
+  }
+  file.close();
+  return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Keeps the EPUB caches under /.crosspoint within the size limit set in the settings.
+
+Each book cache directory is tracked with its size, measured when the book is closed, and the order books were last
+opened in (/.crosspoint/cache.bin). When a book is opened and the caches are over the limit, the derived data of the
+least recently read books (section files, extracted images and their pixel caches, covers and thumbnails) is dropped
+until they fit. book.bin, the CSS rules and progress.bin are kept, so a trimmed book reopens at the same place and
+only rebuilds its sections.
+
+Called from the UI and from the book indexer task; the list is guarded by its own mutex, and directories are measured
+outside it.
+*/
+class CacheManager {
+  // Static instance
+  static CacheManager instance;
+
+  struct Entry {
+    std::string dirName;  // e.g. epub_1234, relative to /.crosspoint
+    uint32_t lastUse = 0;
+    uint32_t sizeBytes = 0;
+    bool trimmed = false;  // derived data dropped since the book was last opened
+  };
+
+  std::vector<Entry> entries;
+  uint32_t useClock = 0;
+  bool loaded = false;
+  SemaphoreHandle_t mutex = nullptr;  // Protect entries, useClock and cache.bin
+
+  CacheManager();
+
+  // Reads cache.bin, or scans the card when it's missing, the first time the list is needed
+  void ensureLoaded();
+  bool loadFromFile();
+  bool saveToFile() const;
+  void scanCacheDirs();
+  Entry& getEntry(const std::string& dirName);
+  void enforceLimit(const std::string& keepDirName);
+
+ public:
+  ~CacheManager() = default;
+
+  // Get singleton instance
+  static CacheManager& getInstance() { return instance; }
+
+  // Marks the book as the most recently read one, then trims other books until the caches fit the limit
+  void onBookOpened(const std::string& cachePath);
+  // Measures the cache of a book after reading, when it has grown with the sections built
+  void onBookClosed(const std::string& cachePath);
+  // Forgets every book, after the caches were cleared
+  void reset();
+};
+
+// Helper macro to access cache manager
+#define CACHE_MANAGER CacheManager::getInstance()
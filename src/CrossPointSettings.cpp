@@ -293,6 +293,22 @@ int CrossPointSettings::getRefreshFrequency() const {
   }
 }
 
+uint32_t CrossPointSettings::getCacheLimitBytes() const {
+  switch (cacheLimit) {
+    case CACHE_100_MB:
+      return 100UL * 1024 * 1024;
+    case CACHE_250_MB:
+      return 250UL * 1024 * 1024;
+    case CACHE_500_MB:
+    default:
+      return 500UL * 1024 * 1024;
+    case CACHE_1_GB:
+      return 1024UL * 1024 * 1024;
+    case CACHE_UNLIMITED:
+      return 0;
+  }
+}
+
 int CrossPointSettings::getReaderFontId() const {
   switch (fontFamily) {
     case BOOKERLY:
@@ -137,6 +137,16 @@ class CrossPointSettings {
   // Image rendering in EPUB reader
   enum IMAGE_RENDERING { IMAGES_DISPLAY = 0, IMAGES_PLACEHOLDER = 1, IMAGES_SUPPRESS = 2, IMAGE_RENDERING_COUNT };
 
+  // Size limit of the reading caches on the SD card
+  enum CACHE_LIMIT {
+    CACHE_100_MB = 0,
+    CACHE_250_MB = 1,
+    CACHE_500_MB = 2,
+    CACHE_1_GB = 3,
+    CACHE_UNLIMITED = 4,
+    CACHE_LIMIT_COUNT
+  };
+
   // Sleep screen settings
   uint8_t sleepScreen = DARK;
   // Sleep screen cover mode settings
@@ -199,6 +209,8 @@ class CrossPointSettings {
   uint8_t showHiddenFiles = 0;
   // Image rendering mode in EPUB reader
   uint8_t imageRendering = IMAGES_DISPLAY;
+  // Reading cache size limit, least recently read books are trimmed past it
+  uint8_t cacheLimit = CACHE_500_MB;
 
   ~CrossPointSettings() = default;
 
@@ -225,6 +237,8 @@ class CrossPointSettings {
   float getReaderLineCompression() const;
   unsigned long getSleepTimeoutMs() const;
   int getRefreshFrequency() const;
+  // 0 when unlimited
+  uint32_t getCacheLimitBytes() const;
 };
 
 // Helper macro to access settings
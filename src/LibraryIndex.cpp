@@ -0,0 +1,717 @@
+#include "LibraryIndex.h"
+
+#include <Epub.h>
+#include <FsHelpers.h>
+#include <Logging.h>
+#include <Serialization.h>
+#include <ZipFile.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+constexpr uint8_t LIBRARY_FILE_VERSION = 1;
+constexpr size_t HEADER_SIZE = 4;  // version u8, reserved u8, record count u16
+constexpr char LIBRARY_DIR[] = "/.crosspoint/library";
+constexpr char BOOKS_FILE[] = "/.crosspoint/library/books.bin";
+constexpr char PATH_INDEX_FILE[] = "/.crosspoint/library/path.idx";
+constexpr char TITLE_INDEX_FILE[] = "/.crosspoint/library/title.idx";
+constexpr char AUTHOR_INDEX_FILE[] = "/.crosspoint/library/author.idx";
+constexpr uint16_t MAX_RECORDS = 0xFFFF;
+
+constexpr uint8_t FLAG_DELETED = 1 << 0;
+constexpr uint8_t FLAG_HAS_THUMB = 1 << 1;
+constexpr uint8_t FLAG_NAME_TITLE = 1 << 2;  // title taken from the file name, follows renames
+
+using Record = LibraryIndex::Record;
+using Format = LibraryIndex::Format;
+
+// FNV-1a, stable across builds unlike std::hash
+uint64_t hashPath(const std::string& path) { return ZipFile::fnvHash64(path.c_str(), path.size()); }
+
+// Copies into a fixed-size field, cut on a UTF-8 character boundary
+void copyField(char* field, const size_t fieldSize, const std::string& value) {
+  size_t len = std::min(value.size(), fieldSize - 1);
+  if (len < value.size()) {
+    while (len > 0 && (static_cast<uint8_t>(value[len]) & 0xC0) == 0x80) len--;
+  }
+  memcpy(field, value.data(), len);
+  memset(field + len, 0, fieldSize - len);
+}
+
+std::string readField(const char* field, const size_t fieldSize) { return {field, strnlen(field, fieldSize)}; }
+
+Format getFormat(const std::string& path) {
+  if (FsHelpers::hasEpubExtension(path)) return Format::Epub;
+  if (FsHelpers::hasXtcExtension(path)) return Format::Xtc;
+  if (FsHelpers::hasTxtExtension(path)) return Format::Txt;
+  if (FsHelpers::hasMarkdownExtension(path)) return Format::Markdown;
+  return Format::Unknown;
+}
+
+std::string titleFromName(const std::string& path) {
+  const size_t lastSlash = path.find_last_of('/');
+  std::string name = lastSlash == std::string::npos ? path : path.substr(lastSlash + 1);
+  const size_t lastDot = name.find_last_of('.');
+  if (lastDot != std::string::npos && lastDot > 0) {
+    name.resize(lastDot);
+  }
+  return name;
+}
+
+int compareText(const char* a, const char* b) {
+  while (*a && *b) {
+    const int ca = tolower(static_cast<unsigned char>(*a));
+    const int cb = tolower(static_cast<unsigned char>(*b));
+    if (ca != cb) return ca - cb;
+    a++;
+    b++;
+  }
+  return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
+
+// Every order ends on the path, so each record has exactly one place in it
+bool pathLess(const Record& a, const Record& b) {
+  if (a.pathHash != b.pathHash) return a.pathHash < b.pathHash;
+  return strcmp(a.path, b.path) < 0;
+}
+
+bool titleLess(const Record& a, const Record& b) {
+  const int order = compareText(a.title, b.title);
+  if (order != 0) return order < 0;
+  return strcmp(a.path, b.path) < 0;
+}
+
+bool authorLess(const Record& a, const Record& b) {
+  // Books without an author go last
+  const bool noAuthorA = a.author[0] == '\0';
+  const bool noAuthorB = b.author[0] == '\0';
+  if (noAuthorA != noAuthorB) return noAuthorB;
+  const int order = compareText(a.author, b.author);
+  if (order != 0) return order < 0;
+  return titleLess(a, b);
+}
+
+// Sort keys: the start of a record's place in an order, in a form memcmp() orders the same way as the comparators
+// above. Copies lowercased text like compareText(), then a NUL so a shorter text sorts first.
+size_t putText(uint8_t* key, size_t pos, const size_t size, const char* text) {
+  for (; *text && pos < size; text++) {
+    key[pos++] = static_cast<uint8_t>(tolower(static_cast<unsigned char>(*text)));
+  }
+  if (pos < size) key[pos++] = 0;
+  return pos;
+}
+
+// Paths compare with strcmp(), as is
+size_t putPath(uint8_t* key, size_t pos, const size_t size, const char* path) {
+  for (; *path && pos < size; path++) {
+    key[pos++] = static_cast<uint8_t>(*path);
+  }
+  return pos;
+}
+
+void pathKey(const Record& record, uint8_t* key, const size_t size) {
+  size_t pos = 0;
+  for (int shift = 56; shift >= 0 && pos < size; shift -= 8) {
+    key[pos++] = static_cast<uint8_t>(record.pathHash >> shift);
+  }
+  putPath(key, pos, size, record.path);
+}
+
+void titleKey(const Record& record, uint8_t* key, const size_t size) {
+  putPath(key, putText(key, 0, size, record.title), size, record.path);
+}
+
+void authorKey(const Record& record, uint8_t* key, const size_t size) {
+  size_t pos = 0;
+  if (record.author[0] == '\0') {
+    key[pos++] = 0xFF;  // Last, no lowercased UTF-8 byte is 0xFF
+  } else {
+    pos = putText(key, pos, size, record.author);
+  }
+  titleKey(record, key + pos, size - pos);
+}
+
+struct SortKey {
+  uint16_t recordNo;
+  uint8_t key[14];
+};
+
+bool readIndex(const char* path, std::vector<uint16_t>& index) {
+  FsFile file;
+  if (!Storage.openFileForRead("LIB", path, file)) {
+    return false;
+  }
+  index.resize(file.size() / sizeof(uint16_t));
+  const size_t bytes = index.size() * sizeof(uint16_t);
+  const bool ok = file.read(reinterpret_cast<uint8_t*>(index.data()), bytes) == static_cast<int>(bytes);
+  file.close();
+  return ok;
+}
+
+bool writeIndex(const char* path, const std::vector<uint16_t>& index) {
+  FsFile file;
+  if (!Storage.openFileForWrite("LIB", path, file)) {
+    return false;
+  }
+  file.write(reinterpret_cast<const uint8_t*>(index.data()), index.size() * sizeof(uint16_t));
+  file.close();
+  return true;
+}
+}  // namespace
+
+LibraryIndex LibraryIndex::instance;
+
+bool LibraryIndex::exists() const { return Storage.exists(TITLE_INDEX_FILE); }
+
+bool LibraryIndex::readRecord(FsFile& file, const uint16_t recordNo, Record& record) {
+  file.seek(HEADER_SIZE + static_cast<size_t>(recordNo) * sizeof(Record));
+  return file.read(reinterpret_cast<uint8_t*>(&record), sizeof(Record)) == static_cast<int>(sizeof(Record));
+}
+
+bool LibraryIndex::writeRecord(const uint16_t recordNo, const Record& record) {
+  dirty = true;
+  booksFile.seek(HEADER_SIZE + static_cast<size_t>(recordNo) * sizeof(Record));
+  return booksFile.write(reinterpret_cast<const uint8_t*>(&record), sizeof(Record)) == sizeof(Record);
+}
+
+bool LibraryIndex::beginEdit() {
+  if (editDepth++ > 0) {
+    return true;
+  }
+
+  Storage.mkdir(LIBRARY_DIR);
+  booksFile = Storage.open(BOOKS_FILE, O_RDWR | O_CREAT);
+  if (!booksFile) {
+    LOG_ERR("LIB", "Failed to open %s", BOOKS_FILE);
+    editDepth = 0;
+    return false;
+  }
+
+  uint8_t version = 0;
+  recordCount = 0;
+  if (booksFile.size() >= HEADER_SIZE) {
+    uint8_t reserved;
+    serialization::readPod(booksFile, version);
+    serialization::readPod(booksFile, reserved);
+    serialization::readPod(booksFile, recordCount);
+  }
+  if (version != LIBRARY_FILE_VERSION) {
+    // New card, or a library from another firmware version: start over
+    recordCount = 0;
+    byPath.clear();
+    byTitle.clear();
+    byAuthor.clear();
+    dirty = true;
+    return true;
+  }
+
+  const size_t storedRecords = (booksFile.size() - HEADER_SIZE) / sizeof(Record);
+  bool indexesOk = storedRecords >= recordCount && readIndex(PATH_INDEX_FILE, byPath) &&
+                   readIndex(TITLE_INDEX_FILE, byTitle) && readIndex(AUTHOR_INDEX_FILE, byAuthor) &&
+                   byTitle.size() == byPath.size() && byAuthor.size() == byPath.size();
+  if (indexesOk) {
+    indexesOk = std::all_of(byPath.begin(), byPath.end(), [this](const uint16_t n) { return n < recordCount; });
+  }
+  if (!indexesOk) {
+    // Interrupted while saving: the records are written first, the orders can be rebuilt from them
+    LOG_ERR("LIB", "Library indexes damaged, rebuilding");
+    recordCount = std::min(static_cast<size_t>(recordCount), storedRecords);
+    rebuildIndexes();
+  }
+  return true;
+}
+
+void LibraryIndex::endEdit() {
+  if (--editDepth > 0) {
+    return;
+  }
+
+  if (dirty) {
+    booksFile.seek(0);
+    serialization::writePod(booksFile, LIBRARY_FILE_VERSION);
+    serialization::writePod(booksFile, static_cast<uint8_t>(0));
+    serialization::writePod(booksFile, recordCount);
+  }
+  booksFile.close();
+  if (dirty) {
+    writeIndex(PATH_INDEX_FILE, byPath);
+    writeIndex(AUTHOR_INDEX_FILE, byAuthor);
+    // Last, exists() checks for it
+    writeIndex(TITLE_INDEX_FILE, byTitle);
+    dirty = false;
+  }
+
+  std::vector<uint16_t>().swap(byPath);
+  std::vector<uint16_t>().swap(byTitle);
+  std::vector<uint16_t>().swap(byAuthor);
+}
+
+void LibraryIndex::rebuildIndexes() {
+  byPath.clear();
+  Record record;
+  for (uint16_t n = 0; n < recordCount; n++) {
+    if (readRecord(n, record) && !(record.flags & FLAG_DELETED)) {
+      byPath.push_back(n);
+    }
+  }
+  sortIndexes();
+}
+
+void LibraryIndex::sortIndex(std::vector<uint16_t>& index, void (*makeKey)(const Record&, uint8_t*, size_t),
+                             bool (*less)(const Record&, const Record&)) {
+  // One pass over books.bin front to back for the keys, then a sort in memory. Only records whose keys tie are read
+  // again, instead of two for every comparison.
+  std::sort(index.begin(), index.end());
+  std::vector<SortKey> keys(index.size());
+  Record record;
+  for (size_t i = 0; i < index.size(); i++) {
+    keys[i].recordNo = index[i];
+    memset(keys[i].key, 0, sizeof(keys[i].key));
+    if (readRecord(index[i], record)) {
+      makeKey(record, keys[i].key, sizeof(keys[i].key));
+    }
+  }
+
+  Record a;
+  Record b;
+  std::sort(keys.begin(), keys.end(), [&](const SortKey& x, const SortKey& y) {
+    const int order = memcmp(x.key, y.key, sizeof(x.key));
+    if (order != 0) return order < 0;
+    return x.recordNo != y.recordNo && readRecord(x.recordNo, a) && readRecord(y.recordNo, b) && less(a, b);
+  });
+  for (size_t i = 0; i < keys.size(); i++) {
+    index[i] = keys[i].recordNo;
+  }
+}
+
+void LibraryIndex::sortIndexes() {
+  // byPath holds every live record, in any order
+  byTitle = byPath;
+  byAuthor = byPath;
+  sortIndex(byPath, pathKey, pathLess);
+  sortIndex(byTitle, titleKey, titleLess);
+  sortIndex(byAuthor, authorKey, authorLess);
+  dirty = true;
+}
+
+int LibraryIndex::findRecord(const std::string& path) {
+  if (path.size() >= PATH_SIZE) {
+    return -1;
+  }
+  Record key = {};
+  key.pathHash = hashPath(path);
+  copyField(key.path, PATH_SIZE, path);
+
+  Record record;
+  if (scanning) {
+    // Hashes are in memory, only records with the same hash are read
+    auto it = std::lower_bound(byPath.begin(), byPath.end(), key.pathHash,
+                               [this](const uint16_t n, const uint64_t hash) { return scanHashes[n] < hash; });
+    for (; it != byPath.end() && scanHashes[*it] == key.pathHash; ++it) {
+      if (readRecord(*it, record) && strcmp(record.path, key.path) == 0) {
+        return *it;
+      }
+    }
+    return -1;
+  }
+
+  auto it = std::lower_bound(byPath.begin(), byPath.end(), key, [&](const uint16_t n, const Record& k) {
+    return readRecord(n, record) && pathLess(record, k);
+  });
+  for (; it != byPath.end(); ++it) {
+    if (!readRecord(*it, record) || record.pathHash != key.pathHash) {
+      break;
+    }
+    if (strcmp(record.path, key.path) == 0) {
+      return *it;
+    }
+  }
+  return -1;
+}
+
+void LibraryIndex::insertRecord(const uint16_t recordNo, const Record& record) {
+  // Binary search reading the records compared against, the orders only hold record numbers
+  Record other;
+  const auto insertSorted = [&](std::vector<uint16_t>& index, bool (*less)(const Record&, const Record&)) {
+    const auto it = std::lower_bound(index.begin(), index.end(), record, [&](const uint16_t n, const Record& key) {
+      return readRecord(n, other) && less(other, key);
+    });
+    index.insert(it, recordNo);
+  };
+  insertSorted(byPath, pathLess);
+  insertSorted(byTitle, titleLess);
+  insertSorted(byAuthor, authorLess);
+  dirty = true;
+}
+
+void LibraryIndex::removeFromIndexes(const uint16_t recordNo) {
+  for (auto* index : {&byPath, &byTitle, &byAuthor}) {
+    const auto it = std::find(index->begin(), index->end(), recordNo);
+    if (it != index->end()) {
+      index->erase(it);
+    }
+  }
+  dirty = true;
+}
+
+int LibraryIndex::allocateRecord() {
+  if (byPath.size() + scanAdded.size() < recordCount) {
+    // Reuse the slot of a deleted book
+    std::vector<bool> used(recordCount, false);
+    for (const uint16_t n : byPath) {
+      used[n] = true;
+    }
+    for (const uint16_t n : scanAdded) {
+      used[n] = true;
+    }
+    const auto it = std::find(used.begin(), used.end(), false);
+    return static_cast<int>(it - used.begin());
+  }
+  if (recordCount == MAX_RECORDS) {
+    return -1;
+  }
+  return recordCount++;
+}
+
+int LibraryIndex::addRecord(const std::string& path, const uint32_t fileSize) {
+  if (path.size() >= PATH_SIZE) {
+    LOG_DBG("LIB", "Path too long for the library: %s", path.c_str());
+    return -1;
+  }
+
+  Record record = {};
+  record.pathHash = hashPath(path);
+  record.fileSize = fileSize;
+  record.format = static_cast<uint8_t>(getFormat(path));
+  record.progress = UNKNOWN_PROGRESS;
+  copyField(record.path, PATH_SIZE, path);
+
+  // Metadata of books already opened once; others are named after the file until they are opened
+  std::string title;
+  if (record.format == static_cast<uint8_t>(Format::Epub)) {
+    Epub epub(path, "/.crosspoint");
+    if (Storage.exists(epub.getCachePath().c_str()) && epub.load(false, true)) {
+      title = epub.getTitle();
+      copyField(record.author, AUTHOR_SIZE, epub.getAuthor());
+      if (Storage.exists(epub.getCoverBmpPath().c_str())) {
+        record.flags |= FLAG_HAS_THUMB;
+      }
+    }
+  }
+  if (title.empty()) {
+    title = titleFromName(path);
+    record.flags |= FLAG_NAME_TITLE;
+  }
+  copyField(record.title, TITLE_SIZE, title);
+
+  const int recordNo = allocateRecord();
+  if (recordNo < 0) {
+    LOG_ERR("LIB", "Library full, not adding %s", path.c_str());
+    return -1;
+  }
+  writeRecord(recordNo, record);
+  if (scanning) {
+    scanAdded.push_back(recordNo);
+  } else {
+    insertRecord(recordNo, record);
+  }
+  return recordNo;
+}
+
+void LibraryIndex::deleteRecord(const uint16_t recordNo) {
+  Record record;
+  if (readRecord(recordNo, record)) {
+    record.flags |= FLAG_DELETED;
+    writeRecord(recordNo, record);
+  }
+  removeFromIndexes(recordNo);
+}
+
+void LibraryIndex::moveRecord(const uint16_t recordNo, const std::string& toPath) {
+  Record record;
+  if (!readRecord(recordNo, record)) {
+    return;
+  }
+  removeFromIndexes(recordNo);
+  if (getFormat(toPath) == Format::Unknown || toPath.size() >= PATH_SIZE) {
+    record.flags |= FLAG_DELETED;
+    writeRecord(recordNo, record);
+    return;
+  }
+
+  // Replaced an existing file
+  const int existing = findRecord(toPath);
+  if (existing >= 0) {
+    deleteRecord(existing);
+  }
+
+  record.pathHash = hashPath(toPath);
+  copyField(record.path, PATH_SIZE, toPath);
+  if (record.flags & FLAG_NAME_TITLE) {
+    copyField(record.title, TITLE_SIZE, titleFromName(toPath));
+  }
+  writeRecord(recordNo, record);
+  insertRecord(recordNo, record);
+}
+
+void LibraryIndex::scanDir(const std::string& path, std::vector<bool>& seen) {
+  auto dir = Storage.open(path.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return;
+  }
+
+  std::vector<std::string> subDirs;
+  char name[256];
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    if (name[0] == '.' || strcmp(name, "System Volume Information") == 0) {
+      file.close();
+      continue;
+    }
+
+    const std::string filePath = (path == "/" ? path : path + "/") + name;
+    if (file.isDirectory()) {
+      subDirs.push_back(filePath);
+      file.close();
+      continue;
+    }
+    const uint32_t fileSize = file.size();
+    file.close();
+    if (getFormat(filePath) == Format::Unknown) {
+      continue;
+    }
+
+    int recordNo = findRecord(filePath);
+    Record record;
+    if (recordNo < 0) {
+      recordNo = addRecord(filePath, fileSize);
+    } else if (readRecord(recordNo, record) && record.fileSize != fileSize) {
+      record.fileSize = fileSize;
+      writeRecord(recordNo, record);
+    }
+    if (recordNo >= 0) {
+      if (static_cast<size_t>(recordNo) >= seen.size()) seen.resize(recordNo + 1, false);
+      seen[recordNo] = true;
+    }
+  }
+  dir.close();
+
+  for (const auto& subDir : subDirs) {
+    scanDir(subDir, seen);
+  }
+}
+
+void LibraryIndex::scan() {
+  if (!beginEdit()) {
+    return;
+  }
+
+  const unsigned long startTime = millis();
+  // Path hashes of the books already indexed, read front to back. The hash is the first field of a record.
+  scanning = true;
+  scanHashes.assign(recordCount, 0);
+  std::vector<uint16_t> live = byPath;
+  std::sort(live.begin(), live.end());
+  for (const uint16_t n : live) {
+    booksFile.seek(HEADER_SIZE + static_cast<size_t>(n) * sizeof(Record));
+    booksFile.read(reinterpret_cast<uint8_t*>(&scanHashes[n]), sizeof(uint64_t));
+  }
+
+  std::vector<bool> seen(recordCount, false);
+  scanDir("/", seen);
+
+  // Books no longer on the card
+  for (const uint16_t n : live) {
+    if (n >= seen.size() || !seen[n]) {
+      deleteRecord(n);
+    }
+  }
+
+  // New books go into the orders in one sort, instead of a binary search over the card for each
+  if (!scanAdded.empty()) {
+    byPath.insert(byPath.end(), scanAdded.begin(), scanAdded.end());
+    sortIndexes();
+  }
+  scanning = false;
+  std::vector<uint64_t>().swap(scanHashes);
+  std::vector<uint16_t>().swap(scanAdded);
+  dirty = true;
+
+  LOG_INF("LIB", "Library scanned in %lu ms, %u books", millis() - startTime, static_cast<unsigned>(byPath.size()));
+  endEdit();
+}
+
+void LibraryIndex::addFile(const std::string& path) {
+  if (getFormat(path) == Format::Unknown || !exists() || !beginEdit()) {
+    return;
+  }
+
+  auto file = Storage.open(path.c_str());
+  const uint32_t fileSize = file ? file.size() : 0;
+  if (file) file.close();
+
+  // An overwritten book starts over: its metadata and progress were for the old file
+  const int recordNo = findRecord(path);
+  if (recordNo >= 0) {
+    deleteRecord(recordNo);
+  }
+  addRecord(path, fileSize);
+  endEdit();
+}
+
+void LibraryIndex::removeFile(const std::string& path) {
+  if (!exists() || !beginEdit()) {
+    return;
+  }
+  const int recordNo = findRecord(path);
+  if (recordNo >= 0) {
+    deleteRecord(recordNo);
+  }
+  endEdit();
+}
+
+void LibraryIndex::removeDir(const std::string& path) {
+  if (!exists() || !beginEdit()) {
+    return;
+  }
+  // Only empty directories are deleted, but books removed outside the device since the last scan can still be listed
+  const std::string prefix = path.back() == '/' ? path : path + "/";
+  const std::vector<uint16_t> live = byPath;
+  Record record;
+  for (const uint16_t n : live) {
+    if (readRecord(n, record) && strncmp(record.path, prefix.c_str(), prefix.size()) == 0) {
+      deleteRecord(n);
+    }
+  }
+  endEdit();
+}
+
+void LibraryIndex::moveFile(const std::string& fromPath, const std::string& toPath) {
+  if (!exists() || !beginEdit()) {
+    return;
+  }
+
+  const int recordNo = findRecord(fromPath);
+  if (recordNo >= 0) {
+    moveRecord(recordNo, toPath);
+    endEdit();
+    return;
+  }
+
+  auto target = Storage.open(toPath.c_str());
+  const bool isDirectory = target && target.isDirectory();
+  if (target) target.close();
+
+  if (isDirectory) {
+    // Every book below the directory moves with it
+    const std::string prefix = fromPath + "/";
+    const std::vector<uint16_t> live = byPath;
+    Record record;
+    for (const uint16_t n : live) {
+      if (readRecord(n, record) && strncmp(record.path, prefix.c_str(), prefix.size()) == 0) {
+        moveRecord(n, toPath + "/" + (record.path + prefix.size()));
+      }
+    }
+  } else {
+    // Not indexed before, e.g. renamed from another extension
+    endEdit();
+    addFile(toPath);
+    return;
+  }
+  endEdit();
+}
+
+void LibraryIndex::updateBook(const std::string& path, const std::string& title, const std::string& author,
+                              const bool hasThumb) {
+  if (!exists() || !beginEdit()) {
+    return;
+  }
+
+  int recordNo = findRecord(path);
+  if (recordNo < 0) {
+    // Copied to the card outside the device since the last scan
+    auto file = Storage.open(path.c_str());
+    const uint32_t fileSize = file ? file.size() : 0;
+    if (file) file.close();
+    recordNo = addRecord(path, fileSize);
+  }
+
+  Record record;
+  if (recordNo >= 0 && readRecord(recordNo, record)) {
+    Record updated = record;
+    if (!title.empty()) {
+      copyField(updated.title, TITLE_SIZE, title);
+      updated.flags &= ~FLAG_NAME_TITLE;
+    }
+    copyField(updated.author, AUTHOR_SIZE, author);
+    if (hasThumb) {
+      updated.flags |= FLAG_HAS_THUMB;
+    } else {
+      updated.flags &= ~FLAG_HAS_THUMB;
+    }
+    if (memcmp(&updated, &record, sizeof(Record)) != 0) {
+      removeFromIndexes(recordNo);
+      writeRecord(recordNo, updated);
+      insertRecord(recordNo, updated);
+    }
+  }
+  endEdit();
+}
+
+void LibraryIndex::setProgress(const std::string& path, const uint8_t percent) {
+  if (!exists() || !beginEdit()) {
+    return;
+  }
+  const int recordNo = findRecord(path);
+  Record record;
+  if (recordNo >= 0 && readRecord(recordNo, record) && record.progress != percent) {
+    record.progress = percent;
+    writeRecord(recordNo, record);
+  }
+  endEdit();
+}
+
+int LibraryIndex::getCount() const {
+  FsFile file;
+  if (!Storage.openFileForRead("LIB", TITLE_INDEX_FILE, file)) {
+    return 0;
+  }
+  const int count = static_cast<int>(file.size() / sizeof(uint16_t));
+  file.close();
+  return count;
+}
+
+int LibraryIndex::readPage(const Order order, const int first, const int count, std::vector<Book>& books) const {
+  books.clear();
+  FsFile indexFile;
+  FsFile file;
+  if (!Storage.openFileForRead("LIB", order == Order::Title ? TITLE_INDEX_FILE : AUTHOR_INDEX_FILE, indexFile)) {
+    return 0;
+  }
+  if (!Storage.openFileForRead("LIB", BOOKS_FILE, file)) {
+    indexFile.close();
+    return 0;
+  }
+
+  std::vector<uint16_t> recordNos(count);
+  indexFile.seek(static_cast<size_t>(first) * sizeof(uint16_t));
+  const int bytesRead = indexFile.read(reinterpret_cast<uint8_t*>(recordNos.data()), count * sizeof(uint16_t));
+  indexFile.close();
+  recordNos.resize(std::max(bytesRead, 0) / sizeof(uint16_t));
+
+  books.reserve(recordNos.size());
+  Record record;
+  for (const uint16_t n : recordNos) {
+    if (!readRecord(file, n, record)) {
+      break;
+    }
+    books.push_back({readField(record.path, PATH_SIZE), readField(record.title, TITLE_SIZE),
+                     readField(record.author, AUTHOR_SIZE), static_cast<Format>(record.format), record.fileSize,
+                     record.progress, (record.flags & FLAG_HAS_THUMB) != 0});
+  }
+  file.close();
+  return static_cast<int>(books.size());
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <HalStorage.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Library database on the SD card, so large collections can be browsed by title or author without listing directories
+or opening books.
+
+Every book file on the card has one fixed-size record in /.crosspoint/library/books.bin (path hash, path, title,
+author, format, file size, reading progress and whether a cover was rendered). Records are kept in order by three
+index files of record numbers: by path hash for lookups, by title and by author for browsing. A page of the library
+is a seek into an order file plus one record read per row.
+
+The index is built by a full scan of the card the first time it's browsed (or on request), then kept up to date as
+books are uploaded, moved or deleted through the web server, WebDAV or the file browser, and as books are read. Titles
+and authors come from the book caches when present, otherwise from the file name until the book is first opened.
+*/
+class LibraryIndex {
+ public:
+  enum class Order : uint8_t { Title, Author };
+  enum class Format : uint8_t { Unknown, Epub, Xtc, Txt, Markdown };
+  static constexpr uint8_t UNKNOWN_PROGRESS = 0xFF;
+
+  struct Book {
+    std::string path;
+    std::string title;
+    std::string author;
+    Format format = Format::Unknown;
+    uint32_t fileSize = 0;
+    uint8_t progress = UNKNOWN_PROGRESS;  // percent
+    bool hasThumb = false;
+  };
+
+  static constexpr size_t PATH_SIZE = 192;
+  static constexpr size_t TITLE_SIZE = 72;
+  static constexpr size_t AUTHOR_SIZE = 40;
+
+  // On-disk record, written as is
+  struct Record {
+    uint64_t pathHash;
+    uint32_t fileSize;
+    uint8_t format;
+    uint8_t progress;
+    uint8_t flags;
+    uint8_t reserved;
+    char path[PATH_SIZE];
+    char title[TITLE_SIZE];
+    char author[AUTHOR_SIZE];
+  };
+  static_assert(sizeof(Record) == 320, "Library records are fixed size");
+
+ private:
+  // Static instance
+  static LibraryIndex instance;
+
+  // Loaded while editing, released after
+  FsFile booksFile;
+  uint16_t recordCount = 0;
+  std::vector<uint16_t> byPath;
+  std::vector<uint16_t> byTitle;
+  std::vector<uint16_t> byAuthor;
+  int editDepth = 0;
+  bool dirty = false;
+  // While scanning: path hash per record number, for lookups without reading records, and the records added, sorted
+  // into the orders once the scan is done
+  bool scanning = false;
+  std::vector<uint64_t> scanHashes;
+  std::vector<uint16_t> scanAdded;
+
+  bool beginEdit();
+  void endEdit();
+  void rebuildIndexes();
+  void sortIndex(std::vector<uint16_t>& index, void (*makeKey)(const Record&, uint8_t*, size_t),
+                 bool (*less)(const Record&, const Record&));
+  void sortIndexes();
+  static bool readRecord(FsFile& file, uint16_t recordNo, Record& record);
+  bool readRecord(uint16_t recordNo, Record& record) { return readRecord(booksFile, recordNo, record); }
+  bool writeRecord(uint16_t recordNo, const Record& record);
+  int findRecord(const std::string& path);
+  void insertRecord(uint16_t recordNo, const Record& record);
+  void removeFromIndexes(uint16_t recordNo);
+  int allocateRecord();
+  int addRecord(const std::string& path, uint32_t fileSize);
+  void deleteRecord(uint16_t recordNo);
+  void moveRecord(uint16_t recordNo, const std::string& toPath);
+  void scanDir(const std::string& path, std::vector<bool>& seen);
+
+ public:
+  ~LibraryIndex() = default;
+
+  // Get singleton instance
+  static LibraryIndex& getInstance() { return instance; }
+
+  // True once the card was scanned
+  bool exists() const;
+  // Scans the whole card: adds new books, drops the ones that are gone and picks up size changes
+  void scan();
+
+  // A file was written (upload, copy); non-book files are ignored
+  void addFile(const std::string& path);
+  // A file was deleted
+  void removeFile(const std::string& path);
+  // A directory was deleted
+  void removeDir(const std::string& path);
+  // A file or directory was renamed or moved
+  void moveFile(const std::string& fromPath, const std::string& toPath);
+  // Metadata read from an opened book
+  void updateBook(const std::string& path, const std::string& title, const std::string& author, bool hasThumb);
+  void setProgress(const std::string& path, uint8_t percent);
+
+  int getCount() const;
+  // Reads up to count books starting at position first in the given order, returns the number read
+  int readPage(Order order, int first, int count, std::vector<Book>& books) const;
+};
+
+// Helper macro to access the library index
+#define LIBRARY_INDEX LibraryIndex::getInstance()
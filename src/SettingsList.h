@@ -78,6 +78,10 @@ inline const std::vector<SettingInfo>& getSettingsList() {
       SettingInfo::Enum(StrId::STR_TIME_TO_SLEEP, &CrossPointSettings::sleepTimeout,
                         {StrId::STR_MIN_1, StrId::STR_MIN_5, StrId::STR_MIN_10, StrId::STR_MIN_15, StrId::STR_MIN_30},
                         "sleepTimeout", StrId::STR_CAT_SYSTEM),
+      SettingInfo::Enum(
+          StrId::STR_CACHE_LIMIT, &CrossPointSettings::cacheLimit,
+          {StrId::STR_MB_100, StrId::STR_MB_250, StrId::STR_MB_500, StrId::STR_GB_1, StrId::STR_UNLIMITED},
+          "cacheLimit", StrId::STR_CAT_SYSTEM),
 
       // --- KOReader Sync (web-only, uses KOReaderCredentialStore) ---
       SettingInfo::DynamicString(
@@ -1,8 +1,13 @@
 #include "Activity.h"
 
+#include <AllocTracker.h>
+
 #include "ActivityManager.h"
 
-void Activity::onEnter() { LOG_DBG("ACT", "Entering activity: %s", name.c_str()); }
+void Activity::onEnter() {
+  LOG_DBG("ACT", "Entering activity: %s", name.c_str());
+  ALLOC_TRACK_ACTIVITY(name.c_str());
+}
 
 void Activity::onExit() { LOG_DBG("ACT", "Exiting activity: %s", name.c_str()); }
 
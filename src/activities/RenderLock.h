@@ -14,4 +14,6 @@ class RenderLock {
   ~RenderLock();
   void unlock();
   static bool peek();
+  // Whether the calling task holds the lock
+  static bool isHeldByCurrentTask();
 };
@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include "../util/ConfirmationActivity.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
@@ -156,6 +157,7 @@ void FileBrowserActivity::loop() {
           clearFileMetadata(fullPath);
           if (Storage.remove(fullPath.c_str())) {
             LOG_DBG("FileBrowser", "Deleted successfully");
+            LIBRARY_INDEX.removeFile(fullPath);
             loadFiles();
             if (files.empty()) {
               selectorIndex = 0;
@@ -6,6 +6,7 @@
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <I18n.h>
+#include <MemoryBudget.h>
 #include <Utf8.h>
 #include <Xtc.h>
 
@@ -19,6 +20,12 @@
 #include "components/UITheme.h"
 #include "fontIds.h"
 
+namespace {
+constexpr unsigned long INDEX_WHEN_IDLE_MS = 10000;
+// On USB power indexing resumes sooner, but not between two presses: each start reloads the book
+constexpr unsigned long INDEX_ON_USB_IDLE_MS = 2000;
+}  // namespace
+
 int HomeActivity::getMenuItemCount() const {
   int count = 4;  // File Browser, Recents, File transfer, Settings
   if (!recentBooks.empty()) {
@@ -114,10 +121,17 @@ void HomeActivity::onEnter() {
   hasOpdsUrl = strlen(SETTINGS.opdsServerUrl) > 0;
 
   selectorIndex = 0;
+  lastInputTime = millis();
 
   const auto& metrics = UITheme::getInstance().getMetrics();
   loadRecentBooks(metrics.homeRecentBooksCount);
 
+  // The cover is redrawn from its BMP when the buffer is taken away
+  coverCacheHandle = MemBudget.registerCache("home cover", MemoryBudget::Priority::Low, [this] {
+    freeCoverBuffer();
+    coverRendered = false;
+  });
+
   // Trigger first update
   requestUpdate();
 }
@@ -125,6 +139,10 @@ void HomeActivity::onEnter() {
 void HomeActivity::onExit() {
   Activity::onExit();
 
+  BOOK_INDEXER.cancel();
+
+  MemBudget.unregisterCache(coverCacheHandle);
+  coverCacheHandle = -1;
   // Free the stored cover buffer if any
   freeCoverBuffer();
 }
@@ -139,7 +157,7 @@ bool HomeActivity::storeCoverBuffer() {
   freeCoverBuffer();
 
   const size_t bufferSize = GfxRenderer::getBufferSize();
-  coverBuffer = static_cast<uint8_t*>(malloc(bufferSize));
+  coverBuffer = static_cast<uint8_t*>(MemBudget.allocate("home cover", bufferSize, MemoryBudget::Priority::Low));
   if (!coverBuffer) {
     return false;
   }
@@ -172,6 +190,16 @@ void HomeActivity::freeCoverBuffer() {
 }
 
 void HomeActivity::loop() {
+  // Index the last book read in the background once the Home screen sits idle, after a short pause only while
+  // charging. Any input stops it right away so the UI doesn't wait for a section to finish.
+  if (mappedInput.wasAnyPressed() || mappedInput.wasAnyReleased()) {
+    lastInputTime = millis();
+    BOOK_INDEXER.cancel();
+  } else if (recentsLoaded && FsHelpers::hasEpubExtension(APP_STATE.openEpubPath) &&
+             millis() - lastInputTime >= (mappedInput.isUsbConnected() ? INDEX_ON_USB_IDLE_MS : INDEX_WHEN_IDLE_MS)) {
+    BOOK_INDEXER.start(renderer, APP_STATE.openEpubPath);
+  }
+
   const int menuCount = getMenuItemCount();
 
   buttonNavigator.onNext([this, menuCount] {
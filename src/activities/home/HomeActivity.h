@@ -4,6 +4,7 @@
 
 #include "../Activity.h"
 #include "./FileBrowserActivity.h"
+#include "util/BookIndexer.h"
 #include "util/ButtonNavigator.h"
 
 struct RecentBook;
@@ -19,6 +20,8 @@ class HomeActivity final : public Activity {
   bool coverRendered = false;      // Track if cover has been rendered once
   bool coverBufferStored = false;  // Track if cover buffer is stored
   uint8_t* coverBuffer = nullptr;  // HomeActivity's own buffer for cover image
+  int coverCacheHandle = -1;       // MemoryBudget registration of coverBuffer
+  unsigned long lastInputTime = 0;
   std::vector<RecentBook> recentBooks;
   void onSelectBook(const std::string& path);
   void onFileBrowserOpen();
@@ -41,4 +44,6 @@ class HomeActivity final : public Activity {
   void onExit() override;
   void loop() override;
   void render(RenderLock&&) override;
+  // Let a background indexing job finish while charging
+  bool preventAutoSleep() override { return mappedInput.isUsbConnected() && BOOK_INDEXER.isRunning(); }
 };
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
@@ -13,6 +14,8 @@
 
 namespace {
 constexpr unsigned long GO_HOME_MS = 1000;
+constexpr unsigned long RESCAN_MS = 1000;
+constexpr StrId TAB_NAMES[] = {StrId::STR_RECENTS, StrId::STR_TITLE, StrId::STR_AUTHOR};
 }  // namespace
 
 void RecentBooksActivity::loadRecentBooks() {
@@ -29,55 +32,128 @@ void RecentBooksActivity::loadRecentBooks() {
   }
 }
 
+void RecentBooksActivity::loadLibrary() {
+  if (rescanRequested || !LIBRARY_INDEX.exists()) {
+    // Walks the whole card without opening books, a while on large collections
+    GUI.drawPopup(renderer, tr(STR_UPDATING));
+    LIBRARY_INDEX.scan();
+    rescanRequested = false;
+  }
+  libraryCount = LIBRARY_INDEX.getCount();
+  libraryPage.clear();
+  libraryPageStart = -1;
+  selectorIndex = std::min(selectorIndex, libraryCount);
+  libraryLoaded = true;
+}
+
+const LibraryIndex::Book& RecentBooksActivity::getLibraryBook(const int index) {
+  static const LibraryIndex::Book missingBook;
+  if (libraryPageStart < 0 || index < libraryPageStart ||
+      index >= libraryPageStart + static_cast<int>(libraryPage.size())) {
+    const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, true, true, true);
+    libraryPageStart = index / pageItems * pageItems;
+    LIBRARY_INDEX.readPage(selectedTab == TAB_BY_AUTHOR ? LibraryIndex::Order::Author : LibraryIndex::Order::Title,
+                           libraryPageStart, pageItems, libraryPage);
+  }
+  const int offset = index - libraryPageStart;
+  return offset < static_cast<int>(libraryPage.size()) ? libraryPage[offset] : missingBook;
+}
+
+int RecentBooksActivity::getItemCount() const {
+  return selectedTab == TAB_RECENT ? static_cast<int>(recentBooks.size()) : libraryCount;
+}
+
+void RecentBooksActivity::selectTab(const int tab) {
+  selectedTab = tab;
+  libraryLoaded = false;
+  libraryPage.clear();
+  libraryPageStart = -1;
+  requestUpdate();
+}
+
+void RecentBooksActivity::openItem(const int index) {
+  if (index < 0 || index >= getItemCount()) {
+    return;
+  }
+
+  if (selectedTab == TAB_RECENT) {
+    LOG_DBG("RBA", "Selected recent book: %s", recentBooks[index].path.c_str());
+    onSelectBook(recentBooks[index].path);
+    return;
+  }
+
+  const std::string path = getLibraryBook(index).path;
+  if (!Storage.exists(path.c_str())) {
+    // Removed from the card on a computer since the last scan
+    LOG_DBG("RBA", "Library book is gone: %s", path.c_str());
+    LIBRARY_INDEX.removeFile(path);
+    libraryLoaded = false;
+    requestUpdate();
+    return;
+  }
+  LOG_DBG("RBA", "Selected library book: %s", path.c_str());
+  onSelectBook(path);
+}
+
 void RecentBooksActivity::onEnter() {
   Activity::onEnter();
 
   // Load data
   loadRecentBooks();
 
-  selectorIndex = 0;
+  selectedTab = TAB_RECENT;
+  selectorIndex = recentBooks.empty() ? 0 : 1;
   requestUpdate();
 }
 
 void RecentBooksActivity::onExit() {
   Activity::onExit();
   recentBooks.clear();
+  libraryPage.clear();
+  libraryLoaded = false;
 }
 
 void RecentBooksActivity::loop() {
-  const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, true);
+  const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, true, true, true);
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (!recentBooks.empty() && selectorIndex < static_cast<int>(recentBooks.size())) {
-      LOG_DBG("RBA", "Selected recent book: %s", recentBooks[selectorIndex].path.c_str());
-      onSelectBook(recentBooks[selectorIndex].path);
-      return;
+    if (selectorIndex == 0) {
+      selectTab((selectedTab + 1) % TAB_COUNT);
+    } else if (selectedTab != TAB_RECENT && mappedInput.getHeldTime() >= RESCAN_MS) {
+      // Picks up books copied to or removed from the card on a computer
+      rescanRequested = true;
+      libraryLoaded = false;
+      requestUpdate();
+    } else {
+      openItem(selectorIndex - 1);
     }
+    return;
   }
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
     onGoHome();
   }
 
-  int listSize = static_cast<int>(recentBooks.size());
+  // The tab bar is the first row
+  const int listSize = getItemCount() + 1;
 
   buttonNavigator.onNextRelease([this, listSize] {
-    selectorIndex = ButtonNavigator::nextIndex(static_cast<int>(selectorIndex), listSize);
+    selectorIndex = ButtonNavigator::nextIndex(selectorIndex, listSize);
     requestUpdate();
   });
 
   buttonNavigator.onPreviousRelease([this, listSize] {
-    selectorIndex = ButtonNavigator::previousIndex(static_cast<int>(selectorIndex), listSize);
+    selectorIndex = ButtonNavigator::previousIndex(selectorIndex, listSize);
     requestUpdate();
   });
 
   buttonNavigator.onNextContinuous([this, listSize, pageItems] {
-    selectorIndex = ButtonNavigator::nextPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    selectorIndex = ButtonNavigator::nextPageIndex(selectorIndex, listSize, pageItems);
     requestUpdate();
   });
 
   buttonNavigator.onPreviousContinuous([this, listSize, pageItems] {
-    selectorIndex = ButtonNavigator::previousPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    selectorIndex = ButtonNavigator::previousPageIndex(selectorIndex, listSize, pageItems);
     requestUpdate();
   });
 }
@@ -85,23 +161,52 @@ void RecentBooksActivity::loop() {
 void RecentBooksActivity::render(RenderLock&&) {
   renderer.clearScreen();
 
+  if (selectedTab != TAB_RECENT && !libraryLoaded) {
+    loadLibrary();
+    renderer.clearScreen();
+  }
+
   const auto pageWidth = renderer.getScreenWidth();
   const auto pageHeight = renderer.getScreenHeight();
   const auto& metrics = UITheme::getInstance().getMetrics();
 
   GUI.drawHeader(renderer, Rect{0, metrics.topPadding, pageWidth, metrics.headerHeight}, tr(STR_MENU_RECENT_BOOKS));
 
-  const int contentTop = metrics.topPadding + metrics.headerHeight + metrics.verticalSpacing;
-  const int contentHeight = pageHeight - contentTop - metrics.buttonHintsHeight - metrics.verticalSpacing;
+  std::vector<TabInfo> tabs;
+  tabs.reserve(TAB_COUNT);
+  for (int i = 0; i < TAB_COUNT; i++) {
+    tabs.push_back({I18N.get(TAB_NAMES[i]), selectedTab == i});
+  }
+  GUI.drawTabBar(renderer, Rect{0, metrics.topPadding + metrics.headerHeight, pageWidth, metrics.tabBarHeight}, tabs,
+                 selectorIndex == 0);
 
-  // Recent tab
-  if (recentBooks.empty()) {
-    renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, tr(STR_NO_RECENT_BOOKS));
+  const int contentTop = metrics.topPadding + metrics.headerHeight + metrics.tabBarHeight + metrics.verticalSpacing;
+  const int contentHeight = pageHeight - contentTop - metrics.buttonHintsHeight - metrics.verticalSpacing;
+  const Rect contentRect{0, contentTop, pageWidth, contentHeight};
+
+  if (selectedTab == TAB_RECENT) {
+    if (recentBooks.empty()) {
+      renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, tr(STR_NO_RECENT_BOOKS));
+    } else {
+      GUI.drawList(
+          renderer, contentRect, recentBooks.size(), selectorIndex - 1,
+          [this](int index) { return recentBooks[index].title; },
+          [this](int index) { return recentBooks[index].author; },
+          [this](int index) { return UITheme::getFileIcon(recentBooks[index].path); });
+    }
+  } else if (libraryCount == 0) {
+    renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, tr(STR_NO_FILES_FOUND));
   } else {
+    // Rows are read from the index page by page, only the visible ones are asked for
     GUI.drawList(
-        renderer, Rect{0, contentTop, pageWidth, contentHeight}, recentBooks.size(), selectorIndex,
-        [this](int index) { return recentBooks[index].title; }, [this](int index) { return recentBooks[index].author; },
-        [this](int index) { return UITheme::getFileIcon(recentBooks[index].path); });
+        renderer, contentRect, libraryCount, selectorIndex - 1,
+        [this](int index) { return getLibraryBook(index).title; },
+        [this](int index) { return getLibraryBook(index).author; },
+        [this](int index) { return UITheme::getFileIcon(getLibraryBook(index).path); },
+        [this](int index) {
+          const uint8_t progress = getLibraryBook(index).progress;
+          return progress == LibraryIndex::UNKNOWN_PROGRESS ? std::string() : std::to_string(progress) + "%";
+        });
   }
 
   // Help text
@@ -6,20 +6,37 @@
 #include <vector>
 
 #include "../Activity.h"
+#include "LibraryIndex.h"
 #include "RecentBooksStore.h"
 #include "util/ButtonNavigator.h"
 
 class RecentBooksActivity final : public Activity {
  private:
+  enum Tab { TAB_RECENT, TAB_BY_TITLE, TAB_BY_AUTHOR, TAB_COUNT };
+
   ButtonNavigator buttonNavigator;
 
-  size_t selectorIndex = 0;
+  int selectedTab = TAB_RECENT;
+  int selectorIndex = 0;  // 0 is the tab bar, books start at 1
 
   // Recent tab state
   std::vector<RecentBook> recentBooks;
 
+  // Library tabs state, one page of books is read from the library index at a time
+  bool libraryLoaded = false;
+  bool rescanRequested = false;
+  int libraryCount = 0;
+  int libraryPageStart = -1;
+  std::vector<LibraryIndex::Book> libraryPage;
+
   // Data loading
   void loadRecentBooks();
+  void loadLibrary();
+  const LibraryIndex::Book& getLibraryBook(int index);
+
+  int getItemCount() const;
+  void selectTab(int tab);
+  void openItem(int index);
 
  public:
   explicit RecentBooksActivity(GfxRenderer& renderer, MappedInputManager& mappedInput)
@@ -1,13 +1,18 @@
 #include "EpubReaderActivity.h"
 
+#include <Epub/BookAnchorIndex.h>
 #include <Epub/Page.h>
+#include <Epub/SectionLayoutCache.h>
 #include <Epub/blocks/TextBlock.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <I18n.h>
 #include <Logging.h>
+#include <MemoryBudget.h>
+#include <Trace.h>
 
+#include "CacheManager.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
 #include "EpubReaderChapterSelectionActivity.h"
@@ -15,11 +20,13 @@
 #include "EpubReaderPercentSelectionActivity.h"
 #include "KOReaderCredentialStore.h"
 #include "KOReaderSyncActivity.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "QrDisplayActivity.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
+#include "util/BookIndexer.h"
 #include "util/ScreenshotUtil.h"
 
 namespace {
@@ -74,6 +81,13 @@ void EpubReaderActivity::onEnter() {
   applyReaderOrientation(renderer, SETTINGS.orientation);
 
   epub->setupCacheDir();
+  CACHE_MANAGER.onBookOpened(epub->getCachePath());
+
+  // Dropping the prefetched page only costs a synchronous load on the next turn
+  prefetchCacheHandle = MemBudget.registerCache("prefetched page", MemoryBudget::Priority::Low, [this] {
+    prefetchedPage.reset();
+    prefetchedPageIndex = -1;
+  });
 
   FsFile f;
   if (Storage.openFileForRead("ERS", epub->getCachePath() + "/progress.bin", f)) {
@@ -104,6 +118,8 @@ void EpubReaderActivity::onEnter() {
   APP_STATE.openEpubPath = epub->getPath();
   APP_STATE.saveToFile();
   RECENT_BOOKS.addBook(epub->getPath(), epub->getTitle(), epub->getAuthor(), epub->getThumbBmpPath());
+  LIBRARY_INDEX.updateBook(epub->getPath(), epub->getTitle(), epub->getAuthor(),
+                           Storage.exists(epub->getCoverBmpPath().c_str()));
 
   // Trigger first update
   requestUpdate();
@@ -117,7 +133,16 @@ void EpubReaderActivity::onExit() {
 
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  MemBudget.unregisterCache(prefetchCacheHandle);
+  prefetchCacheHandle = -1;
+  prefetchedPage.reset();
+  if (section && section->pageCount > 0 && epub->getBookSize() > 0) {
+    const float chapterProgress = static_cast<float>(section->currentPage + 1) / static_cast<float>(section->pageCount);
+    const float bookProgress = epub->calculateProgress(currentSpineIndex, chapterProgress) * 100.0f;
+    LIBRARY_INDEX.setProgress(epub->getPath(), clampPercent(static_cast<int>(bookProgress + 0.5f)));
+  }
   section.reset();
+  CACHE_MANAGER.onBookClosed(epub->getCachePath());
   epub.reset();
 }
 
@@ -277,19 +302,24 @@ void EpubReaderActivity::jumpToPercent(int percent) {
     return;
   }
 
-  int targetSpineIndex = spineCount - 1;
-  size_t prevCumulative = 0;
-
-  for (int i = 0; i < spineCount; i++) {
-    const size_t cumulative = epub->getCumulativeSpineItemSize(i);
-    if (targetSize <= cumulative) {
-      // Found the spine item containing the absolute position.
-      targetSpineIndex = i;
-      prevCumulative = (i > 0) ? epub->getCumulativeSpineItemSize(i - 1) : 0;
-      break;
-    }
+  // Every section's page count is known for this layout: jump straight to the page
+  if (pageMap.isComplete() && pageMap.getTotalPages() > 0) {
+    int spineIndex = 0;
+    int page = 0;
+    pageMap.locateBookPage(static_cast<uint32_t>(static_cast<uint64_t>(pageMap.getTotalPages()) * percent / 100),
+                           spineIndex, page);
+    RenderLock lock(*this);
+    currentSpineIndex = spineIndex;
+    nextPageNumber = page;
+    pendingPercentJump = false;
+    section.reset();
+    return;
   }
 
+  // Spine item containing the absolute position, the last one if it's past the end
+  const int targetSpineIndex = epub->getSpineIndexForBookOffset(targetSize);
+  const size_t prevCumulative = (targetSpineIndex > 0) ? epub->getCumulativeSpineItemSize(targetSpineIndex - 1) : 0;
+
   const size_t cumulative = epub->getCumulativeSpineItemSize(targetSpineIndex);
   const size_t spineSize = (cumulative > prevCumulative) ? (cumulative - prevCumulative) : 0;
   // Store a normalized position within the spine so it can be applied once loaded.
@@ -329,7 +359,8 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
       break;
     }
     case EpubReaderMenuActivity::MenuAction::FOOTNOTES: {
-      startActivityForResult(std::make_unique<EpubReaderFootnotesActivity>(renderer, mappedInput, currentPageFootnotes),
+      startActivityForResult(std::make_unique<EpubReaderFootnotesActivity>(renderer, mappedInput, currentPageFootnotes,
+                                                                           *epub, currentSpineIndex),
                              [this](const ActivityResult& result) {
                                if (!result.isCancelled) {
                                  const auto& footnoteResult = std::get<FootnoteResult>(result.data);
@@ -364,10 +395,10 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
             if (el->getTag() == TAG_PageLine) {
               const auto& line = static_cast<const PageLine&>(*el);
               if (line.getBlock()) {
-                const auto& words = line.getBlock()->getWords();
-                for (const auto& w : words) {
+                const auto& block = *line.getBlock();
+                for (size_t i = 0; i < block.wordCount(); i++) {
                   if (!fullText.empty()) fullText += " ";
-                  fullText += w;
+                  fullText += block.getWord(i);
                 }
               }
             }
@@ -417,7 +448,7 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
         const int totalPages = section ? section->pageCount : 0;
         startActivityForResult(
             std::make_unique<KOReaderSyncActivity>(renderer, mappedInput, epub, epub->getPath(), currentSpineIndex,
-                                                   currentPage, totalPages),
+                                                   currentPage, totalPages, &pageMap),
             [this](const ActivityResult& result) {
               if (!result.isCancelled) {
                 const auto& sync = std::get<SyncResult>(result.data);
@@ -565,10 +596,22 @@ void EpubReaderActivity::render(RenderLock&& lock) {
     const auto filepath = epub->getSpineItem(currentSpineIndex).href;
     LOG_DBG("ERS", "Loading file: %s, index: %d", filepath.c_str(), currentSpineIndex);
     section = std::unique_ptr<Section>(new Section(epub, currentSpineIndex, renderer));
+    prefetchedPage.reset();
+    prefetchedPageIndex = -1;
 
     const uint16_t viewportWidth = renderer.getScreenWidth() - orientedMarginLeft - orientedMarginRight;
     const uint16_t viewportHeight = renderer.getScreenHeight() - orientedMarginTop - orientedMarginBottom;
 
+    const uint32_t layoutHash = Section::layoutHash(
+        SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(), SETTINGS.extraParagraphSpacing,
+        SETTINGS.paragraphAlignment, viewportWidth, viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
+        SETTINGS.imageRendering);
+    if (!pageMap.isLoaded(layoutHash)) {
+      SectionLayoutCache::touch(epub->getCachePath(), layoutHash);
+      pageMap.load(epub->getCachePath(), epub->getSpineItemsCount(), layoutHash);
+      BOOK_INDEXER.setLayout(epub->getCachePath(), layoutHash, viewportWidth, viewportHeight);
+    }
+
     if (!section->loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
                                   SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
                                   viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
@@ -588,6 +631,7 @@ void EpubReaderActivity::render(RenderLock&& lock) {
     } else {
       LOG_DBG("ERS", "Cache found, skipping build...");
     }
+    pageMap.setSectionPages(currentSpineIndex, section->pageCount);
 
     if (nextPageNumber == UINT16_MAX) {
       section->currentPage = section->pageCount - 1;
@@ -648,7 +692,14 @@ void EpubReaderActivity::render(RenderLock&& lock) {
   }
 
   {
-    auto p = section->loadPageFromSectionFile();
+    std::unique_ptr<Page> p;
+    if (prefetchedPage && prefetchedPageIndex == section->currentPage) {
+      p = std::move(prefetchedPage);
+    } else {
+      p = section->loadPageFromSectionFile();
+    }
+    prefetchedPage.reset();
+    prefetchedPageIndex = -1;
     if (!p) {
       LOG_ERR("ERS", "Failed to load page from SD - clearing section cache");
       section->clearCache();
@@ -697,9 +748,13 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
                                         const int orientedMarginLeft) {
   // Force special handling for pages with images when anti-aliasing is on
   bool imagePageWithAA = page->hasImages() && SETTINGS.textAntiAliasing;
+  HalDisplay::RefreshHandle refresh;
 
-  page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
-  renderStatusBar();
+  {
+    TRACE_SPAN("render.bw");
+    page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+    renderStatusBar();
+  }
   if (imagePageWithAA) {
     // Double FAST_REFRESH with selective image blanking (pablohc's technique):
     // HALF_REFRESH sets particles too firmly for the grayscale LUT to adjust.
@@ -711,28 +766,42 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
       renderer.fillRect(imgX + orientedMarginLeft, imgY + orientedMarginTop, imgW, imgH, false);
       renderer.displayBuffer(HalDisplay::FAST_REFRESH);
 
-      // Re-render page content to restore images into the blanked area
-      page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
-      renderStatusBar();
-      renderer.displayBuffer(HalDisplay::FAST_REFRESH);
+      // Restore images into the blanked area. Only the blanked band needs redrawing, so when no text shares it
+      // the images are copied back on their own (a plane copy once the panel cache is warm).
+      if (page->hasTextInBand(imgY, imgH, renderer.getLineHeight(SETTINGS.getReaderFontId()))) {
+        page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+        renderStatusBar();
+      } else {
+        page->renderImages(renderer, orientedMarginLeft, orientedMarginTop);
+      }
+      refresh = renderer.displayBufferAsync(HalDisplay::FAST_REFRESH);
     } else {
-      renderer.displayBuffer(HalDisplay::HALF_REFRESH);
+      refresh = renderer.displayBufferAsync(HalDisplay::HALF_REFRESH);
     }
     // Double FAST_REFRESH handles ghosting for image pages; don't count toward full refresh cadence
   } else if (pagesUntilFullRefresh <= 1) {
-    renderer.displayBuffer(HalDisplay::HALF_REFRESH);
+    refresh = renderer.displayBufferAsync(HalDisplay::HALF_REFRESH);
     pagesUntilFullRefresh = SETTINGS.getRefreshFrequency();
   } else {
-    renderer.displayBuffer();
+    refresh = renderer.displayBufferAsync();
     pagesUntilFullRefresh--;
   }
 
-  // Save bw buffer to reset buffer state after grayscale data sync
-  renderer.storeBwBuffer();
+  // Save bw buffer to reset buffer state after grayscale data sync. Only reads the frame buffer, so it can run while
+  // the panel is still refreshing.
+  if (SETTINGS.textAntiAliasing) {
+    renderer.storeBwBuffer();
+  }
+
+  // Load the next page so turning to it skips the read. The display driver keeps the shared SPI bus until the panel
+  // is done, so this doesn't overlap the refresh: its SD reads wait for it.
+  prefetchNextPage();
+  LOG_DBG("ERS", "Next page prepared %s the refresh finished", refresh.done() ? "after" : "before");
 
   // grayscale rendering
   // TODO: Only do this if font supports it
   if (SETTINGS.textAntiAliasing) {
+    TRACE_SPAN("render.gray");
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
     page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
@@ -747,10 +816,23 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
     // display grayscale part
     renderer.displayGrayBuffer();
     renderer.setRenderMode(GfxRenderer::BW);
+
+    // restore the bw data
+    renderer.restoreBwBuffer();
+  } else {
+    // No snapshot to restore, but the panel's grayscale RAM still has to be reset to the BW frame, as
+    // restoreBwBuffer() does
+    renderer.cleanupGrayscaleWithFrameBuffer();
   }
+}
 
-  // restore the bw data
-  renderer.restoreBwBuffer();
+void EpubReaderActivity::prefetchNextPage() {
+  const int nextPage = section->currentPage + 1;
+  if (nextPage >= section->pageCount || (prefetchedPage && prefetchedPageIndex == nextPage)) {
+    return;
+  }
+  prefetchedPage = section->loadPageFromSectionFile(nextPage);
+  prefetchedPageIndex = prefetchedPage ? nextPage : -1;
 }
 
 void EpubReaderActivity::renderStatusBar() const {
@@ -758,7 +840,16 @@ void EpubReaderActivity::renderStatusBar() const {
   const int currentPage = section->currentPage + 1;
   const float pageCount = section->pageCount;
   const float sectionChapterProg = (pageCount > 0) ? (static_cast<float>(currentPage) / pageCount) : 0;
-  const float bookProgress = epub->calculateProgress(currentSpineIndex, sectionChapterProg) * 100;
+  float bookProgress = epub->calculateProgress(currentSpineIndex, sectionChapterProg) * 100;
+  int shownPage = currentPage;
+  int shownPageCount = section->pageCount;
+
+  // Once every section is indexed the page counter and progress are for the whole book
+  if (pageMap.isComplete() && pageMap.getTotalPages() > 0) {
+    shownPage = static_cast<int>(pageMap.getBookPage(currentSpineIndex, section->currentPage)) + 1;
+    shownPageCount = static_cast<int>(pageMap.getTotalPages());
+    bookProgress = static_cast<float>(shownPage) * 100 / static_cast<float>(shownPageCount);
+  }
 
   std::string title;
 
@@ -787,7 +878,7 @@ void EpubReaderActivity::renderStatusBar() const {
     title = epub->getTitle();
   }
 
-  GUI.drawStatusBar(renderer, bookProgress, currentPage, pageCount, title, 0, textYOffset);
+  GUI.drawStatusBar(renderer, bookProgress, shownPage, shownPageCount, title, 0, textYOffset);
 }
 
 void EpubReaderActivity::navigateToHref(const std::string& hrefStr, const bool savePosition) {
@@ -817,6 +908,15 @@ void EpubReaderActivity::navigateToHref(const std::string& hrefStr, const bool s
     targetSpineIndex = epub->resolveHrefToSpineIndex(hrefStr);
   }
 
+  // Anchors of sections already built resolve to their page without opening the section, and to the right section
+  // when the href's file doesn't hold the id
+  uint16_t targetPage = 0;
+  int anchorSpineIndex;
+  if (!anchor.empty() && BookAnchorIndex::find(epub->getCachePath(), pageMap.getLayoutHash(), anchor, targetSpineIndex,
+                                               anchorSpineIndex, targetPage)) {
+    targetSpineIndex = anchorSpineIndex;
+  }
+
   if (targetSpineIndex < 0) {
     LOG_DBG("ERS", "Could not resolve href: %s", hrefStr.c_str());
     if (savePosition && footnoteDepth > 0) footnoteDepth--;  // undo push
@@ -827,11 +927,11 @@ void EpubReaderActivity::navigateToHref(const std::string& hrefStr, const bool s
     RenderLock lock(*this);
     pendingAnchor = std::move(anchor);
     currentSpineIndex = targetSpineIndex;
-    nextPageNumber = 0;
+    nextPageNumber = targetPage;
     section.reset();
   }
   requestUpdate();
-  LOG_DBG("ERS", "Navigated to spine %d for href: %s", targetSpineIndex, hrefStr.c_str());
+  LOG_DBG("ERS", "Navigated to spine %d page %u for href: %s", targetSpineIndex, targetPage, hrefStr.c_str());
 }
 
 void EpubReaderActivity::restoreSavedPosition() {
@@ -1,6 +1,8 @@
 #pragma once
 #include <Epub.h>
 #include <Epub/FootnoteEntry.h>
+#include <Epub/Page.h>
+#include <Epub/PageMap.h>
 #include <Epub/Section.h>
 
 #include "EpubReaderMenuActivity.h"
@@ -9,6 +11,12 @@
 class EpubReaderActivity final : public Activity {
   std::shared_ptr<Epub> epub;
   std::unique_ptr<Section> section = nullptr;
+  // Next page of the section, deserialized while the panel refreshes the current one
+  std::unique_ptr<Page> prefetchedPage;
+  int prefetchedPageIndex = -1;
+  int prefetchCacheHandle = -1;  // MemoryBudget registration of prefetchedPage
+  // Page counts of every section indexed for the current layout
+  PageMap pageMap;
   int currentSpineIndex = 0;
   int nextPageNumber = 0;
   // Set when navigating to a footnote href with a fragment (e.g. #note1).
@@ -41,6 +49,7 @@ class EpubReaderActivity final : public Activity {
   void renderContents(std::unique_ptr<Page> page, int orientedMarginTop, int orientedMarginRight,
                       int orientedMarginBottom, int orientedMarginLeft);
   void renderStatusBar() const;
+  void prefetchNextPage();
   void saveProgress(int spineIndex, int currentPage, int pageCount);
   // Jump to a percentage of the book (0-100), mapping it to spine and page.
   void jumpToPercent(int percent);
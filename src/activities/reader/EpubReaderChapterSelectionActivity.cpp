@@ -32,6 +32,7 @@ void EpubReaderChapterSelectionActivity::onEnter() {
     return;
   }
 
+  tocWindows = std::make_unique<TocWindowCache>(epub, getPageItems());
   selectorIndex = epub->getTocIndexForSpineIndex(currentSpineIndex);
   if (selectorIndex == -1) {
     selectorIndex = 0;
@@ -41,7 +42,10 @@ void EpubReaderChapterSelectionActivity::onEnter() {
   requestUpdate();
 }
 
-void EpubReaderChapterSelectionActivity::onExit() { Activity::onExit(); }
+void EpubReaderChapterSelectionActivity::onExit() {
+  Activity::onExit();
+  tocWindows.reset();
+}
 
 void EpubReaderChapterSelectionActivity::loop() {
   const int pageItems = getPageItems();
@@ -66,21 +70,25 @@ void EpubReaderChapterSelectionActivity::loop() {
   }
 
   buttonNavigator.onNextRelease([this, totalItems] {
+    lastMoveForward = true;
     selectorIndex = ButtonNavigator::nextIndex(selectorIndex, totalItems);
     requestUpdate();
   });
 
   buttonNavigator.onPreviousRelease([this, totalItems] {
+    lastMoveForward = false;
     selectorIndex = ButtonNavigator::previousIndex(selectorIndex, totalItems);
     requestUpdate();
   });
 
   buttonNavigator.onNextContinuous([this, totalItems, pageItems] {
+    lastMoveForward = true;
     selectorIndex = ButtonNavigator::nextPageIndex(selectorIndex, totalItems, pageItems);
     requestUpdate();
   });
 
   buttonNavigator.onPreviousContinuous([this, totalItems, pageItems] {
+    lastMoveForward = false;
     selectorIndex = ButtonNavigator::previousPageIndex(selectorIndex, totalItems, pageItems);
     requestUpdate();
   });
@@ -120,12 +128,13 @@ void EpubReaderChapterSelectionActivity::render(RenderLock&&) {
     const int displayY = 60 + contentY + i * 30;
     const bool isSelected = (itemIndex == selectorIndex);
 
-    auto item = epub->getTocItem(itemIndex);
+    const auto* item = tocWindows->get(itemIndex);
+    if (!item) break;
 
     // Indent per TOC level while keeping content within the gutter-safe region.
-    const int indentSize = contentX + 20 + (item.level - 1) * 15;
+    const int indentSize = contentX + 20 + (item->level - 1) * 15;
     const std::string chapterName =
-        renderer.truncatedText(UI_10_FONT_ID, item.title.c_str(), contentWidth - 40 - indentSize);
+        renderer.truncatedText(UI_10_FONT_ID, item->title.c_str(), contentWidth - 40 - indentSize);
 
     renderer.drawText(UI_10_FONT_ID, indentSize, displayY, chapterName.c_str(), !isSelected);
   }
@@ -134,4 +143,7 @@ void EpubReaderChapterSelectionActivity::render(RenderLock&&) {
   GUI.drawButtonHints(renderer, labels.btn1, labels.btn2, labels.btn3, labels.btn4);
 
   renderer.displayBuffer();
+
+  // While the page is on screen, so paging on in the same direction is served from memory
+  tocWindows->prefetch(selectorIndex, lastMoveForward);
 }
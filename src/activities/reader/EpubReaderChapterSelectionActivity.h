@@ -1,5 +1,6 @@
 #pragma once
 #include <Epub.h>
+#include <Epub/TocWindowCache.h>
 
 #include <memory>
 
@@ -12,6 +13,9 @@ class EpubReaderChapterSelectionActivity final : public Activity {
   ButtonNavigator buttonNavigator;
   int currentSpineIndex = 0;
   int selectorIndex = 0;
+  // TOC entries around the visible page, read a page at a time
+  std::unique_ptr<TocWindowCache> tocWindows;
+  bool lastMoveForward = true;
 
   // Number of items that fit on a page, derived from logical screen height.
   // This adapts automatically when switching between portrait and landscape.
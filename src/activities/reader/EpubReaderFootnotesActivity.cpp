@@ -1,5 +1,7 @@
 #include "EpubReaderFootnotesActivity.h"
 
+#include <Epub.h>
+#include <Epub/FootnoteStore.h>
 #include <GfxRenderer.h>
 #include <I18n.h>
 
@@ -18,6 +20,19 @@ void EpubReaderFootnotesActivity::onEnter() {
 void EpubReaderFootnotesActivity::onExit() { Activity::onExit(); }
 
 void EpubReaderFootnotesActivity::loop() {
+  if (showingNote) {
+    if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
+      showingNote = false;
+      noteText.clear();
+      requestUpdate();
+    } else if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
+      // Long notes are read in place
+      setResult(FootnoteResult{footnotes[selectedIndex].href});
+      finish();
+    }
+    return;
+  }
+
   if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
     ActivityResult result;
     result.isCancelled = true;
@@ -28,8 +43,13 @@ void EpubReaderFootnotesActivity::loop() {
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
     if (selectedIndex >= 0 && selectedIndex < static_cast<int>(footnotes.size())) {
-      setResult(FootnoteResult{footnotes[selectedIndex].href});
-      finish();
+      if (loadNote(footnotes[selectedIndex].href)) {
+        showingNote = true;
+        requestUpdate();
+      } else {
+        setResult(FootnoteResult{footnotes[selectedIndex].href});
+        finish();
+      }
     }
     return;
   }
@@ -49,6 +69,46 @@ void EpubReaderFootnotesActivity::loop() {
   });
 }
 
+bool EpubReaderFootnotesActivity::loadNote(const std::string& href) {
+  std::string key;
+  if (!FootnoteStore::makeKey(epub, spineIndex, href, key)) {
+    return false;
+  }
+
+  // The background indexer writes the store while holding the render lock
+  RenderLock lock(*this);
+  if (FootnoteStore::find(epub.getCachePath(), key, noteText)) {
+    return true;
+  }
+  // Not captured yet: read it from the note's file once, it's stored for next time
+  GUI.drawPopup(renderer, tr(STR_LOADING_POPUP));
+  FootnoteStore::capture(epub, spineIndex, {href});
+  return FootnoteStore::find(epub.getCachePath(), key, noteText);
+}
+
+void EpubReaderFootnotesActivity::renderNote() const {
+  const auto& metrics = UITheme::getInstance().getMetrics();
+  constexpr int margin = 10;
+  constexpr int padding = 12;
+  const int screenWidth = renderer.getScreenWidth();
+  const int lineHeight = renderer.getLineHeight(UI_10_FONT_ID);
+  const int panelBottom = renderer.getScreenHeight() - metrics.buttonHintsHeight - margin;
+  const int maxHeight = panelBottom - renderer.getScreenHeight() / 3;
+  const int maxLines = std::max(1, (maxHeight - 2 * padding) / lineHeight);
+  const auto lines =
+      renderer.wrappedText(UI_10_FONT_ID, noteText.c_str(), screenWidth - 2 * (margin + padding), maxLines);
+
+  // Fits the text, above the button hints
+  const int panelHeight = static_cast<int>(lines.size()) * lineHeight + 2 * padding;
+  const int panelTop = panelBottom - panelHeight;
+  renderer.fillRect(margin, panelTop, screenWidth - 2 * margin, panelHeight, false);
+  renderer.drawRect(margin, panelTop, screenWidth - 2 * margin, panelHeight, 2, true);
+  for (size_t i = 0; i < lines.size(); i++) {
+    renderer.drawText(UI_10_FONT_ID, margin + padding, panelTop + padding + static_cast<int>(i) * lineHeight,
+                      lines[i].c_str());
+  }
+}
+
 void EpubReaderFootnotesActivity::render(RenderLock&&) {
   renderer.clearScreen();
 
@@ -87,7 +147,11 @@ void EpubReaderFootnotesActivity::render(RenderLock&&) {
     renderer.drawText(UI_10_FONT_ID, marginLeft, y + 4, label.c_str(), !isSelected);
   }
 
-  const auto labels = mappedInput.mapLabels(tr(STR_BACK), tr(STR_SELECT), "", "");
+  if (showingNote) {
+    renderNote();
+  }
+
+  const auto labels = mappedInput.mapLabels(tr(STR_BACK), showingNote ? tr(STR_GO_TO) : tr(STR_SELECT), "", "");
   GUI.drawButtonHints(renderer, labels.btn1, labels.btn2, labels.btn3, labels.btn4);
 
   renderer.displayBuffer();
@@ -4,16 +4,23 @@
 
 #include <cstring>
 #include <functional>
+#include <string>
 #include <vector>
 
 #include "../Activity.h"
 #include "util/ButtonNavigator.h"
 
+class Epub;
+
 class EpubReaderFootnotesActivity final : public Activity {
  public:
   explicit EpubReaderFootnotesActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
-                                       const std::vector<FootnoteEntry>& footnotes)
-      : Activity("EpubReaderFootnotes", renderer, mappedInput), footnotes(footnotes) {}
+                                       const std::vector<FootnoteEntry>& footnotes, const Epub& epub,
+                                       const int spineIndex)
+      : Activity("EpubReaderFootnotes", renderer, mappedInput),
+        footnotes(footnotes),
+        epub(epub),
+        spineIndex(spineIndex) {}
 
   void onEnter() override;
   void onExit() override;
@@ -22,7 +29,15 @@ class EpubReaderFootnotesActivity final : public Activity {
 
  private:
   const std::vector<FootnoteEntry>& footnotes;
+  const Epub& epub;
+  const int spineIndex;  // section the footnotes are on, for same-file links
   int selectedIndex = 0;
   int scrollOffset = 0;
   ButtonNavigator buttonNavigator;
+  // Text of the selected note, shown over the list
+  bool showingNote = false;
+  std::string noteText;
+
+  bool loadNote(const std::string& href);
+  void renderNote() const;
 };
@@ -133,11 +133,11 @@ void KOReaderSyncActivity::performSync() {
   // Convert remote progress to CrossPoint position
   hasRemoteProgress = true;
   KOReaderPosition koPos = {remoteProgress.progress, remoteProgress.percentage};
-  remotePosition = ProgressMapper::toCrossPoint(epub, koPos, currentSpineIndex, totalPagesInSpine);
+  remotePosition = ProgressMapper::toCrossPoint(epub, koPos, currentSpineIndex, totalPagesInSpine, pageMap);
 
   // Calculate local progress in KOReader format (for display)
   CrossPointPosition localPos = {currentSpineIndex, currentPage, totalPagesInSpine};
-  localProgress = ProgressMapper::toKOReader(epub, localPos);
+  localProgress = ProgressMapper::toKOReader(epub, localPos, pageMap);
 
   {
     RenderLock lock(*this);
@@ -163,7 +163,7 @@ void KOReaderSyncActivity::performUpload() {
 
   // Convert current position to KOReader format
   CrossPointPosition localPos = {currentSpineIndex, currentPage, totalPagesInSpine};
-  KOReaderPosition koPos = ProgressMapper::toKOReader(epub, localPos);
+  KOReaderPosition koPos = ProgressMapper::toKOReader(epub, localPos, pageMap);
 
   KOReaderProgress progress;
   progress.document = documentHash;
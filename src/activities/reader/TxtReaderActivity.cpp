@@ -8,6 +8,7 @@
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
@@ -66,6 +67,11 @@ void TxtReaderActivity::onExit() {
   // Reset orientation back to portrait for the rest of the UI
   renderer.setOrientation(GfxRenderer::Orientation::Portrait);
 
+  // Pages are only known once the file was laid out
+  if (txt && !pageOffsets.empty() && totalPages > 0) {
+    const int percent = (currentPage + 1) * 100 / totalPages;
+    LIBRARY_INDEX.setProgress(txt->getPath(), static_cast<uint8_t>(std::min(percent, 100)));
+  }
   pageOffsets.clear();
   currentPageLines.clear();
   APP_STATE.readerActivityLoadCount = 0;
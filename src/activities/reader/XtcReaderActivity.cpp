@@ -11,9 +11,13 @@
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <I18n.h>
+#include <MemoryBudget.h>
+
+#include <algorithm>
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "XtcReaderChapterSelectionActivity.h"
@@ -41,6 +45,8 @@ void XtcReaderActivity::onEnter() {
   APP_STATE.openEpubPath = xtc->getPath();
   APP_STATE.saveToFile();
   RECENT_BOOKS.addBook(xtc->getPath(), xtc->getTitle(), xtc->getAuthor(), xtc->getThumbBmpPath());
+  LIBRARY_INDEX.updateBook(xtc->getPath(), xtc->getTitle(), xtc->getAuthor(),
+                           Storage.exists(xtc->getCoverBmpPath().c_str()));
 
   // Trigger first update
   requestUpdate();
@@ -51,6 +57,10 @@ void XtcReaderActivity::onExit() {
 
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  if (xtc && xtc->getPageCount() > 0) {
+    const uint32_t percent = (currentPage + 1) * 100 / xtc->getPageCount();
+    LIBRARY_INDEX.setProgress(xtc->getPath(), static_cast<uint8_t>(std::min<uint32_t>(percent, 100)));
+  }
   xtc.reset();
 }
 
@@ -158,7 +168,8 @@ void XtcReaderActivity::renderPage() {
   }
 
   // Allocate page buffer
-  uint8_t* pageBuffer = static_cast<uint8_t*>(malloc(pageBufferSize));
+  uint8_t* pageBuffer =
+      static_cast<uint8_t*>(MemBudget.allocate("xtc page", pageBufferSize, MemoryBudget::Priority::High));
   if (!pageBuffer) {
     LOG_ERR("XTR", "Failed to allocate page buffer (%lu bytes)", pageBufferSize);
     renderer.clearScreen();
@@ -5,6 +5,7 @@
 #include <I18n.h>
 #include <Logging.h>
 
+#include "CacheManager.h"
 #include "MappedInputManager.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
@@ -112,6 +113,7 @@ void ClearCacheActivity::clearCache() {
     }
   }
   root.close();
+  CACHE_MANAGER.reset();
 
   LOG_DBG("CLEAR_CACHE", "Cache cleared: %d removed, %d failed", clearedCount, failedCount);
 
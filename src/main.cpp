@@ -1,3 +1,4 @@
+#include <AllocTracker.h>
 #include <Arduino.h>
 #include <Epub.h>
 #include <FontDecompressor.h>
@@ -9,7 +10,9 @@
 #include <HalSystem.h>
 #include <I18n.h>
 #include <Logging.h>
+#include <MemoryBudget.h>
 #include <SPI.h>
+#include <Trace.h>
 #include <builtinFonts/all.h>
 
 #include <cstring>
@@ -21,9 +24,13 @@
 #include "RecentBooksStore.h"
 #include "activities/Activity.h"
 #include "activities/ActivityManager.h"
+#include "activities/RenderLock.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
+#include "util/BookIndexer.h"
+#include "util/BootProfiler.h"
 #include "util/ButtonNavigator.h"
+#include "util/ResumeFrame.h"
 #include "util/ScreenshotUtil.h"
 
 HalDisplay display;
@@ -181,9 +188,18 @@ void waitForPowerRelease() {
 // Enter deep sleep mode
 void enterDeepSleep() {
   HalPowerManager::Lock powerLock;  // Ensure we are at normal CPU frequency for sleep preparation
+  BOOK_INDEXER.stop();              // it resumes from index.bin after wake
   APP_STATE.lastSleepFromReader = activityManager.isReaderActivity();
   APP_STATE.saveToFile();
 
+  // Keep the reader page for instant wake, before the sleep screen replaces it
+  if (APP_STATE.lastSleepFromReader) {
+    RenderLock lock;
+    ResumeFrame::save(renderer, APP_STATE.openEpubPath);
+  } else {
+    ResumeFrame::discard();
+  }
+
   activityManager.goToSleep();
 
   display.deepSleep();
@@ -193,38 +209,67 @@ void enterDeepSleep() {
   powerManager.startDeepSleep(gpio);
 }
 
-void setupDisplayAndFonts() {
+void setupDisplay() {
   display.begin();
   renderer.begin();
   activityManager.begin();
+  // Evictable caches are used under the render lock
+  MemBudget.setOwnerLockCheck(&RenderLock::isHeldByCurrentTask);
   LOG_DBG("MAIN", "Display initialized");
+}
+
+// Reader font families are registered on first use, boot only registers the UI fonts
+const EpdFontFamily* resolveReaderFont(const int fontId) {
+  switch (fontId) {
+    case BOOKERLY_14_FONT_ID:
+      return &bookerly14FontFamily;
+#ifndef OMIT_FONTS
+    case BOOKERLY_12_FONT_ID:
+      return &bookerly12FontFamily;
+    case BOOKERLY_16_FONT_ID:
+      return &bookerly16FontFamily;
+    case BOOKERLY_18_FONT_ID:
+      return &bookerly18FontFamily;
+    case NOTOSANS_12_FONT_ID:
+      return &notosans12FontFamily;
+    case NOTOSANS_14_FONT_ID:
+      return &notosans14FontFamily;
+    case NOTOSANS_16_FONT_ID:
+      return &notosans16FontFamily;
+    case NOTOSANS_18_FONT_ID:
+      return &notosans18FontFamily;
+    case OPENDYSLEXIC_8_FONT_ID:
+      return &opendyslexic8FontFamily;
+    case OPENDYSLEXIC_10_FONT_ID:
+      return &opendyslexic10FontFamily;
+    case OPENDYSLEXIC_12_FONT_ID:
+      return &opendyslexic12FontFamily;
+    case OPENDYSLEXIC_14_FONT_ID:
+      return &opendyslexic14FontFamily;
+#endif  // OMIT_FONTS
+    default:
+      return nullptr;
+  }
+}
 
+void setupFonts() {
   // Initialize font decompressor for compressed reader fonts
   if (!fontDecompressor.init()) {
     LOG_ERR("MAIN", "Font decompressor init failed");
   }
   renderer.setFontDecompressor(&fontDecompressor);
-  renderer.insertFont(BOOKERLY_14_FONT_ID, bookerly14FontFamily);
-#ifndef OMIT_FONTS
-  renderer.insertFont(BOOKERLY_12_FONT_ID, bookerly12FontFamily);
-  renderer.insertFont(BOOKERLY_16_FONT_ID, bookerly16FontFamily);
-  renderer.insertFont(BOOKERLY_18_FONT_ID, bookerly18FontFamily);
-
-  renderer.insertFont(NOTOSANS_12_FONT_ID, notosans12FontFamily);
-  renderer.insertFont(NOTOSANS_14_FONT_ID, notosans14FontFamily);
-  renderer.insertFont(NOTOSANS_16_FONT_ID, notosans16FontFamily);
-  renderer.insertFont(NOTOSANS_18_FONT_ID, notosans18FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_8_FONT_ID, opendyslexic8FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_10_FONT_ID, opendyslexic10FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_12_FONT_ID, opendyslexic12FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_14_FONT_ID, opendyslexic14FontFamily);
-#endif  // OMIT_FONTS
+  renderer.setFontResolver(&resolveReaderFont);
   renderer.insertFont(UI_10_FONT_ID, ui10FontFamily);
   renderer.insertFont(UI_12_FONT_ID, ui12FontFamily);
   renderer.insertFont(SMALL_FONT_ID, smallFontFamily);
   LOG_DBG("MAIN", "Fonts setup");
 }
 
+void setupDisplayAndFonts() {
+  setupDisplay();
+  setupFonts();
+}
+
 void setup() {
   t1 = millis();
 
@@ -241,6 +286,7 @@ void setup() {
       delay(10);
     }
   }
+  BootProfiler::mark("hal init");
 
   // SD Card Initialization
   // We need 6 open files concurrently when parsing a new chapter
@@ -250,17 +296,17 @@ void setup() {
     activityManager.goToFullScreenMessage("SD card error", EpdFontFamily::BOLD);
     return;
   }
+  BootProfiler::mark("sd mount");
 
   HalSystem::checkPanic();
   HalSystem::clearPanic();  // TODO: move this to an activity when we have one to display the panic info
 
+  // Settings are needed right away for the power button check
   SETTINGS.loadFromFile();
-  I18N.loadSettings();
-  KOREADER_STORE.loadFromFile();
-  UITheme::getInstance().reload();
-  ButtonNavigator::setMappedInputManager(mappedInputManager);
+  BootProfiler::mark("settings parse");
 
-  switch (gpio.getWakeupReason()) {
+  const auto wakeupReason = gpio.getWakeupReason();
+  switch (wakeupReason) {
     case HalGPIO::WakeupReason::PowerButton:
       // For normal wakeups, verify power button press duration
       LOG_DBG("MAIN", "Verifying power button press duration");
@@ -277,21 +323,46 @@ void setup() {
     default:
       break;
   }
+  BootProfiler::mark("power button check");
 
   // First serial output only here to avoid timing inconsistencies for power button press duration verification
   LOG_DBG("MAIN", "Starting CrossPoint version " CROSSPOINT_VERSION);
 
-  setupDisplayAndFonts();
-
-  activityManager.goToBoot();
-
+  setupDisplay();
+  BootProfiler::mark("display init");
   APP_STATE.loadFromFile();
-  RECENT_BOOKS.loadFromFile();
+  BootProfiler::mark("app state");
 
   // Boot to home screen if no book is open, last sleep was not from reader, back button is held, or reader activity
   // crashed (indicated by readerActivityLoadCount > 0)
-  if (APP_STATE.openEpubPath.empty() || !APP_STATE.lastSleepFromReader ||
-      mappedInputManager.isPressed(MappedInputManager::Button::Back) || APP_STATE.readerActivityLoadCount > 0) {
+  const bool resumeReader = !APP_STATE.openEpubPath.empty() && APP_STATE.lastSleepFromReader &&
+                            !mappedInputManager.isPressed(MappedInputManager::Button::Back) &&
+                            APP_STATE.readerActivityLoadCount == 0;
+
+  // Instant wake: put the page back on screen first, everything below is loaded while it is already visible
+  const bool frameRestored = resumeReader && wakeupReason == HalGPIO::WakeupReason::PowerButton &&
+                             ResumeFrame::restore(renderer, APP_STATE.openEpubPath);
+  if (frameRestored) {
+    BootProfiler::mark("resume frame");
+  }
+
+  // KOReader credentials and Wi-Fi credentials are loaded by the screens that use them
+  I18N.loadSettings();
+  UITheme::getInstance().reload();
+  ButtonNavigator::setMappedInputManager(mappedInputManager);
+  BootProfiler::mark("i18n and theme");
+  setupFonts();
+  BootProfiler::mark("font registration");
+
+  if (!frameRestored) {
+    activityManager.goToBoot();
+    BootProfiler::mark("boot screen");
+  }
+
+  RECENT_BOOKS.loadFromFile();
+  BootProfiler::mark("recent books");
+
+  if (!resumeReader) {
     activityManager.goHome();
   } else {
     // Clear app state to avoid getting into a boot loop if the epub doesn't load
@@ -301,6 +372,7 @@ void setup() {
     APP_STATE.saveToFile();
     activityManager.goToReader(path);
   }
+  BootProfiler::mark("activity start");
 
   // Ensure we're not still holding the power button before leaving setup
   waitForPowerRelease();
@@ -318,6 +390,8 @@ void loop() {
   if (Serial && millis() - lastMemPrint >= 10000) {
     LOG_INF("MEM", "Free: %d bytes, Total: %d bytes, Min Free: %d bytes, MaxAlloc: %d bytes", ESP.getFreeHeap(),
             ESP.getHeapSize(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+    ALLOC_TRACK_SNAPSHOT();
+    powerManager.logResidency();
     lastMemPrint = millis();
   }
 
@@ -333,6 +407,8 @@ void loop() {
         uint8_t* buf = display.getFrameBuffer();
         logSerial.write(buf, HalDisplay::BUFFER_SIZE);
         logSerial.printf("SCREENSHOT_END\n");
+      } else if (cmd == "TRACE") {
+        trace::dumpToSerial();
       }
     }
   }
@@ -1,16 +1,19 @@
 #include "CrossPointWebServer.h"
 
+#include <AllocTracker.h>
 #include <ArduinoJson.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <HalStorage.h>
 #include <Logging.h>
+#include <Trace.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
 
 #include <algorithm>
 
 #include "CrossPointSettings.h"
+#include "LibraryIndex.h"
 #include "SettingsList.h"
 #include "WebDAVHandler.h"
 #include "html/FilesPageHtml.generated.h"
@@ -89,6 +92,7 @@ CrossPointWebServer::CrossPointWebServer() {}
 CrossPointWebServer::~CrossPointWebServer() { stop(); }
 
 void CrossPointWebServer::begin() {
+  ALLOC_TAG(WebServer);
   if (running) {
     LOG_DBG("WEB", "Web server already running");
     return;
@@ -133,6 +137,7 @@ void CrossPointWebServer::begin() {
   server->on("/files", HTTP_GET, [this] { handleFileList(); });
 
   server->on("/api/status", HTTP_GET, [this] { handleStatus(); });
+  server->on("/api/trace", HTTP_GET, [this] { handleTrace(); });
   server->on("/api/files", HTTP_GET, [this] { handleFileListData(); });
   server->on("/download", HTTP_GET, [this] { handleDownload(); });
 
@@ -257,6 +262,7 @@ void CrossPointWebServer::handleClient() {
     lastDebugPrint = millis();
   }
 
+  ALLOC_TAG(WebServer);
   server->handleClient();
 
   // Handle WebSocket events
@@ -332,6 +338,31 @@ void CrossPointWebServer::handleStatus() const {
   server->send(200, "application/json", json);
 }
 
+void CrossPointWebServer::handleTrace() const {
+  auto* spans = static_cast<trace::Span*>(malloc(sizeof(trace::Span) * trace::RING_SIZE));
+  if (!spans) {
+    server->send(500, "text/plain", "Out of memory");
+    return;
+  }
+  const size_t count = trace::snapshot(spans, trace::RING_SIZE);
+
+  // Streamed like the file listing so the response never holds the whole ring as one string
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, "application/json", "");
+  char output[96];
+  snprintf(output, sizeof(output), "{\"now\":%u,\"spans\":[", static_cast<unsigned>(micros()));
+  server->sendContent(output);
+  for (size_t i = 0; i < count; i++) {
+    snprintf(output, sizeof(output), "%s{\"name\":\"%s\",\"start\":%u,\"duration\":%u}", i > 0 ? "," : "",
+             spans[i].name, static_cast<unsigned>(spans[i].startUs), static_cast<unsigned>(spans[i].durationUs));
+    server->sendContent(output);
+  }
+  server->sendContent("]}");
+  // End of streamed response, empty chunk to signal client
+  server->sendContent("");
+  free(spans);
+}
+
 void CrossPointWebServer::scanFiles(const char* path, const std::function<void(FileInfo)>& callback) const {
   FsFile root = Storage.open(path);
   if (!root) {
@@ -664,6 +695,7 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += state.fileName;
         clearEpubCacheIfNeeded(filePath);
+        LIBRARY_INDEX.addFile(filePath.c_str());
       }
     }
   } else if (upload.status == UPLOAD_FILE_ABORTED) {
@@ -815,6 +847,7 @@ void CrossPointWebServer::handleRename() const {
 
   if (success) {
     LOG_DBG("WEB", "Renamed file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.moveFile(itemPath.c_str(), newPath.c_str());
     server->send(200, "text/plain", "Renamed successfully");
   } else {
     LOG_ERR("WEB", "Failed to rename file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -908,6 +941,7 @@ void CrossPointWebServer::handleMove() const {
 
   if (success) {
     LOG_DBG("WEB", "Moved file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.moveFile(itemPath.c_str(), newPath.c_str());
     server->send(200, "text/plain", "Moved successfully");
   } else {
     LOG_ERR("WEB", "Failed to move file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -1002,11 +1036,17 @@ void CrossPointWebServer::handleDelete() const {
       }
       f.close();
       success = Storage.rmdir(itemPath.c_str());
+      if (success) {
+        LIBRARY_INDEX.removeDir(itemPath.c_str());
+      }
     } else {
       // It's a file (or couldn't open as dir) — remove file
       if (f) f.close();
       success = Storage.remove(itemPath.c_str());
       clearEpubCacheIfNeeded(itemPath);
+      if (success) {
+        LIBRARY_INDEX.removeFile(itemPath.c_str());
+      }
     }
 
     if (!success) {
@@ -1323,6 +1363,7 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += wsUploadFileName;
         clearEpubCacheIfNeeded(filePath);
+        LIBRARY_INDEX.addFile(filePath.c_str());
 
         wsServer->sendTXT(num, "DONE");
         lastProgressSent = 0;
@@ -91,6 +91,7 @@ class CrossPointWebServer {
   void handleRoot() const;
   void handleNotFound() const;
   void handleStatus() const;
+  void handleTrace() const;
   void handleFileList() const;
   void handleFileListData() const;
   void handleDownload() const;
@@ -0,0 +1,264 @@
+#include "BookIndexer.h"
+
+#include <Epub.h>
+#include <Epub/BookAnchorIndex.h>
+#include <Epub/FootnoteStore.h>
+#include <Epub/Page.h>
+#include <Epub/PageMap.h>
+#include <Epub/Section.h>
+#include <HalPowerManager.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <memory>
+
+#include "CacheManager.h"
+#include "CrossPointSettings.h"
+#include "activities/RenderLock.h"
+
+namespace {
+constexpr uint8_t INDEX_STATE_VERSION = 1;
+constexpr char indexStateFile[] = "/index.bin";
+// Pause between sections, leaves the CPU and SD card to the UI and keeps the device from running hot
+constexpr TickType_t SECTION_PAUSE_TICKS = pdMS_TO_TICKS(250);
+
+struct IndexState {
+  uint32_t layoutHash = 0;
+  uint16_t viewportWidth = 0;
+  uint16_t viewportHeight = 0;
+  uint16_t nextSpineIndex = 0;
+};
+
+bool readState(const std::string& cachePath, IndexState& state) {
+  FsFile file;
+  if (!Storage.openFileForRead("IDX", cachePath + indexStateFile, file)) {
+    return false;
+  }
+  uint8_t version;
+  serialization::readPod(file, version);
+  if (version != INDEX_STATE_VERSION) {
+    file.close();
+    return false;
+  }
+  serialization::readPod(file, state.layoutHash);
+  serialization::readPod(file, state.viewportWidth);
+  serialization::readPod(file, state.viewportHeight);
+  serialization::readPod(file, state.nextSpineIndex);
+  file.close();
+  return true;
+}
+
+bool writeState(const std::string& cachePath, const IndexState& state) {
+  FsFile file;
+  if (!Storage.openFileForWrite("IDX", cachePath + indexStateFile, file)) {
+    return false;
+  }
+  serialization::writePod(file, INDEX_STATE_VERSION);
+  serialization::writePod(file, state.layoutHash);
+  serialization::writePod(file, state.viewportWidth);
+  serialization::writePod(file, state.viewportHeight);
+  serialization::writePod(file, state.nextSpineIndex);
+  file.close();
+  return true;
+}
+
+class IndexerLock {
+ public:
+  explicit IndexerLock(SemaphoreHandle_t mutex) : mutex(mutex) { xSemaphoreTake(mutex, portMAX_DELAY); }
+  ~IndexerLock() { xSemaphoreGive(mutex); }
+
+  IndexerLock(const IndexerLock&) = delete;
+  IndexerLock& operator=(const IndexerLock&) = delete;
+
+ private:
+  SemaphoreHandle_t mutex;
+};
+}  // namespace
+
+BookIndexer BookIndexer::instance;
+
+BookIndexer::BookIndexer() { mutex = xSemaphoreCreateMutex(); }
+
+void BookIndexer::start(GfxRenderer& renderer, const std::string& epubPath) {
+  IndexerLock lock(mutex);
+  if (epubPath == finishedPath || (active && epubPath == jobPath)) {
+    return;
+  }
+  if (active) {
+    generation = generation + 1;  // another book: drop the current job
+  }
+  this->renderer = &renderer;
+  jobPath = epubPath;
+  active = true;
+
+  if (!taskHandle) {
+    // Below the UI tasks, so indexing only runs while they wait
+    xTaskCreate(&taskTrampoline, "BookIndexer", 8192, this, 0, &taskHandle);
+    if (!taskHandle) {
+      LOG_ERR("IDX", "Failed to create indexer task");
+      active = false;
+      return;
+    }
+  }
+  xTaskNotifyGive(taskHandle);
+}
+
+void BookIndexer::cancel() {
+  IndexerLock lock(mutex);
+  if (!active) {
+    return;
+  }
+  active = false;
+  generation = generation + 1;
+  LOG_DBG("IDX", "Indexing cancelled");
+}
+
+void BookIndexer::stop() {
+  cancel();
+  // The task only indexes while holding the render lock, and aborts as soon as it sees the cancel
+  RenderLock lock;
+}
+
+void BookIndexer::setLayout(const std::string& cachePath, const uint32_t layoutHash, const uint16_t viewportWidth,
+                            const uint16_t viewportHeight) {
+  IndexState state;
+  if (readState(cachePath, state) && state.layoutHash == layoutHash && state.viewportWidth == viewportWidth &&
+      state.viewportHeight == viewportHeight) {
+    return;
+  }
+  writeState(cachePath, {layoutHash, viewportWidth, viewportHeight, 0});
+
+  // The book has sections to build for the new layout
+  IndexerLock lock(mutex);
+  finishedPath.clear();
+}
+
+void BookIndexer::taskTrampoline(void* param) {
+  auto* self = static_cast<BookIndexer*>(param);
+  self->taskLoop();
+}
+
+void BookIndexer::taskLoop() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    std::string epubPath;
+    uint32_t jobGeneration;
+    {
+      IndexerLock lock(mutex);
+      if (!active) {
+        continue;
+      }
+      epubPath = jobPath;
+      jobGeneration = generation;
+    }
+
+    const bool finished = runJob(epubPath, jobGeneration);
+
+    IndexerLock lock(mutex);
+    if (generation == jobGeneration) {
+      active = false;
+      if (finished) {
+        finishedPath = epubPath;
+      }
+    }
+  }
+}
+
+bool BookIndexer::runJob(const std::string& epubPath, const uint32_t jobGeneration) {
+  const auto cancelled = [this, jobGeneration] { return generation != jobGeneration; };
+
+  std::shared_ptr<Epub> epub;
+  IndexState state;
+  PageMap pageMap;
+  uint32_t layoutHash;
+  {
+    RenderLock lock;
+    if (cancelled()) {
+      return false;
+    }
+    epub = std::make_shared<Epub>(epubPath, "/.crosspoint");
+    if (!epub->load(false, false) || !readState(epub->getCachePath(), state)) {
+      LOG_DBG("IDX", "%s hasn't been opened in the reader yet, nothing to index", epubPath.c_str());
+      return true;
+    }
+
+    layoutHash = Section::layoutHash(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                     SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment,
+                                     state.viewportWidth, state.viewportHeight, SETTINGS.hyphenationEnabled,
+                                     SETTINGS.embeddedStyle, SETTINGS.imageRendering);
+    if (layoutHash != state.layoutHash) {
+      // The viewport depends on settings too, only the reader knows it for the new layout
+      LOG_DBG("IDX", "Settings changed since %s was last read, waiting for the reader", epubPath.c_str());
+      return true;
+    }
+    if (state.nextSpineIndex >= epub->getSpineItemsCount()) {
+      return true;
+    }
+    pageMap.load(epub->getCachePath(), epub->getSpineItemsCount(), layoutHash);
+    LOG_INF("IDX", "Indexing %s from section %u", epubPath.c_str(), state.nextSpineIndex);
+  }
+
+  // The sections built grow the book's cache, CacheManager re-measures it once the job ends. Not under the render
+  // lock: walking the cache directory takes a while and a cancel means the UI is waiting for the lock.
+  const uint16_t firstSpineIndex = state.nextSpineIndex;
+  const auto measureCache = [&epub, &state, firstSpineIndex] {
+    if (state.nextSpineIndex > firstSpineIndex) {
+      CACHE_MANAGER.onBookClosed(epub->getCachePath());
+    }
+  };
+
+  const uint32_t startTime = millis();
+  bool stopped = false;
+  for (int i = state.nextSpineIndex; i < epub->getSpineItemsCount(); i++) {
+    {
+      RenderLock lock;
+      HalPowerManager::Lock powerLock;  // Keep the normal clock, the home screen idles in low-power mode
+      if (cancelled()) {
+        stopped = true;
+        break;
+      }
+
+      Section section(epub, i, *renderer);
+      if (!section.loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                   SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, state.viewportWidth,
+                                   state.viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
+                                   SETTINGS.imageRendering) &&
+          !section.createSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                     SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, state.viewportWidth,
+                                     state.viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
+                                     SETTINGS.imageRendering, nullptr, cancelled)) {
+        if (cancelled()) {
+          stopped = true;
+          break;
+        }
+        // Left to the reader, which reports the failure when the section is opened
+        LOG_ERR("IDX", "Failed to index section %d, skipping", i);
+      } else {
+        pageMap.setSectionPages(i, section.pageCount);
+        // Empty unless the section was just built
+        FootnoteStore::capture(*epub, i, section.getFootnoteHrefs(), cancelled);
+      }
+
+      state.nextSpineIndex = i + 1;
+      writeState(epub->getCachePath(), state);
+    }
+    vTaskDelay(SECTION_PAUSE_TICKS);
+  }
+  if (stopped) {
+    measureCache();
+    return false;
+  }
+
+  {
+    RenderLock lock;
+    // One merge for the whole book instead of one per section
+    BookAnchorIndex::merge(epub->getCachePath(), layoutHash, static_cast<uint16_t>(epub->getSpineItemsCount()));
+    FootnoteStore::merge(epub->getCachePath());
+  }
+  measureCache();
+
+  LOG_INF("IDX", "Indexed %s in %lu ms, %u pages", epubPath.c_str(), millis() - startTime, pageMap.getTotalPages());
+  return true;
+}
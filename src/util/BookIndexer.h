@@ -0,0 +1,53 @@
+#pragma once
+#include <GfxRenderer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <string>
+
+/*
+Indexes every section of a book in a background task, so reading it later never stops to build a section and the page
+map ends up complete.
+
+Sections are built for the layout the reader last used on the book (see setLayout()), one at a time under the render
+lock since they share the SD card, fonts and the parse arena with rendering. The task pauses between sections and the
+next section to index is kept in <cache>/index.bin, so the job resumes where it stopped after a cancel or a sleep.
+*/
+class BookIndexer {
+ public:
+  BookIndexer();
+
+  // Starts indexing the book, or resumes it. No-op while it's already running or once it finished this session.
+  void start(GfxRenderer& renderer, const std::string& epubPath);
+  // Stops the job within one parse buffer. The task won't touch the SD card again once the caller holds the render
+  // lock, so this may be called with or without it.
+  void cancel();
+  // cancel(), then waits for the section in flight to be dropped. Must NOT be called while holding a RenderLock.
+  // ActivityManager calls it before every onEnter().
+  void stop();
+  bool isRunning() const { return active; }
+
+  // Records the layout the reader builds sections for; the job indexes the rest of the book with it
+  void setLayout(const std::string& cachePath, uint32_t layoutHash, uint16_t viewportWidth, uint16_t viewportHeight);
+
+  static BookIndexer& getInstance() { return instance; }
+
+ private:
+  static BookIndexer instance;
+
+  SemaphoreHandle_t mutex = nullptr;  // guards jobPath, finishedPath and renderer
+  TaskHandle_t taskHandle = nullptr;
+  GfxRenderer* renderer = nullptr;
+  std::string jobPath;
+  std::string finishedPath;  // last book indexed to the end (or found unindexable), not retried
+  volatile bool active = false;
+  volatile uint32_t generation = 0;  // bumped by cancel(), a job stops once it changes
+
+  static void taskTrampoline(void* param);
+  [[noreturn]] void taskLoop();
+  // Returns false when cancelled, true when there is nothing left to do for this book
+  bool runJob(const std::string& epubPath, uint32_t jobGeneration);
+};
+
+#define BOOK_INDEXER BookIndexer::getInstance()
@@ -0,0 +1,34 @@
+#include "BootProfiler.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+
+BootProfiler::Phase BootProfiler::phases[MAX_PHASES] = {};
+size_t BootProfiler::phaseCount = 0;
+uint32_t BootProfiler::lastMarkMs = 0;
+bool BootProfiler::finished = false;
+
+void BootProfiler::mark(const char* phase) {
+  if (finished) {
+    return;
+  }
+  const uint32_t now = millis();
+  phases[phaseCount % MAX_PHASES] = {phase, now, now - lastMarkMs};
+  phaseCount++;
+  lastMarkMs = now;
+}
+
+void BootProfiler::finish() {
+  if (finished) {
+    return;
+  }
+  mark("first render");
+  finished = true;
+
+  const size_t first = phaseCount > MAX_PHASES ? phaseCount - MAX_PHASES : 0;
+  for (size_t i = first; i < phaseCount; i++) {
+    const Phase& phase = phases[i % MAX_PHASES];
+    LOG_INF("BOOT", "%-20s %5u ms (at %u ms)", phase.name, phase.durationMs, phase.endMs);
+  }
+  LOG_INF("BOOT", "Boot to first screen: %u ms", lastMarkMs);
+}
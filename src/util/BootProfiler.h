@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Records how long each boot phase takes (time since the previous mark) in a small ring buffer, and logs the whole
+// boot once the first screen has been rendered.
+class BootProfiler {
+ public:
+  // phase must be a string literal, only the pointer is kept
+  static void mark(const char* phase);
+  // Marks the first completed render and logs all phases; later calls do nothing
+  static void finish();
+
+ private:
+  struct Phase {
+    const char* name;
+    uint32_t endMs;
+    uint32_t durationMs;
+  };
+  static constexpr size_t MAX_PHASES = 16;
+
+  static Phase phases[MAX_PHASES];
+  static size_t phaseCount;  // total marks, the ring keeps the last MAX_PHASES
+  static uint32_t lastMarkMs;
+  static bool finished;
+};
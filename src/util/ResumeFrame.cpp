@@ -0,0 +1,109 @@
+#include "ResumeFrame.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+#include <PackBits.h>
+#include <Serialization.h>
+
+#include <cstdlib>
+
+namespace {
+constexpr uint8_t RESUME_FILE_VERSION = 1;
+constexpr char RESUME_FILE[] = "/.crosspoint/resume.bin";
+// Frames that don't pack below this (image-heavy pages) are not worth the SD time; the reader renders them instead
+constexpr size_t MAX_PACKED_SIZE = 24 * 1024;
+}  // namespace
+
+bool ResumeFrame::save(const GfxRenderer& renderer, const std::string& bookPath) {
+  const unsigned long start = millis();
+  auto* packed = static_cast<uint8_t*>(malloc(MAX_PACKED_SIZE));
+  if (!packed) {
+    LOG_ERR("RSM", "Failed to allocate %zu bytes for resume frame", MAX_PACKED_SIZE);
+    discard();
+    return false;
+  }
+
+  const uint32_t packedSize =
+      packbits::encode(renderer.getFrameBuffer(), GfxRenderer::getBufferSize(), packed, MAX_PACKED_SIZE);
+  if (packedSize == 0) {
+    LOG_DBG("RSM", "Frame does not pack below %zu bytes, not saving it", MAX_PACKED_SIZE);
+    free(packed);
+    discard();
+    return false;
+  }
+
+  Storage.mkdir("/.crosspoint");
+  FsFile file;
+  if (!Storage.openFileForWrite("RSM", RESUME_FILE, file)) {
+    free(packed);
+    return false;
+  }
+  serialization::writePod(file, RESUME_FILE_VERSION);
+  serialization::writeString(file, bookPath);
+  serialization::writePod(file, packedSize);
+  const bool ok = file.write(packed, packedSize) == packedSize;
+  file.close();
+  free(packed);
+
+  if (!ok) {
+    LOG_ERR("RSM", "Failed to write resume frame");
+    discard();
+    return false;
+  }
+  LOG_DBG("RSM", "Saved resume frame (%u bytes) in %lu ms", packedSize, millis() - start);
+  return true;
+}
+
+bool ResumeFrame::restore(GfxRenderer& renderer, const std::string& bookPath) {
+  const unsigned long start = millis();
+  FsFile file;
+  if (!Storage.openFileForRead("RSM", RESUME_FILE, file)) {
+    return false;
+  }
+
+  uint8_t version;
+  std::string savedPath;
+  uint32_t packedSize = 0;
+  serialization::readPod(file, version);
+  if (version == RESUME_FILE_VERSION) {
+    serialization::readString(file, savedPath);
+    serialization::readPod(file, packedSize);
+  }
+  if (version != RESUME_FILE_VERSION || savedPath != bookPath || packedSize == 0 || packedSize > MAX_PACKED_SIZE) {
+    LOG_DBG("RSM", "Resume frame does not match, skipping");
+    file.close();
+    discard();
+    return false;
+  }
+
+  auto* packed = static_cast<uint8_t*>(malloc(packedSize));
+  if (!packed) {
+    LOG_ERR("RSM", "Failed to allocate %u bytes for resume frame", packedSize);
+    file.close();
+    discard();
+    return false;
+  }
+  const bool readOk = file.read(packed, packedSize) == static_cast<int>(packedSize);
+  file.close();
+  discard();
+
+  // Decode straight into the frame buffer; a short or corrupt file leaves it to the normal boot screen
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  const size_t unpacked = readOk ? packbits::decode(packed, packedSize, frameBuffer, GfxRenderer::getBufferSize()) : 0;
+  free(packed);
+  if (unpacked != GfxRenderer::getBufferSize()) {
+    LOG_ERR("RSM", "Resume frame is truncated");
+    renderer.clearScreen();
+    return false;
+  }
+
+  renderer.displayBuffer();
+  LOG_DBG("RSM", "Resume frame shown in %lu ms", millis() - start);
+  return true;
+}
+
+void ResumeFrame::discard() {
+  if (Storage.exists(RESUME_FILE)) {
+    Storage.remove(RESUME_FILE);
+  }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <GfxRenderer.h>
+
+#include <string>
+
+// Instant wake: the reader page on screen at sleep time is saved PackBits-compressed to the SD card, and put back with
+// a single fast refresh on power-button wake, before fonts, theme and the book are loaded.
+class ResumeFrame {
+ public:
+  // Save the current frame buffer for the book at bookPath
+  static bool save(const GfxRenderer& renderer, const std::string& bookPath);
+  // Show the saved frame if it belongs to bookPath. The file is consumed either way, so a frame is shown at most once.
+  static bool restore(GfxRenderer& renderer, const std::string& bookPath);
+  static void discard();
+};
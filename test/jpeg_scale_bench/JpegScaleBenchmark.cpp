@@ -0,0 +1,193 @@
+#include <picojpeg.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Host benchmark for picojpeg's DCT-domain scaling (PJPG_REDUCE_*), as used by JpegToBmpConverter for covers
+// and thumbnails. Each sample is decoded to grayscale at full, 1/2, 1/4 and 1/8 scale; the reduced outputs are
+// compared against a box-filtered full decode.
+
+struct MemoryReader {
+  const std::vector<uint8_t>* data;
+  size_t pos;
+};
+
+unsigned char readCallback(unsigned char* pBuf, unsigned char bufSize, unsigned char* pBytesRead, void* pData) {
+  auto* reader = static_cast<MemoryReader*>(pData);
+  const size_t remaining = reader->data->size() - reader->pos;
+  const size_t toRead = std::min(remaining, static_cast<size_t>(bufSize));
+  std::copy_n(reader->data->begin() + static_cast<std::ptrdiff_t>(reader->pos), toRead, pBuf);
+  reader->pos += toRead;
+  *pBytesRead = static_cast<unsigned char>(toRead);
+  return 0;
+}
+
+struct GrayImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+struct ScaleMode {
+  const char* name;
+  unsigned char reduce;
+  int shift;
+};
+
+const ScaleMode kModes[] = {
+    {"1/1", PJPG_REDUCE_NONE, 0},
+    {"1/2", PJPG_REDUCE_HALF, 1},
+    {"1/4", PJPG_REDUCE_QUARTER, 2},
+    {"1/8", PJPG_REDUCE_EIGHTH, 3},
+};
+
+// Mirrors the MCU walk in JpegToBmpConverter: blocks at 64-byte offsets, row stride 8, blockSize valid pixels
+bool decodeGray(const std::vector<uint8_t>& data, const ScaleMode& mode, GrayImage& out, size_t& mcuRowBytes) {
+  MemoryReader reader{&data, 0};
+  pjpeg_image_info_t info;
+  if (pjpeg_decode_init(&info, readCallback, &reader, 0) != 0) return false;
+  if (pjpeg_decode_set_reduce(mode.reduce) != 0) return false;
+
+  const int shift = mode.shift;
+  const int blockSize = 8 >> shift;
+  const int mcuWidth = info.m_MCUWidth >> shift;
+  const int mcuHeight = info.m_MCUHeight >> shift;
+  out.width = (info.m_width + (1 << shift) - 1) >> shift;
+  out.height = (info.m_height + (1 << shift) - 1) >> shift;
+  out.pixels.assign(static_cast<size_t>(out.width) * out.height, 0);
+  mcuRowBytes = static_cast<size_t>(out.width) * mcuHeight;
+
+  for (int mcuY = 0; mcuY < info.m_MCUSPerCol; mcuY++) {
+    for (int mcuX = 0; mcuX < info.m_MCUSPerRow; mcuX++) {
+      if (pjpeg_decode_mcu() != 0) return false;
+
+      for (int by = 0; by < mcuHeight; by++) {
+        const int py = mcuY * mcuHeight + by;
+        if (py >= out.height) break;
+        for (int bx = 0; bx < mcuWidth; bx++) {
+          const int px = mcuX * mcuWidth + bx;
+          if (px >= out.width) break;
+          const int blockIndex = (by / blockSize) * (mcuWidth / blockSize) + bx / blockSize;
+          const int offset = blockIndex * 64 + (by % blockSize) * 8 + bx % blockSize;
+          uint8_t gray = info.m_pMCUBufR[offset];
+          if (info.m_comps != 1) {
+            gray = (info.m_pMCUBufR[offset] * 25 + info.m_pMCUBufG[offset] * 50 + info.m_pMCUBufB[offset] * 25) / 100;
+          }
+          out.pixels[static_cast<size_t>(py) * out.width + px] = gray;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+GrayImage boxDownsample(const GrayImage& src, int shift) {
+  GrayImage dst;
+  const int factor = 1 << shift;
+  dst.width = (src.width + factor - 1) / factor;
+  dst.height = (src.height + factor - 1) / factor;
+  dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height);
+  for (int y = 0; y < dst.height; y++) {
+    for (int x = 0; x < dst.width; x++) {
+      int sum = 0;
+      int count = 0;
+      for (int sy = y * factor; sy < std::min(src.height, (y + 1) * factor); sy++) {
+        for (int sx = x * factor; sx < std::min(src.width, (x + 1) * factor); sx++) {
+          sum += src.pixels[static_cast<size_t>(sy) * src.width + sx];
+          count++;
+        }
+      }
+      dst.pixels[static_cast<size_t>(y) * dst.width + x] = static_cast<uint8_t>(sum / count);
+    }
+  }
+  return dst;
+}
+
+double psnr(const GrayImage& a, const GrayImage& b) {
+  if (a.width != b.width || a.height != b.height) return 0.0;
+  double mse = 0.0;
+  for (size_t i = 0; i < a.pixels.size(); i++) {
+    const double d = static_cast<double>(a.pixels[i]) - b.pixels[i];
+    mse += d * d;
+  }
+  mse /= static_cast<double>(a.pixels.size());
+  return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> files;
+  int iterations = 3;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::max(1, std::stoi(argv[++i]));
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty()) {
+    std::cerr << "Usage: JpegScaleBenchmark [--iterations N] <file.jpg>...\n";
+    return 1;
+  }
+
+  bool failed = false;
+  for (const auto& path : files) {
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.empty()) {
+      std::cerr << "Cannot read " << path << "\n";
+      failed = true;
+      continue;
+    }
+
+    std::cout << path << "\n";
+    std::cout << "  scale   output       ms/decode  speedup  mcu-row-bytes  psnr-vs-box\n";
+
+    GrayImage full;
+    double fullMs = 0.0;
+    for (const auto& mode : kModes) {
+      GrayImage image;
+      size_t mcuRowBytes = 0;
+      const auto start = std::chrono::steady_clock::now();
+      bool ok = true;
+      for (int i = 0; i < iterations && ok; i++) {
+        ok = decodeGray(data, mode, image, mcuRowBytes);
+      }
+      const double ms =
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+      if (!ok) {
+        std::cout << "  " << mode.name << "   decode failed\n";
+        failed = true;
+        continue;
+      }
+
+      std::string quality = "-";
+      if (mode.shift == 0) {
+        full = image;
+        fullMs = ms;
+      } else if (!full.pixels.empty()) {
+        std::ostringstream value;
+        value << std::fixed << std::setprecision(1) << psnr(image, boxDownsample(full, mode.shift)) << " dB";
+        quality = value.str();
+      }
+
+      std::ostringstream size;
+      size << image.width << "x" << image.height;
+      std::cout << "  " << std::left << std::setw(8) << mode.name << std::setw(13) << size.str() << std::right
+                << std::fixed << std::setprecision(1) << std::setw(9) << ms << std::setw(8)
+                << (ms > 0.0 ? fullMs / ms : 0.0) << "x" << std::setw(15) << mcuRowBytes << "  " << quality << "\n";
+    }
+  }
+
+  return failed ? 1 : 0;
+}
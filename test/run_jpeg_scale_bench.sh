@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/jpeg_scale_bench"
+BINARY="$BUILD_DIR/JpegScaleBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+CFLAGS=(
+  -O2
+  -I"$ROOT_DIR/lib/picojpeg"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR/lib/picojpeg"
+)
+
+cc "${CFLAGS[@]}" -c "$ROOT_DIR/lib/picojpeg/picojpeg.c" -o "$BUILD_DIR/picojpeg.o"
+c++ "${CXXFLAGS[@]}" "$ROOT_DIR/test/jpeg_scale_bench/JpegScaleBenchmark.cpp" "$BUILD_DIR/picojpeg.o" -o "$BINARY"
+
+# Default to the large photos shipped in docs/ (2000x2000 up to ~3200x5200)
+if [ "$#" -eq 0 ]; then
+  set -- "$ROOT_DIR"/docs/images/cover.jpg "$ROOT_DIR"/docs/images/comparison/*.jpg "$ROOT_DIR"/docs/images/wifi/*.jpeg
+fi
+
+"$BINARY" "$@"